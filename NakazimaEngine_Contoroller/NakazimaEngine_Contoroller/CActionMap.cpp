@@ -0,0 +1,190 @@
+#include "CActionMap.h"
+#include "PadButtons.h"
+
+namespace
+{
+    // 評価中のみ：前回の評価で押されていた
+    const BYTE STATE_OLD_PRESS = 0x10;
+
+    // パッドのアナログ入力の値（スティックは処理後の値）
+    float GetPadAxis(const InputFrame& input, int pad, DWORD axis)
+    {
+        switch (axis)
+        {
+        case ACTION_AXIS_THUMB_LX: return input.thumbs[pad][0];
+        case ACTION_AXIS_THUMB_LY: return input.thumbs[pad][1];
+        case ACTION_AXIS_THUMB_RX: return input.thumbs[pad][2];
+        case ACTION_AXIS_THUMB_RY: return input.thumbs[pad][3];
+        case ACTION_AXIS_LEFT_TRIGGER: return input.pads[pad].bLeftTrigger / 255.0f;
+        case ACTION_AXIS_RIGHT_TRIGGER: return input.pads[pad].bRightTrigger / 255.0f;
+        default: return 0.0f;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// コンストラクタ
+//------------------------------------------------------------------------------
+CActionMap::CActionMap()
+    : m_contextDepth(0)
+    , m_dirty(false)
+    , m_steady(false)
+{
+    ZeroMemory(m_contexts, sizeof(m_contexts));
+    ZeroMemory(m_state, sizeof(m_state));
+    ZeroMemory(m_value, sizeof(m_value));
+}
+
+//------------------------------------------------------------------------------
+// コンテキストのスタック操作
+//------------------------------------------------------------------------------
+bool CActionMap::PushContext(const ActionBinding* bindings, int count, bool blocking)
+{
+    if (m_contextDepth >= MAX_CONTEXT_DEPTH)
+        return false;
+
+    Context& context = m_contexts[m_contextDepth++];
+    context.bindings = bindings;
+    context.count = count;
+    context.blocking = blocking;
+    m_dirty = true;
+    return true;
+}
+
+void CActionMap::PopContext()
+{
+    if (m_contextDepth == 0)
+        return;
+
+    --m_contextDepth;
+    m_dirty = true;
+}
+
+void CActionMap::ClearContexts()
+{
+    m_contextDepth = 0;
+    m_dirty = true;
+}
+
+int CActionMap::GetContextDepth() const
+{
+    return m_contextDepth;
+}
+
+//------------------------------------------------------------------------------
+// 有効な割り当ての表を作り直す
+// 上のコンテキストから順に、blocking のコンテキストまでを集める
+//------------------------------------------------------------------------------
+void CActionMap::Compile()
+{
+    m_keyBindings.clear();
+    m_buttonBindings.clear();
+    m_axisBindings.clear();
+
+    for (int c = m_contextDepth - 1; c >= 0; --c)
+    {
+        const Context& context = m_contexts[c];
+        for (int i = 0; i < context.count; ++i)
+        {
+            const ActionBinding& binding = context.bindings[i];
+            if (binding.action >= MAX_ACTION_COUNT || binding.pad >= XUSER_MAX_COUNT)
+                continue;
+
+            switch (binding.device)
+            {
+            case ACTION_DEVICE_KEY:
+                if (binding.code < static_cast<DWORD>(CKeyBitset::KEY_COUNT))
+                    m_keyBindings.push_back(binding);
+                break;
+            case ACTION_DEVICE_PAD_BUTTON:
+                m_buttonBindings.push_back(binding);
+                break;
+            case ACTION_DEVICE_PAD_AXIS:
+                m_axisBindings.push_back(binding);
+                break;
+            }
+        }
+
+        if (context.blocking)
+            break;
+    }
+    m_dirty = false;
+}
+
+//------------------------------------------------------------------------------
+// 割り当ての評価
+// 表を1回ずつなめて、アクションごとの押下・値を積算する
+// 割り当てた入力がフレーム内で押して離された場合も Trigger / Release が立つ
+// 入力も割り当ても変わらず、前回の結果にエッジがなければ、評価し直しても同じなので何もしない
+//------------------------------------------------------------------------------
+void CActionMap::Evaluate(const InputFrame& input, bool inputChanged)
+{
+    if (!inputChanged && !m_dirty && m_steady)
+        return;
+    if (m_dirty)
+        Compile();
+
+    for (int a = 0; a < MAX_ACTION_COUNT; ++a)
+    {
+        m_state[a] = (m_state[a] & STATE_PRESS) ? STATE_OLD_PRESS : 0;
+        m_value[a] = 0.0f;
+    }
+
+    //--- キー ---
+    for (const ActionBinding& binding : m_keyBindings)
+    {
+        int key = static_cast<int>(binding.code);
+        if (input.keys.Test(key))
+        {
+            m_state[binding.action] |= STATE_PRESS;
+            m_value[binding.action] += binding.scale;
+        }
+        if (input.keyTrigger.Test(key))
+            m_state[binding.action] |= STATE_SOURCE_TRIGGER;
+    }
+
+    //--- パッドのボタン ---
+    for (const ActionBinding& binding : m_buttonBindings)
+    {
+        if (input.padButtons[binding.pad] & binding.code)
+        {
+            m_state[binding.action] |= STATE_PRESS;
+            m_value[binding.action] += binding.scale;
+        }
+        if (input.padTrigger[binding.pad] & binding.code)
+            m_state[binding.action] |= STATE_SOURCE_TRIGGER;
+    }
+
+    //--- パッドのアナログ入力 ---
+    for (const ActionBinding& binding : m_axisBindings)
+    {
+        float value = GetPadAxis(input, binding.pad, binding.code) * binding.scale;
+        m_value[binding.action] += value;
+        if (value >= ACTION_AXIS_PRESS_THRESHOLD)
+            m_state[binding.action] |= STATE_PRESS;
+    }
+
+    //--- エッジと値の範囲 ---
+    m_steady = true;
+    for (int a = 0; a < MAX_ACTION_COUNT; ++a)
+    {
+        BYTE state = m_state[a];
+        bool press = (state & STATE_PRESS) != 0;
+        bool oldPress = (state & STATE_OLD_PRESS) != 0;
+        bool sourceTrigger = (state & STATE_SOURCE_TRIGGER) != 0;
+
+        BYTE result = press ? STATE_PRESS : 0;
+        if (!oldPress && (press || sourceTrigger))
+            result |= STATE_TRIGGER;
+        if (!press && (oldPress || sourceTrigger))
+            result |= STATE_RELEASE;
+        m_state[a] = result;
+        if (result & (STATE_TRIGGER | STATE_RELEASE))
+            m_steady = false;
+
+        if (m_value[a] > 1.0f)
+            m_value[a] = 1.0f;
+        else if (m_value[a] < -1.0f)
+            m_value[a] = -1.0f;
+    }
+}
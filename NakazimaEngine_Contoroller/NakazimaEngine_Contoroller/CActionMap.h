@@ -0,0 +1,136 @@
+#pragma once
+#include <windows.h>
+#include <Xinput.h>
+#include <vector>
+#include "CInputRecording.h"
+
+//------------------------------------------------------------------------------
+// 割り当てる入力の種類
+//------------------------------------------------------------------------------
+enum ActionDevice : BYTE
+{
+    ACTION_DEVICE_KEY,          // キー（code = 仮想キーコード）
+    ACTION_DEVICE_PAD_BUTTON,   // パッドのボタン（code = ボタンワードのビット、仮想ボタンも可）
+    ACTION_DEVICE_PAD_AXIS,     // パッドのアナログ入力（code = ActionPadAxis）
+};
+
+// ACTION_DEVICE_PAD_AXIS の code
+enum ActionPadAxis : BYTE
+{
+    ACTION_AXIS_THUMB_LX,       // 左スティック（-1.0f ~ 1.0f）
+    ACTION_AXIS_THUMB_LY,
+    ACTION_AXIS_THUMB_RX,       // 右スティック（-1.0f ~ 1.0f）
+    ACTION_AXIS_THUMB_RY,
+    ACTION_AXIS_LEFT_TRIGGER,   // トリガー（0.0f ~ 1.0f）
+    ACTION_AXIS_RIGHT_TRIGGER,
+};
+
+//------------------------------------------------------------------------------
+// ActionBinding
+// アクション1つに入力1つを割り当てる
+//   value  : 押している間（アナログ入力は入力値に）scale を掛けた値がアクションの値に加算される
+//   press  : デジタル入力は押している間、アナログ入力は 入力値 × scale が
+//            ACTION_AXIS_PRESS_THRESHOLD 以上の間
+// constexpr の配列にできるので、固定の割り当ては静的なテーブルとして書ける
+//   例：constexpr ActionBinding bindings[] = { BindKey(MOVE_LEFT, 'A'), ... };
+//------------------------------------------------------------------------------
+struct ActionBinding
+{
+    WORD action;    // アクション番号（0 ~ CActionMap::MAX_ACTION_COUNT-1）
+    BYTE device;    // ActionDevice
+    BYTE pad;       // パッドのスロット番号
+    DWORD code;     // キーコード / ボタンのビット / ActionPadAxis
+    float scale;    // 値に掛ける係数（負にすると逆方向）
+};
+
+const float ACTION_AXIS_PRESS_THRESHOLD = 0.5f;
+
+constexpr ActionBinding BindKey(int action, BYTE key, float scale = 1.0f)
+{
+    return ActionBinding{ static_cast<WORD>(action), ACTION_DEVICE_KEY, 0, key, scale };
+}
+
+constexpr ActionBinding BindPadButton(int action, DWORD button, float scale = 1.0f, int pad = 0)
+{
+    return ActionBinding{ static_cast<WORD>(action), ACTION_DEVICE_PAD_BUTTON, static_cast<BYTE>(pad), button, scale };
+}
+
+constexpr ActionBinding BindPadAxis(int action, ActionPadAxis axis, float scale = 1.0f, int pad = 0)
+{
+    return ActionBinding{ static_cast<WORD>(action), ACTION_DEVICE_PAD_AXIS, static_cast<BYTE>(pad), axis, scale };
+}
+
+//------------------------------------------------------------------------------
+// CActionMap
+// 名前付きのアクション（移動・決定など）に入力を割り当て、Update ごとに1回だけ評価する
+// ゲーム側は入力ごとの問い合わせをせず、評価済みのアクションの状態を配列から読む
+//
+// 割り当てはコンテキスト（ゲーム中・メニュー等）単位でスタックに積む
+// blocking のコンテキストより下は評価しない（メニューを開いている間は移動しない等）
+// スタックが変わったときだけ、有効な割り当てを入力の種類ごとの平らな表にまとめ直す
+//------------------------------------------------------------------------------
+class CActionMap
+{
+public:
+    static const int MAX_ACTION_COUNT = 64;
+    static const int MAX_CONTEXT_DEPTH = 8;
+
+    CActionMap();
+
+    //--------------------------------------
+    // コンテキスト
+    // bindings は積んでいる間そのまま参照するので、静的なテーブル等を渡すこと
+    //--------------------------------------
+    bool PushContext(const ActionBinding* bindings, int count, bool blocking = false);
+    template<size_t N>
+    bool PushContext(const ActionBinding (&bindings)[N], bool blocking = false)
+    {
+        return PushContext(bindings, static_cast<int>(N), blocking);
+    }
+    void PopContext();
+    void ClearContexts();
+    int GetContextDepth() const;
+
+    // 割り当てを評価する（CInputManager::Update から呼ばれる）
+    // inputChanged = false なら、input は前回の Evaluate と同じ（エッジなし）とみなしてよい
+    void Evaluate(const InputFrame& input, bool inputChanged = true);
+
+    //--------------------------------------
+    // アクションの状態
+    //--------------------------------------
+    bool IsPress(int action) const { return (m_state[action] & STATE_PRESS) != 0; }
+    bool IsTrigger(int action) const { return (m_state[action] & STATE_TRIGGER) != 0; }
+    bool IsRelease(int action) const { return (m_state[action] & STATE_RELEASE) != 0; }
+    float GetValue(int action) const { return m_value[action]; }   // -1.0f ~ 1.0f
+
+private:
+    enum : BYTE
+    {
+        STATE_PRESS = 0x01,
+        STATE_TRIGGER = 0x02,
+        STATE_RELEASE = 0x04,
+        STATE_SOURCE_TRIGGER = 0x08,    // 評価中のみ：割り当てた入力のどれかが押された
+    };
+
+    struct Context
+    {
+        const ActionBinding* bindings;
+        int count;
+        bool blocking;
+    };
+
+    // 有効なコンテキストの割り当てを、入力の種類ごとの表にまとめる
+    void Compile();
+
+    Context m_contexts[MAX_CONTEXT_DEPTH];
+    int m_contextDepth;
+    bool m_dirty;                               // スタックが変わって表を作り直す必要がある
+    bool m_steady;                              // 前回の結果にエッジがない（同じ入力なら評価しても変わらない）
+
+    std::vector<ActionBinding> m_keyBindings;   // 有効な割り当て（入力の種類ごと）
+    std::vector<ActionBinding> m_buttonBindings;
+    std::vector<ActionBinding> m_axisBindings;
+
+    BYTE m_state[MAX_ACTION_COUNT];             // STATE_* の組み合わせ
+    float m_value[MAX_ACTION_COUNT];
+};
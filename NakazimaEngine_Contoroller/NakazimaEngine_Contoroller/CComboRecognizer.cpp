@@ -0,0 +1,271 @@
+#include "CComboRecognizer.h"
+#include "PadButtons.h"
+
+//------------------------------------------------------------------------------
+// コンストラクタ
+//------------------------------------------------------------------------------
+CComboRecognizer::CComboRecognizer()
+    : m_frame(0)
+    , m_direction(5)
+    , m_facingLeft(false)
+{
+    Clear();
+}
+
+//------------------------------------------------------------------------------
+// コマンドの登録
+// 先頭から同じ手が続く間は既存の節をたどり、分かれたところから節を追加する
+//------------------------------------------------------------------------------
+int CComboRecognizer::AddPattern(const ComboStep* steps, int count, int windowFrames)
+{
+    if (count <= 0)
+        return -1;
+    for (int i = 0; i < count; ++i)
+    {
+        if (steps[i].direction > 9 || (steps[i].direction == 0 && steps[i].buttons == 0))
+            return -1;
+    }
+
+    int node = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const ComboStep& step = steps[i];
+        std::vector<int>& children = (node != 0) ? m_nodes[node].children
+            : (step.buttons ? m_rootByButton : m_rootByDirection[step.direction]);
+
+        int next = -1;
+        for (int child : children)
+        {
+            const ComboStep& s = m_nodes[child].step;
+            if (s.direction == step.direction && s.buttons == step.buttons)
+            {
+                next = child;
+                break;
+            }
+        }
+
+        if (next < 0)
+        {
+            next = static_cast<int>(m_nodes.size());
+            children.push_back(next);   // m_nodes を伸ばす前に追加する（参照が無効になるため）
+            Node added;
+            added.step = step;
+            added.window = 0;
+            m_nodes.push_back(added);
+            m_childDirections.push_back(0);
+            m_childButtons.push_back(0);
+            m_activeStart.push_back(0);
+            m_activeIndex.push_back(-1);
+
+            if (step.buttons)
+                m_childButtons[node] |= step.buttons;
+            else
+                m_childDirections[node] |= static_cast<WORD>(1 << step.direction);
+        }
+
+        if (m_nodes[next].window < windowFrames)
+            m_nodes[next].window = windowFrames;
+        node = next;
+    }
+
+    int pattern = static_cast<int>(m_patternWindow.size());
+    m_nodes[node].patterns.push_back(pattern);
+    m_patternWindow.push_back(windowFrames);
+    m_matched.push_back(0);
+    return pattern;
+}
+
+//------------------------------------------------------------------------------
+// 登録したコマンドをすべて削除
+//------------------------------------------------------------------------------
+void CComboRecognizer::Clear()
+{
+    m_nodes.clear();
+    m_childDirections.clear();
+    m_childButtons.clear();
+    for (std::vector<int>& children : m_rootByDirection)
+        children.clear();
+    m_rootByButton.clear();
+    m_patternWindow.clear();
+    m_active.clear();
+    m_activeStart.clear();
+    m_activeIndex.clear();
+    m_stepping.clear();
+    m_matched.clear();
+    m_matches.clear();
+
+    // 根
+    Node root;
+    root.step = ComboStep{ 0, 0 };
+    root.window = 0;
+    m_nodes.push_back(root);
+    m_childDirections.push_back(0);
+    m_childButtons.push_back(0);
+    m_activeStart.push_back(0);
+    m_activeIndex.push_back(-1);
+}
+
+//------------------------------------------------------------------------------
+// 入力途中のコマンドを捨てる
+//------------------------------------------------------------------------------
+void CComboRecognizer::Reset()
+{
+    for (int node : m_active)
+        m_activeIndex[node] = -1;
+    m_active.clear();
+
+    for (int pattern : m_matches)
+        m_matched[pattern] = 0;
+    m_matches.clear();
+}
+
+void CComboRecognizer::SetFacingLeft(bool facingLeft)
+{
+    m_facingLeft = facingLeft;
+}
+
+//------------------------------------------------------------------------------
+// パッドの方向と、このフレームで押されたボタンで進める
+//------------------------------------------------------------------------------
+void CComboRecognizer::Update(const InputFrame& input, int pad)
+{
+    Advance(GetPadDirection(input.pads[pad]), input.padTrigger[pad]);
+}
+
+//------------------------------------------------------------------------------
+// 1フレーム分進める
+// 方向が変わったら方向の手を、ボタンが押されたらボタンの手を、この順に調べる
+//------------------------------------------------------------------------------
+void CComboRecognizer::Advance(int direction, DWORD triggers)
+{
+    ++m_frame;
+
+    for (int pattern : m_matches)
+        m_matched[pattern] = 0;
+    m_matches.clear();
+
+    // 受付フレーム数を過ぎたものを捨てる
+    for (size_t i = 0; i < m_active.size();)
+    {
+        int node = m_active[i];
+        if (m_frame - m_activeStart[node] > static_cast<DWORD>(m_nodes[node].window))
+        {
+            m_active[i] = m_active.back();
+            m_activeIndex[m_active[i]] = static_cast<int>(i);
+            m_activeIndex[node] = -1;
+            m_active.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // 左向きなら左右を反転（7⇔9, 4⇔6, 1⇔3）
+    if (m_facingLeft)
+        direction += (direction % 3 == 1) ? 2 : (direction % 3 == 0) ? -2 : 0;
+
+    if (direction != m_direction)
+    {
+        m_direction = direction;
+        Step(direction, 0);
+    }
+    if (triggers)
+        Step(direction, triggers);
+}
+
+//------------------------------------------------------------------------------
+// 手が入力に合うか
+//------------------------------------------------------------------------------
+bool CComboRecognizer::IsStepMatched(const ComboStep& step, int direction, DWORD triggers) const
+{
+    if (triggers == 0)
+        return step.buttons == 0 && step.direction == direction;
+
+    return step.buttons != 0 && (triggers & step.buttons) == step.buttons &&
+        (step.direction == 0 || step.direction == direction);
+}
+
+//------------------------------------------------------------------------------
+// 入力1つ分（方向の変化 / ボタンの押下）だけ木を進める
+// この入力で新しく進んだ節は、同じ入力ではさらに進めない
+// （進める前の節と開始フレームを写しておき、Enter で開始が変わった節もこの入力の前の開始で進める）
+// 次の手に合うものがない節は、節ごとのビットだけで読み飛ばす
+//------------------------------------------------------------------------------
+void CComboRecognizer::Step(int direction, DWORD triggers)
+{
+    m_stepping.clear();
+    for (int node : m_active)
+    {
+        if (triggers ? !(m_childButtons[node] & triggers) : !(m_childDirections[node] & (1 << direction)))
+            continue;
+        m_stepping.push_back(ActiveNode{ node, m_activeStart[node] });
+    }
+
+    for (const ActiveNode& active : m_stepping)
+    {
+        for (int child : m_nodes[active.node].children)
+        {
+            if (IsStepMatched(m_nodes[child].step, direction, triggers))
+                Enter(child, active.start);
+        }
+    }
+
+    // 根からは方向の手を方向ごとの表で引き、ボタンの手は順に調べる
+    const std::vector<int>& roots = triggers ? m_rootByButton : m_rootByDirection[direction];
+    for (int child : roots)
+    {
+        if (IsStepMatched(m_nodes[child].step, direction, triggers))
+            Enter(child, m_frame);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 節に進む（すでに途中なら、開始の遅い方を残す）
+//------------------------------------------------------------------------------
+void CComboRecognizer::Enter(int node, DWORD start)
+{
+    if (m_activeIndex[node] < 0)
+    {
+        m_activeIndex[node] = static_cast<int>(m_active.size());
+        m_active.push_back(node);
+        m_activeStart[node] = start;
+    }
+    else if (m_activeStart[node] < start)
+    {
+        m_activeStart[node] = start;
+    }
+    start = m_activeStart[node];
+
+    for (int pattern : m_nodes[node].patterns)
+    {
+        if (!m_matched[pattern] && m_frame - start <= static_cast<DWORD>(m_patternWindow[pattern]))
+        {
+            m_matched[pattern] = 1;
+            m_matches.push_back(pattern);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// このフレームで成立したコマンド
+//------------------------------------------------------------------------------
+bool CComboRecognizer::IsMatched(int pattern) const
+{
+    return pattern >= 0 && pattern < static_cast<int>(m_matched.size()) && m_matched[pattern] != 0;
+}
+
+int CComboRecognizer::GetMatchCount() const
+{
+    return static_cast<int>(m_matches.size());
+}
+
+int CComboRecognizer::GetMatch(int index) const
+{
+    return m_matches[index];
+}
+
+int CComboRecognizer::GetActiveCount() const
+{
+    return static_cast<int>(m_active.size());
+}
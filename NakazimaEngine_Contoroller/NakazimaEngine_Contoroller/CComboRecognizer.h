@@ -0,0 +1,117 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+#include "CInputRecording.h"
+
+//------------------------------------------------------------------------------
+// ComboStep
+// コマンド入力の1手
+//   buttons == 0 : direction の方向に入れた（その方向に変わった）フレームで成立
+//   buttons != 0 : buttons のボタンをすべて同じフレームで押したときに成立
+//                  direction が0以外なら、そのとき direction の方向に入れていること
+// 方向はテンキー表記（PadButtons.h の GetPadDirection を参照）、右向き基準で書く
+//   例：波動拳 = { ComboDirection(2), ComboDirection(3), ComboDirection(6), ComboButton(XINPUT_GAMEPAD_X) }
+//------------------------------------------------------------------------------
+struct ComboStep
+{
+    BYTE direction;
+    DWORD buttons;  // ボタンワードのビット
+};
+
+constexpr ComboStep ComboDirection(int direction)
+{
+    return ComboStep{ static_cast<BYTE>(direction), 0 };
+}
+
+constexpr ComboStep ComboButton(DWORD buttons, int direction = 0)
+{
+    return ComboStep{ static_cast<BYTE>(direction), buttons };
+}
+
+//------------------------------------------------------------------------------
+// CComboRecognizer
+// 登録したコマンドを、Update ごとの入力から少しずつ認識する
+//
+// 登録時に全コマンドを先頭の手を共有する木（オートマトン）にまとめておき、
+// 入力途中のコマンドは「木のどこまで進んだか」と「開始フレーム」だけを持つ
+// 毎フレームの処理は途中のものの数に比例し、履歴をコマンドごとに調べ直すことはない
+// 間に余計な入力が挟まっても、受付フレーム数以内に最後の手まで入れば成立する
+//------------------------------------------------------------------------------
+class CComboRecognizer
+{
+public:
+    CComboRecognizer();
+
+    // コマンドを登録し、番号を返す（windowFrames = 最初の手から最後の手までの受付フレーム数）
+    int AddPattern(const ComboStep* steps, int count, int windowFrames);
+    template<size_t N>
+    int AddPattern(const ComboStep (&steps)[N], int windowFrames)
+    {
+        return AddPattern(steps, static_cast<int>(N), windowFrames);
+    }
+
+    // 登録したコマンドをすべて削除する
+    void Clear();
+
+    // 入力途中のコマンドを捨てる
+    void Reset();
+
+    // 左向きのとき true（左右の方向を反転して認識する）
+    void SetFacingLeft(bool facingLeft);
+
+    // 1フレーム分の入力を進める（Update ごとに1回呼ぶ）
+    void Update(const InputFrame& input, int pad = 0);
+    void Advance(int direction, DWORD triggers);
+
+    //--------------------------------------
+    // このフレームで成立したコマンド
+    //--------------------------------------
+    bool IsMatched(int pattern) const;
+    int GetMatchCount() const;
+    int GetMatch(int index) const;
+
+    // 入力途中のコマンドの数（木の途中の位置の数）
+    int GetActiveCount() const;
+
+private:
+    //--------------------------------------
+    // 木の節（根は0番）
+    //--------------------------------------
+    struct Node
+    {
+        ComboStep step;             // この節に進む手
+        int window;                 // この節を通るコマンドの受付フレーム数の最大値
+        std::vector<int> children;  // 次の手の節
+        std::vector<int> patterns;  // この節で成立するコマンド
+    };
+
+    // Step で進める前の、入力途中の節と開始フレーム
+    struct ActiveNode
+    {
+        int node;
+        DWORD start;
+    };
+
+    bool IsStepMatched(const ComboStep& step, int direction, DWORD triggers) const;
+    void Step(int direction, DWORD triggers);
+    void Enter(int node, DWORD start);
+
+    std::vector<Node> m_nodes;
+    std::vector<WORD> m_childDirections;        // 節ごとの、次の方向の手の方向のビット（1 << 方向）
+    std::vector<DWORD> m_childButtons;          // 節ごとの、次のボタンの手のボタンのビットの和
+    std::vector<int> m_rootByDirection[10];     // 根から方向の手で進む節（方向ごと）
+    std::vector<int> m_rootByButton;            // 根からボタンの手で進む節
+    std::vector<int> m_patternWindow;           // コマンドごとの受付フレーム数
+
+    std::vector<int> m_active;                  // 入力途中の節
+    std::vector<DWORD> m_activeStart;           // 節ごとの開始フレーム（一番遅いもの）
+    std::vector<int> m_activeIndex;             // 節ごとの m_active 内の位置（-1 = 途中でない）
+    std::vector<ActiveNode> m_stepping;         // Step の作業用（毎回確保しないように持っておく）
+
+    std::vector<BYTE> m_matched;                // コマンドごとの成立フラグ
+    std::vector<int> m_matches;                 // このフレームで成立したコマンド
+
+    DWORD m_frame;
+    int m_direction;                            // 前回の方向
+    bool m_facingLeft;
+};
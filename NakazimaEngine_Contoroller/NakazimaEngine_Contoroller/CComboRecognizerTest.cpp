@@ -0,0 +1,214 @@
+#include "CSelfTest.h"
+#include "CComboRecognizer.h"
+
+namespace
+{
+    constexpr ComboStep HADOKEN[] = { ComboDirection(2), ComboDirection(3), ComboDirection(6), ComboButton(XINPUT_GAMEPAD_X) };
+
+    // direction に入れたまま frames フレーム進める
+    void Hold(CComboRecognizer& combo, int direction, int frames = 1)
+    {
+        for (int i = 0; i < frames; ++i)
+            combo.Advance(direction, 0);
+    }
+
+    // direction に入れて buttons を押す（1フレーム）
+    void Press(CComboRecognizer& combo, int direction, DWORD buttons)
+    {
+        combo.Advance(direction, buttons);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 受付フレーム数ちょうどなら成立し、1フレーム過ぎたら成立しない
+// 間に余計な方向が挟まっても成立する
+//------------------------------------------------------------------------------
+SELF_TEST(ComboMotionWindow)
+{
+    CComboRecognizer combo;
+    int hadoken = combo.AddPattern(HADOKEN, 12);
+
+    // 2 を入れたフレームから 12 フレーム後に X
+    Hold(combo, 5);
+    Hold(combo, 2);
+    Hold(combo, 3);
+    Hold(combo, 6, 10);
+    Press(combo, 6, XINPUT_GAMEPAD_X);
+    SELF_CHECK(combo.IsMatched(hadoken) && combo.GetMatchCount() == 1);
+
+    // 次のフレームには残らない
+    Hold(combo, 6);
+    SELF_CHECK(!combo.IsMatched(hadoken) && combo.GetMatchCount() == 0);
+
+    // 13 フレーム後では遅い
+    combo.Reset();
+    Hold(combo, 5);
+    Hold(combo, 2);
+    Hold(combo, 3);
+    Hold(combo, 6, 11);
+    Press(combo, 6, XINPUT_GAMEPAD_X);
+    SELF_CHECK(!combo.IsMatched(hadoken));
+
+    // 余計な方向が挟まっても、受付フレーム数以内なら成立する
+    Hold(combo, 5);
+    Hold(combo, 2);
+    Hold(combo, 1);
+    Hold(combo, 3);
+    Hold(combo, 9);
+    Hold(combo, 6);
+    Press(combo, 6, XINPUT_GAMEPAD_X);
+    SELF_CHECK(combo.IsMatched(hadoken));
+
+    // 方向が合わないボタンでは成立しない
+    Hold(combo, 5);
+    Hold(combo, 2);
+    Hold(combo, 3);
+    Hold(combo, 6);
+    Press(combo, 6, XINPUT_GAMEPAD_Y);
+    SELF_CHECK(!combo.IsMatched(hadoken));
+}
+
+//------------------------------------------------------------------------------
+// 左向きのときは左右を反転して認識する
+//------------------------------------------------------------------------------
+SELF_TEST(ComboFacingLeft)
+{
+    constexpr ComboStep forwardX[] = { ComboButton(XINPUT_GAMEPAD_X, 6) };
+    CComboRecognizer combo;
+    int hadoken = combo.AddPattern(HADOKEN, 12);
+    int forward = combo.AddPattern(forwardX, 1);
+
+    combo.SetFacingLeft(true);
+    Hold(combo, 5);
+    Hold(combo, 2);
+    Hold(combo, 1);
+    Hold(combo, 4);
+    Press(combo, 4, XINPUT_GAMEPAD_X);
+    SELF_CHECK(combo.IsMatched(hadoken) && combo.IsMatched(forward));
+
+    // 右向きの入力では成立しない（前の入力の途中のものは受付フレーム数を過ぎるまで待つ）
+    Hold(combo, 5, 15);
+    Hold(combo, 2);
+    Hold(combo, 3);
+    Hold(combo, 6);
+    Press(combo, 6, XINPUT_GAMEPAD_X);
+    SELF_CHECK(!combo.IsMatched(hadoken) && !combo.IsMatched(forward));
+
+    // 右向きに戻せば元どおり
+    combo.SetFacingLeft(false);
+    Hold(combo, 5, 15);
+    Hold(combo, 2);
+    Hold(combo, 3);
+    Hold(combo, 6);
+    Press(combo, 6, XINPUT_GAMEPAD_X);
+    SELF_CHECK(combo.IsMatched(hadoken) && combo.IsMatched(forward));
+}
+
+//------------------------------------------------------------------------------
+// 先頭の手を共有するコマンド
+//------------------------------------------------------------------------------
+SELF_TEST(ComboSharedPrefix)
+{
+    constexpr ComboStep hadokenY[] = { ComboDirection(2), ComboDirection(3), ComboDirection(6), ComboButton(XINPUT_GAMEPAD_Y) };
+    constexpr ComboStep shinku[] = { ComboDirection(2), ComboDirection(3), ComboDirection(6),
+        ComboDirection(2), ComboDirection(3), ComboDirection(6), ComboButton(XINPUT_GAMEPAD_X) };
+    CComboRecognizer combo;
+    int hadoken = combo.AddPattern(HADOKEN, 12);
+    int kick = combo.AddPattern(hadokenY, 12);
+    int super = combo.AddPattern(shinku, 30);
+
+    Hold(combo, 5);
+    Hold(combo, 2);
+    Hold(combo, 3);
+    Hold(combo, 6);
+    Press(combo, 6, XINPUT_GAMEPAD_Y);
+    SELF_CHECK(combo.IsMatched(kick) && !combo.IsMatched(hadoken) && !combo.IsMatched(super));
+
+    // 長い方が成立するときは、その後半で短い方も成立する
+    Hold(combo, 5);
+    for (int i = 0; i < 2; ++i)
+    {
+        Hold(combo, 2);
+        Hold(combo, 3);
+        Hold(combo, 6);
+    }
+    Press(combo, 6, XINPUT_GAMEPAD_X);
+    SELF_CHECK(combo.IsMatched(super) && combo.IsMatched(hadoken) && !combo.IsMatched(kick));
+    SELF_CHECK(combo.GetMatchCount() == 2);
+}
+
+//------------------------------------------------------------------------------
+// 1つの入力で同じ途中の節を2回進めない
+// X,X,X（10フレーム）と X,X,X,Y（30フレーム）は節を共有する
+// 1, 8, 15 フレーム目の X は、間が 14 フレームあるので X,X,X にならない
+//------------------------------------------------------------------------------
+SELF_TEST(ComboSharedNodeStart)
+{
+    constexpr ComboStep triple[] = { ComboButton(XINPUT_GAMEPAD_X), ComboButton(XINPUT_GAMEPAD_X), ComboButton(XINPUT_GAMEPAD_X) };
+    constexpr ComboStep tripleY[] = { ComboButton(XINPUT_GAMEPAD_X), ComboButton(XINPUT_GAMEPAD_X), ComboButton(XINPUT_GAMEPAD_X),
+        ComboButton(XINPUT_GAMEPAD_Y) };
+    CComboRecognizer combo;
+    int short3 = combo.AddPattern(triple, 10);
+    int long4 = combo.AddPattern(tripleY, 30);
+
+    bool early = false;
+    for (int frame = 1; frame <= 15; ++frame)
+    {
+        combo.Advance(5, (frame % 7 == 1) ? XINPUT_GAMEPAD_X : 0);
+        early |= combo.IsMatched(short3);
+    }
+    SELF_CHECK(!early);
+
+    // 8, 15, 16 フレーム目の X は 8 フレームに収まる
+    Press(combo, 5, XINPUT_GAMEPAD_X);
+    SELF_CHECK(combo.IsMatched(short3));
+
+    // 続く Y は 8 フレーム目からの X,X,X,Y として成立する
+    Hold(combo, 5, 3);
+    Press(combo, 5, XINPUT_GAMEPAD_Y);
+    SELF_CHECK(combo.IsMatched(long4));
+}
+
+//------------------------------------------------------------------------------
+// 計測：500個のコマンドを登録して、ランダムな入力を1フレームずつ進める
+//------------------------------------------------------------------------------
+SELF_BENCH(ComboRecognizerAdvance)
+{
+    const int PATTERNS = 500;
+    const int FRAMES = 1000000;
+
+    DWORD random = 7;
+    auto next = [&random]() { random = random * 1103515245 + 12345; return (random >> 16) & 0x7FFF; };
+
+    CComboRecognizer combo;
+    for (int i = 0; i < PATTERNS; ++i)
+    {
+        ComboStep steps[6];
+        int count = 2 + next() % 4;
+        for (int k = 0; k < count; ++k)
+        {
+            int direction = 1 + next() % 9;
+            steps[k] = ComboDirection(direction == 5 ? 6 : direction);
+        }
+        steps[count] = ComboButton(XINPUT_GAMEPAD_A << (next() % 4));
+        combo.AddPattern(steps, count + 1, 15 + next() % 20);
+    }
+
+    // 方向は4フレームに1回くらい、ボタンは10フレームに1回くらい変える
+    int direction = 5;
+    int matches = 0;
+    LONGLONG active = 0;
+    double start = CSelfTest::GetTimeUs();
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        if (next() % 4 == 0)
+            direction = 1 + next() % 9;
+        combo.Advance(direction, (next() % 10 == 0) ? (XINPUT_GAMEPAD_A << (next() % 4)) : 0);
+        matches += combo.GetMatchCount();
+        active += combo.GetActiveCount();
+    }
+    double elapsed = CSelfTest::GetTimeUs() - start;
+
+    CSelfTest::Report("  %d patterns: %.1f ns/Advance, active %.1f on average, %d matches",
+        PATTERNS, elapsed * 1000.0 / FRAMES, static_cast<double>(active) / FRAMES, matches);
+}
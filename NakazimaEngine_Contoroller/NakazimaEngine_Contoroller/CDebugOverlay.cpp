@@ -0,0 +1,274 @@
+#include "CDebugOverlay.h"
+#include "CKeyBitset.h"
+
+namespace
+{
+    const int MAX_DECIMALS = 9;
+    const double POWERS_OF_TEN[MAX_DECIMALS + 1] =
+    {
+        1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 1000000.0, 10000000.0, 100000000.0, 1000000000.0,
+    };
+
+    // 丸めた値がこれを超えたら抑える（LONGLONG に収めるため）
+    const double MAX_SCALED = 1.0e17;
+
+    // 小数を 10^decimals 倍して丸める
+    LONGLONG Quantize(double value, int decimals)
+    {
+        double scaled = value * POWERS_OF_TEN[decimals];
+        if (!(scaled == scaled))
+            return 0;   // NaN
+        if (scaled > MAX_SCALED)
+            scaled = MAX_SCALED;
+        if (scaled < -MAX_SCALED)
+            scaled = -MAX_SCALED;
+        return static_cast<LONGLONG>(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+    }
+
+    // 文字列を書き込み、書き込んだ文字数を返す（capacity 文字まで）
+    int CopyText(WCHAR* dst, const WCHAR* text, int capacity)
+    {
+        int length = 0;
+        while (text[length] != L'\0' && length < capacity)
+        {
+            dst[length] = text[length];
+            ++length;
+        }
+        return length;
+    }
+}
+
+//------------------------------------------------------------------------------
+// CNullDebugTextSink
+//------------------------------------------------------------------------------
+CNullDebugTextSink::CNullDebugTextSink()
+    : lineCount(0)
+    , charCount(0)
+{
+}
+
+void CNullDebugTextSink::SetLine(int, const WCHAR*, int length)
+{
+    ++lineCount;
+    charCount += length;
+}
+
+//------------------------------------------------------------------------------
+// コンストラクタ
+//------------------------------------------------------------------------------
+CDebugOverlay::CDebugOverlay()
+    : m_fieldCount(0)
+    , m_lineCount(0)
+    , m_dirtyLines(0)
+{
+    ZeroMemory(m_fields, sizeof(m_fields));
+    ZeroMemory(m_lines, sizeof(m_lines));
+}
+
+//------------------------------------------------------------------------------
+// 行・項目の追加
+//------------------------------------------------------------------------------
+int CDebugOverlay::AddLine()
+{
+    if (m_lineCount >= MAX_LINES)
+        return -1;
+
+    m_dirtyLines |= 1u << m_lineCount;
+    return m_lineCount++;
+}
+
+int CDebugOverlay::GetLineCount() const
+{
+    return m_lineCount;
+}
+
+int CDebugOverlay::AddField(int line, BYTE type, const WCHAR* label, const WCHAR* suffix, int decimals)
+{
+    if (line < 0 || line >= m_lineCount || m_fieldCount >= MAX_FIELDS)
+        return -1;
+
+    Field& field = m_fields[m_fieldCount];
+    field.label = label;
+    field.suffix = suffix;
+    field.value = 0;
+    field.type = type;
+    field.decimals = static_cast<BYTE>(decimals < 0 ? 0 : (decimals > MAX_DECIMALS ? MAX_DECIMALS : decimals));
+    field.line = static_cast<BYTE>(line);
+
+    m_dirtyLines |= 1u << line;
+    return m_fieldCount++;
+}
+
+int CDebugOverlay::AddText(int line, const WCHAR* text)
+{
+    return AddField(line, DEBUG_FIELD_TEXT, text, nullptr, 0);
+}
+
+int CDebugOverlay::AddCounter(int line, const WCHAR* label, const WCHAR* suffix)
+{
+    return AddField(line, DEBUG_FIELD_COUNTER, label, suffix, 0);
+}
+
+int CDebugOverlay::AddBool(int line, const WCHAR* label)
+{
+    return AddField(line, DEBUG_FIELD_BOOL, label, nullptr, 0);
+}
+
+int CDebugOverlay::AddFloat(int line, const WCHAR* label, int decimals, const WCHAR* suffix)
+{
+    return AddField(line, DEBUG_FIELD_FLOAT, label, suffix, decimals);
+}
+
+int CDebugOverlay::AddFps(int line, const WCHAR* label)
+{
+    return AddField(line, DEBUG_FIELD_FPS, label, nullptr, 1);
+}
+
+//------------------------------------------------------------------------------
+// 値の設定
+//------------------------------------------------------------------------------
+void CDebugOverlay::SetValue(int field, LONGLONG value)
+{
+    if (field < 0)
+        return;
+
+    Field& f = m_fields[field];
+    if (f.value == value)
+        return;
+
+    f.value = value;
+    m_dirtyLines |= 1u << f.line;
+}
+
+void CDebugOverlay::SetCounter(int field, LONGLONG value)
+{
+    SetValue(field, value);
+}
+
+void CDebugOverlay::SetBool(int field, bool value)
+{
+    SetValue(field, value ? 1 : 0);
+}
+
+void CDebugOverlay::SetFloat(int field, double value)
+{
+    if (field >= 0)
+        SetValue(field, Quantize(value, m_fields[field].decimals));
+}
+
+void CDebugOverlay::SetFps(int field, double value)
+{
+    SetFloat(field, value);
+}
+
+//------------------------------------------------------------------------------
+// 印の付いた行だけ整形し直す
+//------------------------------------------------------------------------------
+int CDebugOverlay::Flush(IDebugTextSink& sink)
+{
+    int count = 0;
+    while (m_dirtyLines != 0)
+    {
+        int line = CountTrailingZeros64(m_dirtyLines);
+        m_dirtyLines &= m_dirtyLines - 1;
+
+        FormatLine(line);
+        sink.SetLine(line, m_lines[line].text, m_lines[line].length);
+        ++count;
+    }
+    return count;
+}
+
+void CDebugOverlay::FormatLine(int line)
+{
+    // 数値1つの最大の長さ（符号 + 19桁 + 小数点）
+    const int MAX_NUMBER_LENGTH = 21;
+    const int CAPACITY = MAX_LINE_LENGTH - 1;
+
+    Line& l = m_lines[line];
+    int length = 0;
+    for (int i = 0; i < m_fieldCount; ++i)
+    {
+        const Field& f = m_fields[i];
+        if (f.line != line)
+            continue;
+
+        if (f.label)
+            length += CopyText(l.text + length, f.label, CAPACITY - length);
+
+        if (f.type != DEBUG_FIELD_TEXT)
+        {
+            if (length + MAX_NUMBER_LENGTH > CAPACITY)
+                break;
+
+            if (f.type == DEBUG_FIELD_FLOAT || f.type == DEBUG_FIELD_FPS)
+                length += FormatFixed(l.text + length, f.value, f.decimals);
+            else
+                length += FormatInteger(l.text + length, f.value);
+        }
+
+        if (f.suffix)
+            length += CopyText(l.text + length, f.suffix, CAPACITY - length);
+    }
+
+    l.text[length] = L'\0';
+    l.length = length;
+}
+
+const WCHAR* CDebugOverlay::GetLineText(int line) const
+{
+    return m_lines[line].text;
+}
+
+int CDebugOverlay::GetLineLength(int line) const
+{
+    return m_lines[line].length;
+}
+
+//------------------------------------------------------------------------------
+// 数値の書き込み
+//------------------------------------------------------------------------------
+int CDebugOverlay::FormatInteger(WCHAR* dst, LONGLONG value)
+{
+    // 下の桁から一時領域に書き、逆順に写す
+    WCHAR digits[20];
+    int count = 0;
+    ULONGLONG magnitude = (value < 0) ? 0 - static_cast<ULONGLONG>(value) : static_cast<ULONGLONG>(value);
+    do
+    {
+        digits[count++] = static_cast<WCHAR>(L'0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    int length = 0;
+    if (value < 0)
+        dst[length++] = L'-';
+    while (count > 0)
+        dst[length++] = digits[--count];
+    return length;
+}
+
+int CDebugOverlay::FormatFixed(WCHAR* dst, LONGLONG scaled, int decimals)
+{
+    if (decimals <= 0)
+        return FormatInteger(dst, scaled);
+
+    ULONGLONG power = static_cast<ULONGLONG>(POWERS_OF_TEN[decimals]);
+    ULONGLONG magnitude = (scaled < 0) ? 0 - static_cast<ULONGLONG>(scaled) : static_cast<ULONGLONG>(scaled);
+    ULONGLONG integer = magnitude / power;
+    ULONGLONG fraction = magnitude % power;
+
+    int length = 0;
+    if (scaled < 0)
+        dst[length++] = L'-';
+    length += FormatInteger(dst + length, static_cast<LONGLONG>(integer));
+    dst[length++] = L'.';
+
+    // 小数部は先頭を 0 で埋めて decimals 桁にする
+    for (int i = decimals - 1; i >= 0; --i)
+    {
+        dst[length + i] = static_cast<WCHAR>(L'0' + fraction % 10);
+        fraction /= 10;
+    }
+    return length + decimals;
+}
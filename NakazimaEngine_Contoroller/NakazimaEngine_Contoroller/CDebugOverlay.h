@@ -0,0 +1,111 @@
+#pragma once
+#include <windows.h>
+
+//------------------------------------------------------------------------------
+// IDebugTextSink
+// 整形し直した行の受け取り先（描画側で行ごとのレイアウトを作り直す）
+//------------------------------------------------------------------------------
+class IDebugTextSink
+{
+public:
+    virtual ~IDebugTextSink() = default;
+
+    // line 行目の文字列が text（length 文字、終端の 0 は含まない）に変わった
+    virtual void SetLine(int line, const WCHAR* text, int length) = 0;
+};
+
+// 受け取った回数と文字数を数えるだけ（描画なしでの検証・計測用）
+class CNullDebugTextSink : public IDebugTextSink
+{
+public:
+    CNullDebugTextSink();
+    void SetLine(int line, const WCHAR* text, int length) override;
+
+    DWORD lineCount;
+    DWORD charCount;
+};
+
+//------------------------------------------------------------------------------
+// 項目の種類
+//------------------------------------------------------------------------------
+enum DebugFieldType : BYTE
+{
+    DEBUG_FIELD_TEXT,       // 固定の文字列だけ
+    DEBUG_FIELD_COUNTER,    // 整数
+    DEBUG_FIELD_BOOL,       // 0 / 1
+    DEBUG_FIELD_FLOAT,      // 小数点以下 decimals 桁の小数
+    DEBUG_FIELD_FPS,        // FPS（小数点以下1桁）
+};
+
+//------------------------------------------------------------------------------
+// CDebugOverlay
+// デバッグ表示の文字列を、値が変わった行だけ整形し直す
+// 項目は 見出し + 値 + 後ろの文字列 で、行は項目を追加した順に並べる
+// 小数は表示する桁に丸めた整数として持つので、表示が変わらない変化では整形しない
+// 整形は swprintf を使わず整数演算だけで行う（ロケールの影響を受けない）
+// 見出し・後ろの文字列は文字列リテラルなど、ずっと残るものを渡す
+//------------------------------------------------------------------------------
+class CDebugOverlay
+{
+public:
+    static const int MAX_LINES = 32;
+    static const int MAX_FIELDS = 128;
+    static const int MAX_LINE_LENGTH = 128;   // 終端の 0 を含む
+
+    CDebugOverlay();
+
+    // 行を追加して番号を返す（いっぱいなら -1）
+    int AddLine();
+    int GetLineCount() const;
+
+    // 項目を追加して番号を返す（いっぱいなら -1）
+    int AddText(int line, const WCHAR* text);
+    int AddCounter(int line, const WCHAR* label, const WCHAR* suffix = nullptr);
+    int AddBool(int line, const WCHAR* label);
+    int AddFloat(int line, const WCHAR* label, int decimals, const WCHAR* suffix = nullptr);
+    int AddFps(int line, const WCHAR* label);
+
+    // 値の設定（表示が変わるときだけ行を整形し直す印を付ける）
+    void SetCounter(int field, LONGLONG value);
+    void SetBool(int field, bool value);
+    void SetFloat(int field, double value);
+    void SetFps(int field, double value);
+
+    // 印の付いた行を整形し直して sink に渡す（渡した行数を返す）
+    int Flush(IDebugTextSink& sink);
+
+    // 最後に整形した行の文字列と長さ
+    const WCHAR* GetLineText(int line) const;
+    int GetLineLength(int line) const;
+
+    // 整数・小数を書き込み、書き込んだ文字数を返す（dst には十分な空きがあること）
+    static int FormatInteger(WCHAR* dst, LONGLONG value);
+    static int FormatFixed(WCHAR* dst, LONGLONG scaled, int decimals); // scaled / 10^decimals を書く
+
+private:
+    struct Field
+    {
+        const WCHAR* label;
+        const WCHAR* suffix;
+        LONGLONG value;     // 小数は 10^decimals 倍して丸めた値
+        BYTE type;          // DebugFieldType
+        BYTE decimals;
+        BYTE line;
+    };
+
+    struct Line
+    {
+        WCHAR text[MAX_LINE_LENGTH];
+        int length;
+    };
+
+    int AddField(int line, BYTE type, const WCHAR* label, const WCHAR* suffix, int decimals);
+    void SetValue(int field, LONGLONG value);
+    void FormatLine(int line);
+
+    Field m_fields[MAX_FIELDS];
+    int m_fieldCount;
+    Line m_lines[MAX_LINES];
+    int m_lineCount;
+    DWORD m_dirtyLines;     // bit i = i 行目を整形し直す
+};
@@ -0,0 +1,89 @@
+#include "CSelfTest.h"
+#include "CDebugOverlay.h"
+
+namespace
+{
+    const int LINES = 8;
+    const int FIELDS_PER_LINE = 6;
+    const int FRAMES = 200000;
+
+    //--------------------------------------
+    // デモのデバッグ表示と同じくらいの行と項目を並べる
+    // 1行目は FPS、残りは見出し付きの小数・整数・真偽値
+    //--------------------------------------
+    struct OverlayLayout
+    {
+        CDebugOverlay overlay;
+        int fps;
+        int fields[LINES][FIELDS_PER_LINE];
+
+        OverlayLayout()
+        {
+            fps = overlay.AddFps(overlay.AddLine(), L"FPS=");
+            for (int i = 0; i < LINES; ++i)
+            {
+                int line = overlay.AddLine();
+                for (int j = 0; j < FIELDS_PER_LINE; ++j)
+                {
+                    if (j % 3 == 0)
+                        fields[i][j] = overlay.AddFloat(line, L" v=", 3, L"ms");
+                    else if (j % 3 == 1)
+                        fields[i][j] = overlay.AddCounter(line, L" n=");
+                    else
+                        fields[i][j] = overlay.AddBool(line, L" b=");
+                }
+            }
+        }
+
+        // すべての項目に値を設定する（changing = true なら毎フレーム表示が変わる値）
+        void Set(int frame, bool changing)
+        {
+            overlay.SetFps(fps, 60.0 + (frame / 60) * 0.1);
+            for (int i = 0; i < LINES; ++i)
+            {
+                for (int j = 0; j < FIELDS_PER_LINE; ++j)
+                {
+                    int value = changing ? frame + i + j : i + j;
+                    if (j % 3 == 0)
+                        overlay.SetFloat(fields[i][j], value * 0.001);
+                    else if (j % 3 == 1)
+                        overlay.SetCounter(fields[i][j], value);
+                    else
+                        overlay.SetBool(fields[i][j], (value & 1) != 0);
+                }
+            }
+        }
+    };
+
+    void MeasureOverlay(const char* name, bool changing)
+    {
+        static OverlayLayout layout;
+        CNullDebugTextSink sink;
+        layout.Set(0, changing);
+        layout.overlay.Flush(sink);
+        sink.lineCount = 0;
+        sink.charCount = 0;
+
+        double start = CSelfTest::GetTimeUs();
+        for (int frame = 1; frame <= FRAMES; ++frame)
+        {
+            layout.Set(frame, changing);
+            layout.overlay.Flush(sink);
+        }
+        double elapsed = CSelfTest::GetTimeUs() - start;
+
+        CSelfTest::Report("  %-16s: %.1f ns/frame, %.2f lines and %.1f chars formatted per frame",
+            name, elapsed * 1000.0 / FRAMES, static_cast<double>(sink.lineCount) / FRAMES,
+            static_cast<double>(sink.charCount) / FRAMES);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 計測：デバッグ表示の値の設定と整形（描画なし、CNullDebugTextSink に渡すだけ）
+// 毎フレームすべての値を設定し、表示が変わらなければ整形しない場合と、すべての行が変わる場合
+//------------------------------------------------------------------------------
+SELF_BENCH(DebugOverlayFlush)
+{
+    MeasureOverlay("mostly unchanged", false);
+    MeasureOverlay("all dirty", true);
+}
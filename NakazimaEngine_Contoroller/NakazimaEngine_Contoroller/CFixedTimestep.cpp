@@ -0,0 +1,113 @@
+#include "CFixedTimestep.h"
+
+//------------------------------------------------------------------------------
+// コンストラクタ
+//------------------------------------------------------------------------------
+CFixedTimestep::CFixedTimestep()
+    : m_freq(0)
+    , m_period(0)
+    , m_simTime(0)
+    , m_now(0)
+    , m_tickRate(0)
+    , m_maxTicks(8)
+    , m_pending(0)
+    , m_started(false)
+    , m_tickCount(0)
+    , m_droppedTicks(0)
+{
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    m_freq = freq.QuadPart;
+
+    SetTickRate(60.0);
+}
+
+void CFixedTimestep::SetTickRate(double hz)
+{
+    if (hz <= 0.0)
+        return;
+
+    m_tickRate = hz;
+    m_period = static_cast<LONGLONG>(m_freq / hz);
+    if (m_period < 1)
+        m_period = 1;
+}
+
+double CFixedTimestep::GetTickRate() const
+{
+    return m_tickRate;
+}
+
+double CFixedTimestep::GetTickMs() const
+{
+    return m_period * 1000.0 / m_freq;
+}
+
+void CFixedTimestep::SetMaxTicksPerFrame(int count)
+{
+    m_maxTicks = count < 1 ? 1 : count;
+}
+
+void CFixedTimestep::Start(LONGLONG now)
+{
+    m_simTime = now;
+    m_now = now;
+    m_pending = 0;
+    m_started = true;
+}
+
+//------------------------------------------------------------------------------
+// 時間を溜めてティック数を決める
+// 取り出していないティックが残っていれば、それも含めて数え直す
+// 処理が重くて上限を超えたら、超えた分の時間を捨てる（遅れを取り戻そうとして更に遅れるのを防ぐ）
+//------------------------------------------------------------------------------
+int CFixedTimestep::Advance(LONGLONG now)
+{
+    if (!m_started)
+        Start(now);
+    if (now > m_now)
+        m_now = now;
+
+    LONGLONG ticks = (m_now - m_simTime) / m_period;
+    if (ticks > m_maxTicks)
+    {
+        LONGLONG dropped = ticks - m_maxTicks;
+        m_simTime += dropped * m_period;
+        m_droppedTicks += static_cast<DWORD>(dropped);
+        ticks = m_maxTicks;
+    }
+    m_pending = static_cast<int>(ticks);
+    return m_pending;
+}
+
+bool CFixedTimestep::NextTick(LONGLONG& tickEnd)
+{
+    if (m_pending <= 0)
+        return false;
+
+    --m_pending;
+    m_simTime += m_period;
+    ++m_tickCount;
+    tickEnd = m_simTime;
+    return true;
+}
+
+float CFixedTimestep::GetAlpha() const
+{
+    LONGLONG remain = m_now - m_simTime;
+    if (remain <= 0)
+        return 0.0f;
+    if (remain >= m_period)
+        return 1.0f;
+    return static_cast<float>(remain) / static_cast<float>(m_period);
+}
+
+DWORD CFixedTimestep::GetTickTotal() const
+{
+    return m_tickCount;
+}
+
+DWORD CFixedTimestep::GetDroppedTicks() const
+{
+    return m_droppedTicks;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <windows.h>
+
+//------------------------------------------------------------------------------
+// CFixedTimestep
+// シミュレーションを固定の間隔（ティック）で進めるためのスケジューラ
+// フレームごとに経過時間を溜め（アキュムレータ）、溜まった分だけティックを進める
+// 時間は QueryPerformanceCounter のカウント数で数えるので、誤差は溜まらない
+// 描画は最後のティックから次のティックまでの割合（GetAlpha）で補間する
+// 例：timestep.Advance(now);
+//     while (timestep.NextTick(tickEnd)) { 入力の更新(tickEnd); シミュレーション(GetTickMs()); }
+//     描画(timestep.GetAlpha());
+//------------------------------------------------------------------------------
+class CFixedTimestep
+{
+public:
+    CFixedTimestep();
+
+    // 1秒あたりのティック数（既定 60Hz）
+    void SetTickRate(double hz);
+    double GetTickRate() const;
+    double GetTickMs() const;
+
+    // 1フレームで進めるティック数の上限（既定 8、超えた分の時間は捨ててシミュレーションを遅らせる）
+    void SetMaxTicksPerFrame(int count);
+
+    // now からティックを数え始める
+    void Start(LONGLONG now);
+
+    // now までの時間を溜め、このフレームで進めるティック数を決める（毎フレーム1回呼ぶ）
+    int Advance(LONGLONG now);
+
+    // 次のティックを1つ取り出す（なければ false）
+    // tickEnd = そのティックが受け持つ時間の終わり（この時刻までに起きた入力を反映する）
+    bool NextTick(LONGLONG& tickEnd);
+
+    // 最後のティックから次のティックまでの割合（0.0f ~ 1.0f 未満、描画の補間用）
+    float GetAlpha() const;
+
+    DWORD GetTickTotal() const;     // これまでに進めたティック数
+    DWORD GetDroppedTicks() const;  // 上限を超えて捨てたティック数
+
+private:
+    LONGLONG m_freq;
+    LONGLONG m_period;          // 1ティックの長さ（QPC のカウント数）
+    LONGLONG m_simTime;         // 最後に取り出したティックの終わりの時刻
+    LONGLONG m_now;             // 最後に Advance した時刻
+    double m_tickRate;
+    int m_maxTicks;
+    int m_pending;              // このフレームでまだ取り出していないティック数
+    bool m_started;
+    DWORD m_tickCount;
+    DWORD m_droppedTicks;
+};
@@ -0,0 +1,189 @@
+#include "CFramePacer.h"
+#include <cmath>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+namespace
+{
+    // CATCH_UP でも、これ以上遅れたら追いつくのをあきらめて RESYNC する（フレーム数）
+    const LONGLONG MAX_CATCH_UP_FRAMES = 4;
+
+    LONGLONG Now()
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return now.QuadPart;
+    }
+}
+
+//------------------------------------------------------------------------------
+// コンストラクタ
+// 高精度タイマーを作れなければ、通常のタイマーと timeBeginPeriod(1) を使う
+//------------------------------------------------------------------------------
+CFramePacer::CFramePacer()
+    : m_timer(nullptr)
+    , m_highResolution(false)
+    , m_freq(0)
+    , m_period(0)
+    , m_spin(0)
+    , m_next(0)
+    , m_lastWake(0)
+    , m_targetRate(0)
+    , m_policy(FRAME_MISS_CATCH_UP)
+{
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    m_freq = freq.QuadPart;
+
+    m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (m_timer)
+    {
+        m_highResolution = true;
+    }
+    else
+    {
+        m_timer = CreateWaitableTimerW(nullptr, TRUE, nullptr);
+        timeBeginPeriod(1);
+    }
+
+    SetTargetRate(60.0);
+    SetSpinMs(m_highResolution ? 0.5 : 2.0);
+    ResetStats();
+}
+
+CFramePacer::~CFramePacer()
+{
+    if (m_timer)
+        CloseHandle(m_timer);
+    if (!m_highResolution)
+        timeEndPeriod(1);
+}
+
+void CFramePacer::SetTargetRate(double hz)
+{
+    if (hz <= 0.0)
+        return;
+
+    m_targetRate = hz;
+    m_period = static_cast<LONGLONG>(m_freq / hz);
+}
+
+double CFramePacer::GetTargetRate() const
+{
+    return m_targetRate;
+}
+
+void CFramePacer::SetSpinMs(double ms)
+{
+    m_spin = static_cast<LONGLONG>(ms * m_freq / 1000.0);
+}
+
+double CFramePacer::GetSpinMs() const
+{
+    return m_spin * 1000.0 / m_freq;
+}
+
+void CFramePacer::SetMissPolicy(FrameMissPolicy policy)
+{
+    m_policy = policy;
+}
+
+void CFramePacer::Start()
+{
+    m_next = Now() + m_period;
+    m_lastWake = 0;
+}
+
+//------------------------------------------------------------------------------
+// 次の締め切りまで待つ
+//------------------------------------------------------------------------------
+void CFramePacer::Wait()
+{
+    if (m_next == 0)
+        Start();
+
+    LONGLONG now = Now();
+    LONGLONG late = now - m_next;
+
+    if (late < 0)
+    {
+        // 締め切りの少し前までタイマーで眠る（単位は 100ns、負の値は相対時間）
+        LONGLONG sleep = -late - m_spin;
+        if (sleep > 0 && m_timer)
+        {
+            LARGE_INTEGER due;
+            due.QuadPart = -(sleep * 10000000 / m_freq);
+            if (due.QuadPart < 0 && SetWaitableTimer(m_timer, &due, 0, nullptr, nullptr, FALSE))
+                WaitForSingleObject(m_timer, INFINITE);
+        }
+
+        // 残りはスピンして合わせる
+        while ((now = Now()) < m_next)
+            YieldProcessor();
+
+        double overshootMs = (now - m_next) * 1000.0 / m_freq;
+        if (overshootMs > m_stats.maxOvershootMs)
+            m_stats.maxOvershootMs = overshootMs;
+        m_next += m_period;
+    }
+    else
+    {
+        // 間に合わなかった
+        ++m_stats.misses;
+        switch (m_policy)
+        {
+        case FRAME_MISS_CATCH_UP:
+            if (late < m_period * MAX_CATCH_UP_FRAMES)
+                m_next += m_period;
+            else
+                m_next = now + m_period;
+            break;
+
+        case FRAME_MISS_RESYNC:
+            m_next = now + m_period;
+            break;
+
+        case FRAME_MISS_SKIP:
+            m_next += (late / m_period + 1) * m_period;
+            break;
+        }
+    }
+
+    if (m_lastWake != 0)
+        AddInterval(now - m_lastWake);
+    m_lastWake = now;
+}
+
+//------------------------------------------------------------------------------
+// 統計
+//------------------------------------------------------------------------------
+void CFramePacer::AddInterval(LONGLONG interval)
+{
+    double ms = interval * 1000.0 / m_freq;
+
+    ++m_stats.frames;
+    m_sum += ms;
+    m_sumSquares += ms * ms;
+    if (m_stats.frames == 1 || ms < m_stats.minMs)
+        m_stats.minMs = ms;
+    if (ms > m_stats.maxMs)
+        m_stats.maxMs = ms;
+
+    m_stats.meanMs = m_sum / m_stats.frames;
+    double variance = m_sumSquares / m_stats.frames - m_stats.meanMs * m_stats.meanMs;
+    m_stats.jitterMs = variance > 0.0 ? std::sqrt(variance) : 0.0;
+}
+
+const FramePacerStats& CFramePacer::GetStats() const
+{
+    return m_stats;
+}
+
+void CFramePacer::ResetStats()
+{
+    ZeroMemory(&m_stats, sizeof(m_stats));
+    m_sum = 0.0;
+    m_sumSquares = 0.0;
+}
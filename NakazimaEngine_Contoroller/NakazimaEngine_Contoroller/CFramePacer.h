@@ -0,0 +1,81 @@
+#pragma once
+#include <windows.h>
+
+//------------------------------------------------------------------------------
+// 締め切りに間に合わなかったフレームの扱い
+//------------------------------------------------------------------------------
+enum FrameMissPolicy : BYTE
+{
+    FRAME_MISS_CATCH_UP,    // 予定を保ったまま、遅れた分は待たずに続けて進める（大きく遅れたら RESYNC）
+    FRAME_MISS_RESYNC,      // 今から1フレーム後を次の締め切りにする
+    FRAME_MISS_SKIP,        // 間に合わなかった締め切りを飛ばし、元の間隔の次の締め切りに合わせる
+};
+
+//------------------------------------------------------------------------------
+// FramePacerStats
+// Wait から戻った間隔の統計（ミリ秒）
+//------------------------------------------------------------------------------
+struct FramePacerStats
+{
+    DWORD frames;           // 計測したフレーム数
+    DWORD misses;           // Wait を呼んだ時点で締め切りを過ぎていた回数
+    double meanMs;          // 間隔の平均
+    double jitterMs;        // 間隔の標準偏差
+    double minMs;           // 間隔の最小
+    double maxMs;           // 間隔の最大
+    double maxOvershootMs;  // 締め切りから実際に戻るまでの遅れの最大（待った場合のみ）
+};
+
+//------------------------------------------------------------------------------
+// CFramePacer
+// 目標のフレームレートに合わせて待つ
+// 締め切りの少し前まではタイマーで眠り（CPU を使わない）、残りはスピンして正確に合わせる
+// Windows 10 1803 以降は高精度の待機可能タイマーを使い、使えない場合は
+// timeBeginPeriod(1) を生成時に1回だけ設定した通常のタイマーを使う
+//------------------------------------------------------------------------------
+class CFramePacer
+{
+public:
+    CFramePacer();
+    ~CFramePacer();
+
+    CFramePacer(const CFramePacer&) = delete;
+    CFramePacer& operator=(const CFramePacer&) = delete;
+
+    // 目標のフレームレート（既定 60Hz）
+    void SetTargetRate(double hz);
+    double GetTargetRate() const;
+
+    // 締め切りの何ミリ秒前からスピンするか（既定はタイマーの精度に合わせて 0.5ms か 2ms）
+    void SetSpinMs(double ms);
+    double GetSpinMs() const;
+
+    void SetMissPolicy(FrameMissPolicy policy);
+
+    // 計測と予定を今から始める
+    void Start();
+
+    // 次の締め切りまで待ち、その次の締め切りを決める（毎フレーム1回呼ぶ）
+    void Wait();
+
+    const FramePacerStats& GetStats() const;
+    void ResetStats();
+
+private:
+    void AddInterval(LONGLONG interval);
+
+    HANDLE m_timer;
+    bool m_highResolution;      // 高精度タイマーを使えているか
+
+    LONGLONG m_freq;
+    LONGLONG m_period;          // 1フレームの長さ（QPC のカウント数）
+    LONGLONG m_spin;            // スピンする長さ（QPC のカウント数）
+    LONGLONG m_next;            // 次の締め切り
+    LONGLONG m_lastWake;        // 前回 Wait から戻った時刻（0 = まだ）
+    double m_targetRate;
+    FrameMissPolicy m_policy;
+
+    FramePacerStats m_stats;
+    double m_sum;               // 間隔の合計と2乗の合計（ミリ秒）
+    double m_sumSquares;
+};
@@ -0,0 +1,42 @@
+#include "CSelfTest.h"
+#include "CFramePacer.h"
+
+namespace
+{
+    //--------------------------------------
+    // rateHz で seconds 秒分 Wait して、戻った間隔の統計を書く
+    // spinMs が負なら既定のスピン時間のまま
+    //--------------------------------------
+    void MeasurePacer(double rateHz, double seconds, double spinMs = -1.0)
+    {
+        CFramePacer pacer;
+        pacer.SetTargetRate(rateHz);
+        if (spinMs >= 0.0)
+            pacer.SetSpinMs(spinMs);
+
+        int frames = static_cast<int>(rateHz * seconds);
+        pacer.Start();
+        for (int i = 0; i < frames; ++i)
+            pacer.Wait();
+
+        const FramePacerStats& s = pacer.GetStats();
+        CSelfTest::Report("  %6.1f Hz spin %.2f ms (target %.3f ms): mean %.3f, jitter %.3f, min %.3f, max %.3f ms, "
+            "misses %lu/%lu, max overshoot %.3f ms",
+            rateHz, pacer.GetSpinMs(), 1000.0 / rateHz, s.meanMs, s.jitterMs, s.minMs, s.maxMs,
+            static_cast<unsigned long>(s.misses), static_cast<unsigned long>(s.frames), s.maxOvershootMs);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 計測：目標のフレームレートごとに、Wait から戻った間隔の分布
+// 何もしないループなので、締め切りに間に合わないのはタイマーやスケジューラの遅れだけ
+// スピンなし（タイマーだけ）の場合も比べる
+//------------------------------------------------------------------------------
+SELF_BENCH(FramePacerIntervals)
+{
+    MeasurePacer(60.0, 2.0);
+    MeasurePacer(144.0, 2.0);
+    MeasurePacer(240.0, 2.0);
+    MeasurePacer(1000.0, 2.0);
+    MeasurePacer(144.0, 2.0, 0.0);
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+
+//------------------------------------------------------------------------------
+// CFramePipeline
+// 1フレーム分の描画に必要なデータ（パケット）を、作るスレッドから描くスレッドへ渡す
+// 書き込み側1つ・読み出し側1つ専用。パケットは作った順に描かれる
+// depth = 描いているフレームより何フレーム先まで作っておけるか
+//   1 : ダブルバッファ（フレーム N を描いている間に N+1 を作る、遅延は最小）
+//   2~: 処理時間のばらつきを吸収できるが、その分だけ入力から画面までが遅れる
+// 作る側は先に進みすぎたら、描く側が1つ描き終わるまで待つ
+//------------------------------------------------------------------------------
+template<class T>
+class CFramePipeline
+{
+public:
+    static const int MAX_DEPTH = 3;
+
+    CFramePipeline()
+        : m_depth(1)
+        , m_write(0)
+        , m_read(0)
+        , m_queued(0)
+        , m_stopped(false)
+        , m_writeWaits(0)
+    {
+    }
+
+    // 空にして、depth を設定し直す（両方のスレッドが使っていないときだけ呼ぶこと）
+    void Reset(int depth)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_depth = depth < 1 ? 1 : (depth > MAX_DEPTH ? MAX_DEPTH : depth);
+        m_write = 0;
+        m_read = 0;
+        m_queued = 0;
+        m_stopped = false;
+        m_writeWaits = 0;
+    }
+
+    int GetDepth() const
+    {
+        return m_depth;
+    }
+
+    //--------------------------------------
+    // 書き込み側
+    //--------------------------------------
+    // 書き込むパケットを取得する（先に作りすぎていれば待つ、停止したら nullptr）
+    T* BeginWrite()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_queued > m_depth && !m_stopped)
+        {
+            ++m_writeWaits;
+            m_cond.wait(lock, [this] { return m_queued <= m_depth || m_stopped; });
+        }
+        return m_stopped ? nullptr : &m_slots[m_write];
+    }
+
+    // 書き終わったパケットを描く側へ渡す
+    void EndWrite()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_write = (m_write + 1) % (m_depth + 1);
+            ++m_queued;
+        }
+        m_cond.notify_all();
+    }
+
+    // BeginWrite で待った回数（描く側が追いついていない目安）
+    unsigned int GetWriteWaits() const
+    {
+        return m_writeWaits;
+    }
+
+    //--------------------------------------
+    // 読み出し側
+    //--------------------------------------
+    // 次のパケットを取得する（届くまで待つ、停止して残りがなければ nullptr）
+    const T* BeginRead()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this] { return m_queued > 0 || m_stopped; });
+        return m_queued > 0 ? &m_slots[m_read] : nullptr;
+    }
+
+    // 描き終わったパケットを返す
+    void EndRead()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_read = (m_read + 1) % (m_depth + 1);
+            --m_queued;
+        }
+        m_cond.notify_all();
+    }
+
+    // 待っている側を起こして止める（残っているパケットは読み出し側が描き切れる）
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_cond.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    // 描き終わっていない depth 個 + 書き込み中の1つ があれば重ならない
+    T m_slots[MAX_DEPTH + 1];
+    int m_depth;
+    int m_write;                // 次に書き込む位置
+    int m_read;                 // 次に読み出す位置
+    int m_queued;               // 書き終わって、まだ描き終わっていないパケット数（描いている途中のものを含む）
+    bool m_stopped;
+    unsigned int m_writeWaits;
+};
@@ -0,0 +1,330 @@
+#include "CFrameStats.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+    // 最上位の立っているビット位置（value != 0 が前提）
+    int HighestBit(DWORD value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse(&index, value);
+        return static_cast<int>(index);
+#else
+        return 31 - __builtin_clz(value);
+#endif
+    }
+}
+
+//------------------------------------------------------------------------------
+// CFrameHistogram
+//------------------------------------------------------------------------------
+CFrameHistogram::CFrameHistogram()
+{
+    Reset();
+}
+
+void CFrameHistogram::Reset()
+{
+    ZeroMemory(m_counts, sizeof(m_counts));
+    m_total = 0;
+}
+
+void CFrameHistogram::Add(DWORD us)
+{
+    ++m_counts[GetBucketIndex(us)];
+    ++m_total;
+}
+
+void CFrameHistogram::Remove(DWORD us)
+{
+    --m_counts[GetBucketIndex(us)];
+    --m_total;
+}
+
+DWORD CFrameHistogram::GetCount() const
+{
+    return m_total;
+}
+
+DWORD CFrameHistogram::GetBucketCount(int index) const
+{
+    return m_counts[index];
+}
+
+//------------------------------------------------------------------------------
+// 区間の番号
+//   SUB_BUCKET_COUNT * 2 未満はそのまま、それ以上は
+//   最上位ビットの位置から 2の累乗の区間を、その下の SUB_BUCKET_BITS ビットから区間内の位置を決める
+//------------------------------------------------------------------------------
+int CFrameHistogram::GetBucketIndex(DWORD us)
+{
+    if (us < SUB_BUCKET_COUNT * 2)
+        return static_cast<int>(us);
+
+    int shift = HighestBit(us) - SUB_BUCKET_BITS;
+    int sub = static_cast<int>(us >> shift) - SUB_BUCKET_COUNT;
+    return SUB_BUCKET_COUNT * 2 + (shift - 1) * SUB_BUCKET_COUNT + sub;
+}
+
+DWORD CFrameHistogram::GetBucketValue(int index)
+{
+    if (index < SUB_BUCKET_COUNT * 2)
+        return static_cast<DWORD>(index);
+
+    int shift = (index - SUB_BUCKET_COUNT * 2) / SUB_BUCKET_COUNT + 1;
+    int sub = (index - SUB_BUCKET_COUNT * 2) % SUB_BUCKET_COUNT;
+    DWORD low = static_cast<DWORD>(SUB_BUCKET_COUNT + sub) << shift;
+    return low + ((1u << shift) >> 1);
+}
+
+//------------------------------------------------------------------------------
+// 百分位数
+//------------------------------------------------------------------------------
+DWORD CFrameHistogram::GetPercentile(double percent) const
+{
+    DWORD value;
+    GetPercentiles(&percent, &value, 1);
+    return value;
+}
+
+void CFrameHistogram::GetPercentiles(const double* percents, DWORD* out, int count) const
+{
+    int next = 0;
+    if (m_total == 0)
+    {
+        for (; next < count; ++next)
+            out[next] = 0;
+        return;
+    }
+
+    // 小さい方から数えて、各 percent の位置（1 ~ m_total 番目）を含む区間を探す
+    DWORD seen = 0;
+    for (int i = 0; i < BUCKET_COUNT && next < count; ++i)
+    {
+        seen += m_counts[i];
+        while (next < count)
+        {
+            double rank = percents[next] * m_total / 100.0;
+            DWORD target = (rank < 1.0) ? 1 : static_cast<DWORD>(rank + 0.999999);
+            if (seen < target)
+                break;
+            out[next++] = GetBucketValue(i);
+        }
+    }
+    for (; next < count; ++next)
+        out[next] = GetBucketValue(BUCKET_COUNT - 1);
+}
+
+//------------------------------------------------------------------------------
+// 統計をまとめる
+//------------------------------------------------------------------------------
+FrameStatsSummary CFrameHistogram::GetSummary(ULONGLONG sumUs, DWORD maxUs) const
+{
+    static const int PERCENT_COUNT = 4;
+    static const double PERCENTS[PERCENT_COUNT] = { 50.0, 90.0, 99.0, 99.9 };
+
+    FrameStatsSummary summary;
+    ZeroMemory(&summary, sizeof(summary));
+    summary.count = m_total;
+    if (summary.count == 0)
+        return summary;
+
+    DWORD values[PERCENT_COUNT];
+    GetPercentiles(PERCENTS, values, PERCENT_COUNT);
+
+    // 区間の代表値は最大を超えることがあるので抑える
+    for (int i = 0; i < PERCENT_COUNT; ++i)
+    {
+        if (values[i] > maxUs)
+            values[i] = maxUs;
+    }
+
+    summary.meanMs = sumUs / 1000.0 / summary.count;
+    summary.p50Ms = values[0] / 1000.0;
+    summary.p90Ms = values[1] / 1000.0;
+    summary.p99Ms = values[2] / 1000.0;
+    summary.p999Ms = values[3] / 1000.0;
+    summary.maxMs = maxUs / 1000.0;
+    return summary;
+}
+
+//------------------------------------------------------------------------------
+// CFrameStats
+//------------------------------------------------------------------------------
+const int CFrameStats::WINDOW_FRAMES[FRAME_WINDOW_LONG + 1] = { SHORT_WINDOW_FRAMES, LONG_WINDOW_FRAMES };
+
+CFrameStats::CFrameStats()
+{
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    m_freq = freq.QuadPart;
+
+    Reset();
+}
+
+void CFrameStats::Reset()
+{
+    for (int s = 0; s < FRAME_SERIES_COUNT; ++s)
+    {
+        Series& series = m_series[s];
+        for (int w = 0; w < FRAME_WINDOW_COUNT; ++w)
+            series.histogram[w].Reset();
+        ZeroMemory(series.values, sizeof(series.values));
+        series.position = 0;
+        series.count = 0;
+        ZeroMemory(series.max, sizeof(series.max));
+        ZeroMemory(series.sum, sizeof(series.sum));
+    }
+
+    m_lastFrame = 0;
+    m_phaseStart = 0;
+    m_phase = -1;
+    ZeroMemory(m_phaseTotal, sizeof(m_phaseTotal));
+    ZeroMemory(m_phaseUsed, sizeof(m_phaseUsed));
+}
+
+//------------------------------------------------------------------------------
+// フレームの始まり
+//------------------------------------------------------------------------------
+void CFrameStats::BeginFrame(LONGLONG now)
+{
+    // 計測中の処理は前のフレームの分として終える
+    if (m_phase >= 0)
+    {
+        m_phaseTotal[m_phase] += now - m_phaseStart;
+        m_phase = -1;
+    }
+
+    for (int s = 0; s < FRAME_SERIES_COUNT; ++s)
+    {
+        if (!m_phaseUsed[s])
+            continue;
+
+        Record(static_cast<FrameSeries>(s), static_cast<DWORD>(m_phaseTotal[s] * 1000000 / m_freq));
+        m_phaseTotal[s] = 0;
+        m_phaseUsed[s] = false;
+    }
+
+    if (m_lastFrame != 0)
+        Record(FRAME_SERIES_INTERVAL, static_cast<DWORD>((now - m_lastFrame) * 1000000 / m_freq));
+    m_lastFrame = now;
+}
+
+//------------------------------------------------------------------------------
+// 処理の計測
+//------------------------------------------------------------------------------
+void CFrameStats::BeginPhase(FrameSeries phase)
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+
+    if (m_phase >= 0)
+        m_phaseTotal[m_phase] += now.QuadPart - m_phaseStart;
+
+    m_phase = phase;
+    m_phaseStart = now.QuadPart;
+    m_phaseUsed[phase] = true;
+}
+
+void CFrameStats::EndPhase()
+{
+    if (m_phase < 0)
+        return;
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    m_phaseTotal[m_phase] += now.QuadPart - m_phaseStart;
+    m_phase = -1;
+}
+
+//------------------------------------------------------------------------------
+// 記録
+// 直近の値を輪状に持っておき、区間から外れた値をヒストグラムから取り除く
+//------------------------------------------------------------------------------
+void CFrameStats::Record(FrameSeries series, DWORD us)
+{
+    Series& s = m_series[series];
+
+    for (int w = 0; w < FRAME_WINDOW_COUNT; ++w)
+    {
+        s.histogram[w].Add(us);
+        s.sum[w] += us;
+        if (us > s.max[w])
+            s.max[w] = us;
+    }
+
+    // 区間から外れる値（WINDOW_FRAMES[w] 個前の値）を、今回の値で上書きする前に読んでおく
+    DWORD removed[FRAME_WINDOW_ALL];
+    bool isRemoved[FRAME_WINDOW_ALL];
+    for (int w = 0; w < FRAME_WINDOW_ALL; ++w)
+    {
+        isRemoved[w] = (s.count >= static_cast<DWORD>(WINDOW_FRAMES[w]));
+        if (!isRemoved[w])
+            continue;
+
+        int old = s.position - WINDOW_FRAMES[w];
+        if (old < 0)
+            old += LONG_WINDOW_FRAMES;
+        removed[w] = s.values[old];
+    }
+    s.values[s.position] = us;
+
+    for (int w = 0; w < FRAME_WINDOW_ALL; ++w)
+    {
+        if (!isRemoved[w])
+            continue;
+
+        s.histogram[w].Remove(removed[w]);
+        s.sum[w] -= removed[w];
+
+        // 最大の値が外れたときだけ求め直す
+        if (removed[w] == s.max[w] && removed[w] != us)
+            RescanMax(s, w);
+    }
+
+    if (++s.position == LONG_WINDOW_FRAMES)
+        s.position = 0;
+    ++s.count;
+}
+
+void CFrameStats::RescanMax(Series& series, int window)
+{
+    // 今回の値（position）と、その前の WINDOW_FRAMES[window] - 1 個
+    DWORD max = 0;
+    int index = series.position;
+    for (int i = 0; i < WINDOW_FRAMES[window]; ++i)
+    {
+        if (series.values[index] > max)
+            max = series.values[index];
+        if (--index < 0)
+            index = LONG_WINDOW_FRAMES - 1;
+    }
+    series.max[window] = max;
+}
+
+//------------------------------------------------------------------------------
+// 統計の取得
+//------------------------------------------------------------------------------
+FrameStatsSummary CFrameStats::GetSummary(FrameSeries series, FrameStatsWindow window) const
+{
+    const Series& s = m_series[series];
+    return s.histogram[window].GetSummary(s.sum[window], s.max[window]);
+}
+
+const CFrameHistogram& CFrameStats::GetHistogram(FrameSeries series, FrameStatsWindow window) const
+{
+    return m_series[series].histogram[window];
+}
+
+double CFrameStats::GetLastMs(FrameSeries series) const
+{
+    const Series& s = m_series[series];
+    if (s.count == 0)
+        return 0.0;
+
+    int last = (s.position == 0) ? LONG_WINDOW_FRAMES - 1 : s.position - 1;
+    return s.values[last] / 1000.0;
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <windows.h>
+
+//------------------------------------------------------------------------------
+// FrameStatsSummary
+// ヒストグラム1つ分の統計（ミリ秒）
+//------------------------------------------------------------------------------
+struct FrameStatsSummary
+{
+    DWORD count;
+    double meanMs;
+    double p50Ms;
+    double p90Ms;
+    double p99Ms;
+    double p999Ms;
+    double maxMs;       // 最大は近似ではなく実際の値
+};
+
+//------------------------------------------------------------------------------
+// CFrameHistogram
+// 時間（マイクロ秒）の分布を固定サイズで保持するヒストグラム（HDR 形式の対数・線形）
+// 2の累乗ごとの区間をさらに SUB_BUCKET_COUNT 個に等分するので、
+// どの大きさの値も相対誤差 1/SUB_BUCKET_COUNT 以内で数えられる
+//   0 ~ 63us は 1us 単位、64 ~ 127us は 2us 単位、128 ~ 255us は 4us 単位、...
+//------------------------------------------------------------------------------
+class CFrameHistogram
+{
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;   // 32（誤差 約3%）
+    static const int BUCKET_COUNT = SUB_BUCKET_COUNT * 2 + (31 - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT;
+
+    CFrameHistogram();
+
+    void Reset();
+    void Add(DWORD us);
+    void Remove(DWORD us);  // Add した値を取り除く（区間の移動用）
+
+    DWORD GetCount() const;
+    DWORD GetBucketCount(int index) const;  // index 番目の区間に入っている数
+
+    // percent（0.0 ~ 100.0）の位置の値（近似値、空なら0）
+    DWORD GetPercentile(double percent) const;
+
+    // 昇順に並べた複数の percent の位置の値をまとめて求める（走査は1回）
+    void GetPercentiles(const double* percents, DWORD* out, int count) const;
+
+    // 統計をまとめる（合計と最大はヒストグラムからは正確に求められないので呼び出し側が渡す）
+    FrameStatsSummary GetSummary(ULONGLONG sumUs, DWORD maxUs) const;
+
+    // 値の入る区間の番号と、区間の代表値（区間の中央）
+    static int GetBucketIndex(DWORD us);
+    static DWORD GetBucketValue(int index);
+
+private:
+    DWORD m_counts[BUCKET_COUNT];
+    DWORD m_total;
+};
+
+//------------------------------------------------------------------------------
+// 計測する時間の種類
+//------------------------------------------------------------------------------
+enum FrameSeries : BYTE
+{
+    FRAME_SERIES_INTERVAL,      // フレームの間隔（BeginFrame から次の BeginFrame まで）
+    FRAME_SERIES_INPUT,         // 入力の更新
+    FRAME_SERIES_SIMULATION,    // ゲームの処理
+    FRAME_SERIES_RENDER,        // 描画（Present まで）
+    FRAME_SERIES_SLEEP,         // 次のフレームまでの待ち
+    FRAME_SERIES_COUNT,
+};
+
+//------------------------------------------------------------------------------
+// 統計をとる区間
+//------------------------------------------------------------------------------
+enum FrameStatsWindow : BYTE
+{
+    FRAME_WINDOW_SHORT,         // 直近 SHORT_WINDOW_FRAMES フレーム
+    FRAME_WINDOW_LONG,          // 直近 LONG_WINDOW_FRAMES フレーム
+    FRAME_WINDOW_ALL,           // Reset してから全部
+    FRAME_WINDOW_COUNT,
+};
+
+//------------------------------------------------------------------------------
+// CFrameStats
+// フレームの間隔と、フレーム内の処理ごとの時間を記録する
+// 平均では見えない引っかかり（たまに長くなるフレーム）を百分位数と最大で見る
+// 使い方：
+//   フレームの最初に BeginFrame、処理の区切りで BeginPhase / EndPhase を呼ぶ
+//   同じフレームで同じ処理を何度か計測したときは合計を1回分として記録する
+//------------------------------------------------------------------------------
+class CFrameStats
+{
+public:
+    static const int SHORT_WINDOW_FRAMES = 60;
+    static const int LONG_WINDOW_FRAMES = 600;
+
+    CFrameStats();
+
+    void Reset();
+
+    // フレームの始まり（now は QueryPerformanceCounter の値）
+    // 前のフレームの間隔と、前のフレームで計測した処理の時間を記録する
+    void BeginFrame(LONGLONG now);
+
+    // 処理の計測を始める（計測中の処理があればそこで終える）
+    void BeginPhase(FrameSeries phase);
+    void EndPhase();
+
+    // 値を直接記録する
+    void Record(FrameSeries series, DWORD us);
+
+    FrameStatsSummary GetSummary(FrameSeries series, FrameStatsWindow window) const;
+    const CFrameHistogram& GetHistogram(FrameSeries series, FrameStatsWindow window) const;
+
+    // 最後に記録した値（ミリ秒）
+    double GetLastMs(FrameSeries series) const;
+
+private:
+    struct Series
+    {
+        CFrameHistogram histogram[FRAME_WINDOW_COUNT];
+        DWORD values[LONG_WINDOW_FRAMES];   // 直近の値（区間から外れる値を取り除くため）
+        int position;                       // 次に書く位置
+        DWORD count;                        // 記録した数
+        DWORD max[FRAME_WINDOW_COUNT];
+        ULONGLONG sum[FRAME_WINDOW_COUNT];
+    };
+
+    // 区間 window の直近の値から最大を求め直す
+    void RescanMax(Series& series, int window);
+
+    static const int WINDOW_FRAMES[FRAME_WINDOW_LONG + 1];
+
+    Series m_series[FRAME_SERIES_COUNT];
+
+    LONGLONG m_freq;
+    LONGLONG m_lastFrame;                   // 前の BeginFrame の時刻（0 = まだ）
+    LONGLONG m_phaseStart;                  // 計測中の処理の開始時刻
+    int m_phase;                            // 計測中の処理（-1 = なし）
+    LONGLONG m_phaseTotal[FRAME_SERIES_COUNT];  // このフレームで計測した処理の合計
+    bool m_phaseUsed[FRAME_SERIES_COUNT];
+};
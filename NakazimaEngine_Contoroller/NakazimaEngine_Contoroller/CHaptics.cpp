@@ -0,0 +1,258 @@
+#include "CHaptics.h"
+#include "CInputEventLog.h"
+#include <cmath>
+
+//------------------------------------------------------------------------------
+// 出力先
+//------------------------------------------------------------------------------
+DWORD CXInputHapticsSink::Write(int slot, const XINPUT_VIBRATION& vibration)
+{
+    XINPUT_VIBRATION copy = vibration;
+    return XInputSetState(slot, &copy);
+}
+
+CMockHapticsSink::CMockHapticsSink()
+{
+    ZeroMemory(writeCount, sizeof(writeCount));
+    ZeroMemory(last, sizeof(last));
+}
+
+DWORD CMockHapticsSink::Write(int slot, const XINPUT_VIBRATION& vibration)
+{
+    ++writeCount[slot];
+    last[slot] = vibration;
+    return ERROR_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+// 効果の作成
+//------------------------------------------------------------------------------
+HapticEffect MakeHapticRumble(float left, float right, float durationMs)
+{
+    HapticEffect effect;
+    ZeroMemory(&effect, sizeof(effect));
+    effect.left = left;
+    effect.right = right;
+    effect.holdMs = durationMs;
+    return effect;
+}
+
+HapticEffect MakeHapticPulse(float left, float right, float periodMs, float duty, float durationMs)
+{
+    HapticEffect effect = MakeHapticRumble(left, right, durationMs);
+    effect.pulsePeriodMs = periodMs;
+    effect.pulseDuty = duty;
+    return effect;
+}
+
+HapticEffect MakeHapticDecay(float left, float right, float durationMs)
+{
+    HapticEffect effect = MakeHapticRumble(left, right, 0.0f);
+    effect.releaseMs = durationMs;
+    effect.release = HAPTIC_RELEASE_EXPONENTIAL;
+    return effect;
+}
+
+//------------------------------------------------------------------------------
+// コンストラクタ
+//------------------------------------------------------------------------------
+CHaptics::CHaptics()
+    : m_sink(&m_xinputSink)
+    , m_effectCount(0)
+    , m_writeCount(0)
+{
+    ZeroMemory(m_effects, sizeof(m_effects));
+    for (int i = 0; i < MAX_EFFECTS; ++i)
+        m_effects[i].slot = -1;
+
+    ZeroMemory(m_baseLeft, sizeof(m_baseLeft));
+    ZeroMemory(m_baseRight, sizeof(m_baseRight));
+    ZeroMemory(m_output, sizeof(m_output));
+    ZeroMemory(m_written, sizeof(m_written));
+    ZeroMemory(m_isWritten, sizeof(m_isWritten));
+}
+
+//------------------------------------------------------------------------------
+// 出力先の差し替え（新しい出力先には次の Update で必ず書き込む）
+//------------------------------------------------------------------------------
+void CHaptics::SetSink(IHapticsSink* sink)
+{
+    m_sink = sink ? sink : &m_xinputSink;
+    ZeroMemory(m_isWritten, sizeof(m_isWritten));
+}
+
+//------------------------------------------------------------------------------
+// 効果の再生・停止
+// 停止用の番号 = 下位8bit が効果の位置、上位が世代
+//------------------------------------------------------------------------------
+int CHaptics::Play(int slot, const HapticEffect& effect, LONGLONG now)
+{
+    if (slot < 0 || slot >= XUSER_MAX_COUNT)
+        return -1;
+
+    for (int i = 0; i < MAX_EFFECTS; ++i)
+    {
+        Effect& e = m_effects[i];
+        if (e.slot >= 0)
+            continue;
+
+        e.effect = effect;
+        e.start = now;
+        e.slot = slot;
+        ++e.generation;
+        ++m_effectCount;
+        return i | (e.generation << 8);
+    }
+    return -1;
+}
+
+void CHaptics::Stop(int handle)
+{
+    if (handle < 0)
+        return;
+
+    Effect& e = m_effects[(handle & 0xFF) % MAX_EFFECTS];
+    if (e.slot >= 0 && e.generation == static_cast<WORD>(handle >> 8))
+    {
+        e.slot = -1;
+        --m_effectCount;
+    }
+}
+
+void CHaptics::StopAll(int slot)
+{
+    for (int i = 0; i < MAX_EFFECTS; ++i)
+    {
+        if (m_effects[i].slot == slot)
+        {
+            m_effects[i].slot = -1;
+            --m_effectCount;
+        }
+    }
+}
+
+void CHaptics::SetBase(int slot, float left, float right)
+{
+    if (slot < 0 || slot >= XUSER_MAX_COUNT)
+        return;
+
+    m_baseLeft[slot] = left;
+    m_baseRight[slot] = right;
+}
+
+//------------------------------------------------------------------------------
+// 効果の経過時間に対する強さ
+//------------------------------------------------------------------------------
+float CHaptics::Evaluate(const HapticEffect& effect, float elapsedMs)
+{
+    float holdEnd = effect.attackMs + effect.holdMs;
+    float end = holdEnd + effect.releaseMs;
+    if (elapsedMs >= end)
+        return -1.0f;
+
+    float level;
+    if (elapsedMs < effect.attackMs)
+    {
+        level = elapsedMs / effect.attackMs;
+    }
+    else if (elapsedMs < holdEnd)
+    {
+        level = 1.0f;
+    }
+    else
+    {
+        float remain = 1.0f - (elapsedMs - holdEnd) / effect.releaseMs;
+        level = (effect.release == HAPTIC_RELEASE_EXPONENTIAL) ? remain * remain * remain : remain;
+    }
+
+    if (effect.pulsePeriodMs > 0.0f &&
+        std::fmod(elapsedMs, effect.pulsePeriodMs) >= effect.pulsePeriodMs * effect.pulseDuty)
+    {
+        level = 0.0f;
+    }
+    return level;
+}
+
+//------------------------------------------------------------------------------
+// 合成した強さをモーターの速さにする
+// 負の値・NaN は0、1.0f を超えた分は切り捨てる（範囲外の float を WORD にすると未定義動作）
+//------------------------------------------------------------------------------
+WORD CHaptics::ToMotorSpeed(float level)
+{
+    if (!(level > 0.0f))
+        return 0;
+    if (level >= 1.0f)
+        return 65535;
+    return static_cast<WORD>(level * 65535.0f + 0.5f);
+}
+
+//------------------------------------------------------------------------------
+// 合成と書き込み
+//------------------------------------------------------------------------------
+void CHaptics::Update(LONGLONG now, BYTE connectedMask)
+{
+    float left[XUSER_MAX_COUNT];
+    float right[XUSER_MAX_COUNT];
+    for (int i = 0; i < XUSER_MAX_COUNT; ++i)
+    {
+        left[i] = m_baseLeft[i];
+        right[i] = m_baseRight[i];
+    }
+
+    // 再生中の効果を足す（終わったものはここで消す）
+    if (m_effectCount > 0)
+    {
+        double msPerCount = 1000.0 / GetInputTimestampFrequency();
+        for (int i = 0; i < MAX_EFFECTS; ++i)
+        {
+            Effect& e = m_effects[i];
+            if (e.slot < 0)
+                continue;
+
+            float level = Evaluate(e.effect, static_cast<float>((now - e.start) * msPerCount));
+            if (level < 0.0f)
+            {
+                e.slot = -1;
+                --m_effectCount;
+                continue;
+            }
+            left[e.slot] += e.effect.left * level;
+            right[e.slot] += e.effect.right * level;
+        }
+    }
+
+    for (int i = 0; i < XUSER_MAX_COUNT; ++i)
+    {
+        XINPUT_VIBRATION& output = m_output[i];
+        output.wLeftMotorSpeed = ToMotorSpeed(left[i]);
+        output.wRightMotorSpeed = ToMotorSpeed(right[i]);
+
+        // 未接続の間は書き込まず、次に接続されたら必ず書き込む
+        if (!(connectedMask & (1 << i)))
+        {
+            m_isWritten[i] = false;
+            continue;
+        }
+
+        if (m_isWritten[i] &&
+            output.wLeftMotorSpeed == m_written[i].wLeftMotorSpeed &&
+            output.wRightMotorSpeed == m_written[i].wRightMotorSpeed)
+        {
+            continue;
+        }
+
+        ++m_writeCount;
+        m_isWritten[i] = (m_sink->Write(i, output) == ERROR_SUCCESS);
+        m_written[i] = output;
+    }
+}
+
+const XINPUT_VIBRATION& CHaptics::GetOutput(int slot) const
+{
+    return m_output[slot];
+}
+
+DWORD CHaptics::GetWriteCount() const
+{
+    return m_writeCount;
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <windows.h>
+#include <Xinput.h>
+
+//------------------------------------------------------------------------------
+// IHapticsSink
+// 振動の出力先（既定は XInputSetState、検証用に差し替えられる）
+//------------------------------------------------------------------------------
+class IHapticsSink
+{
+public:
+    virtual ~IHapticsSink() = default;
+
+    // 振動を書き込む（ERROR_SUCCESS 以外なら書き込めなかった）
+    virtual DWORD Write(int slot, const XINPUT_VIBRATION& vibration) = 0;
+};
+
+// XInputSetState に書き込む
+class CXInputHapticsSink : public IHapticsSink
+{
+public:
+    DWORD Write(int slot, const XINPUT_VIBRATION& vibration) override;
+};
+
+// 書き込みを数えて最後の値を覚えておくだけ（デバイスなしでの検証用）
+class CMockHapticsSink : public IHapticsSink
+{
+public:
+    CMockHapticsSink();
+    DWORD Write(int slot, const XINPUT_VIBRATION& vibration) override;
+
+    int writeCount[XUSER_MAX_COUNT];
+    XINPUT_VIBRATION last[XUSER_MAX_COUNT];
+};
+
+//------------------------------------------------------------------------------
+// HapticEffect
+// 時間で変化する振動1つ
+//   強さ：attack で0から上げ、hold の間そのまま、release で0まで下げる
+//   pulsePeriodMs を0以外にすると、その周期の最初の pulseDuty の割合だけ振動する
+//------------------------------------------------------------------------------
+enum HapticRelease : BYTE
+{
+    HAPTIC_RELEASE_LINEAR,      // 直線的に下げる
+    HAPTIC_RELEASE_EXPONENTIAL, // 最初に大きく下げ、ゆっくり0に近づける
+};
+
+struct HapticEffect
+{
+    float left;             // 左モーター（低周波）の強さ 0.0f ~ 1.0f
+    float right;            // 右モーター（高周波）の強さ 0.0f ~ 1.0f
+    float attackMs;
+    float holdMs;
+    float releaseMs;
+    BYTE release;           // HapticRelease
+    float pulsePeriodMs;
+    float pulseDuty;        // 0.0f ~ 1.0f
+};
+
+// 一定の強さで durationMs だけ振動
+HapticEffect MakeHapticRumble(float left, float right, float durationMs);
+
+// periodMs ごとに duty の割合だけ振動することを durationMs の間くり返す
+HapticEffect MakeHapticPulse(float left, float right, float periodMs, float duty, float durationMs);
+
+// 最大の強さから durationMs かけて減衰する（衝撃・着地など）
+HapticEffect MakeHapticDecay(float left, float right, float durationMs);
+
+//------------------------------------------------------------------------------
+// CHaptics
+// 振動の合成と出力
+// 再生中の効果と、スロットごとの基本の強さ（SetBase）をモーターごとに足し合わせ、
+// 結果が前回書き込んだ値から変わったときだけ出力先に書き込む
+// 効果は再生したら終わるまで放っておいてよい（終わったものは自動で消える）
+//------------------------------------------------------------------------------
+class CHaptics
+{
+public:
+    static const int MAX_EFFECTS = 32;
+
+    CHaptics();
+
+    // 出力先の差し替え（nullptr で XInputSetState に戻す）
+    void SetSink(IHapticsSink* sink);
+
+    // 効果を再生し、停止用の番号を返す（空きがないか、slot が 0 ~ XUSER_MAX_COUNT-1 でなければ -1）
+    int Play(int slot, const HapticEffect& effect, LONGLONG now);
+    void Stop(int handle);
+    void StopAll(int slot);
+
+    // ずっと続く基本の強さ（0.0f ~ 1.0f、次に設定するまで変わらない、slot が範囲外なら何もしない）
+    void SetBase(int slot, float left, float right);
+
+    // 効果を進めて合成し、変わったスロットだけ書き込む
+    // connectedMask の bit i = スロット i が接続中（未接続のスロットには書き込まない）
+    void Update(LONGLONG now, BYTE connectedMask);
+
+    // 最後に合成した振動
+    const XINPUT_VIBRATION& GetOutput(int slot) const;
+
+    // これまでに出力先へ書き込んだ回数
+    DWORD GetWriteCount() const;
+
+private:
+    struct Effect
+    {
+        HapticEffect effect;
+        LONGLONG start;     // 再生を始めた時刻（GetInputTimestamp の値）
+        int slot;           // -1 = 空き
+        WORD generation;    // 停止用の番号を使い回したときの区別
+    };
+
+    // 効果の経過時間に対する強さ（0.0f ~ 1.0f、終わっていたら -1.0f）
+    static float Evaluate(const HapticEffect& effect, float elapsedMs);
+
+    // 合成した強さをモーターの速さにする（0.0f ~ 1.0f に収める）
+    static WORD ToMotorSpeed(float level);
+
+    CXInputHapticsSink m_xinputSink;
+    IHapticsSink* m_sink;
+
+    Effect m_effects[MAX_EFFECTS];
+    int m_effectCount;                          // 使用中の効果の数（全部空きなら合成を省く）
+
+    float m_baseLeft[XUSER_MAX_COUNT];
+    float m_baseRight[XUSER_MAX_COUNT];
+
+    XINPUT_VIBRATION m_output[XUSER_MAX_COUNT]; // 合成結果
+    XINPUT_VIBRATION m_written[XUSER_MAX_COUNT];// 最後に書き込んだ値
+    bool m_isWritten[XUSER_MAX_COUNT];          // m_written が出力先の状態と一致しているか
+    DWORD m_writeCount;
+};
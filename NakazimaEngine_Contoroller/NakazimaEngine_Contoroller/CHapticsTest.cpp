@@ -0,0 +1,132 @@
+#include "CSelfTest.h"
+#include "CHaptics.h"
+#include "CInputEventLog.h"
+
+namespace
+{
+    // ミリ秒を GetInputTimestamp の単位にする
+    LONGLONG Ms(double ms)
+    {
+        return static_cast<LONGLONG>(ms * GetInputTimestampFrequency() / 1000.0);
+    }
+
+    const BYTE ALL_CONNECTED = (1 << XUSER_MAX_COUNT) - 1;
+}
+
+//------------------------------------------------------------------------------
+// 合成結果が変わらなければ書き込まない
+//------------------------------------------------------------------------------
+SELF_TEST(HapticsCoalesceWrites)
+{
+    CMockHapticsSink sink;
+    CHaptics haptics;
+    haptics.SetSink(&sink);
+
+    // 最初の Update は出力先の状態が分からないので、接続中のスロットすべてに書く
+    haptics.Update(Ms(0), 0x01);
+    SELF_CHECK(sink.writeCount[0] == 1 && sink.writeCount[1] == 0);
+
+    // 同じ強さを毎フレーム設定しても、書き込みは変わったときの1回だけ
+    for (int frame = 1; frame <= 600; ++frame)
+    {
+        haptics.SetBase(0, 0.5f, 0.25f);
+        haptics.Update(Ms(frame * 16.0), 0x01);
+    }
+    SELF_CHECK(sink.writeCount[0] == 2);
+    SELF_CHECK(sink.last[0].wLeftMotorSpeed == 32768 && sink.last[0].wRightMotorSpeed == 16384);
+    SELF_CHECK(haptics.GetWriteCount() == 2);
+
+    haptics.SetBase(0, 0.0f, 0.0f);
+    haptics.Update(Ms(10000), 0x01);
+    SELF_CHECK(sink.writeCount[0] == 3 && sink.last[0].wLeftMotorSpeed == 0);
+
+    // 未接続の間は書かず、接続されたら今の値を書き直す
+    haptics.SetBase(1, 1.0f, 1.0f);
+    haptics.Update(Ms(10016), 0x01);
+    SELF_CHECK(sink.writeCount[1] == 0);
+    haptics.Update(Ms(10032), 0x03);
+    haptics.Update(Ms(10048), 0x03);
+    SELF_CHECK(sink.writeCount[1] == 1 && sink.last[1].wLeftMotorSpeed == 65535);
+
+    // 出力先を差し替えたら、次の Update で書き直す
+    CMockHapticsSink other;
+    haptics.SetSink(&other);
+    haptics.Update(Ms(10064), 0x03);
+    SELF_CHECK(other.writeCount[0] == 1 && other.writeCount[1] == 1);
+}
+
+//------------------------------------------------------------------------------
+// 効果の再生：一定の振動は始まりと終わりの2回だけ書き込む
+//------------------------------------------------------------------------------
+SELF_TEST(HapticsEffectWrites)
+{
+    CMockHapticsSink sink;
+    CHaptics haptics;
+    haptics.SetSink(&sink);
+    haptics.Update(Ms(0), ALL_CONNECTED);
+    int first = sink.writeCount[2];
+
+    SELF_CHECK(haptics.Play(2, MakeHapticRumble(1.0f, 0.5f, 100.0f), Ms(0)) >= 0);
+    for (int frame = 0; frame <= 20; ++frame)
+        haptics.Update(Ms(frame * 10.0), ALL_CONNECTED);
+    SELF_CHECK(sink.writeCount[2] - first == 2);
+    SELF_CHECK(sink.last[2].wLeftMotorSpeed == 0 && sink.last[2].wRightMotorSpeed == 0);
+    SELF_CHECK(sink.writeCount[0] == 1);
+
+    // 効果と基本の強さは足し合わせ、1.0f で頭打ちにする
+    haptics.SetBase(2, 0.75f, 0.0f);
+    int handle = haptics.Play(2, MakeHapticRumble(0.5f, 0.5f, 1000.0f), Ms(1000));
+    haptics.Update(Ms(1010), ALL_CONNECTED);
+    SELF_CHECK(haptics.GetOutput(2).wLeftMotorSpeed == 65535 && haptics.GetOutput(2).wRightMotorSpeed == 32768);
+
+    // 止めたら基本の強さに戻る
+    haptics.Stop(handle);
+    haptics.Update(Ms(1020), ALL_CONNECTED);
+    SELF_CHECK(haptics.GetOutput(2).wLeftMotorSpeed == 49151 && haptics.GetOutput(2).wRightMotorSpeed == 0);
+
+    // 減衰は単調に下がって0で終わる
+    haptics.SetBase(2, 0.0f, 0.0f);
+    haptics.Play(2, MakeHapticDecay(1.0f, 1.0f, 200.0f), Ms(2000));
+    WORD previous = 65535;
+    bool decreasing = true;
+    for (int ms = 0; ms <= 220; ms += 10)
+    {
+        haptics.Update(Ms(2000 + ms), ALL_CONNECTED);
+        decreasing &= haptics.GetOutput(2).wLeftMotorSpeed <= previous;
+        previous = haptics.GetOutput(2).wLeftMotorSpeed;
+    }
+    SELF_CHECK(decreasing && previous == 0);
+}
+
+//------------------------------------------------------------------------------
+// 範囲外の値・スロット
+//------------------------------------------------------------------------------
+SELF_TEST(HapticsRange)
+{
+    CMockHapticsSink sink;
+    CHaptics haptics;
+    haptics.SetSink(&sink);
+
+    // 負の強さは0にする
+    haptics.SetBase(0, -0.5f, 2.0f);
+    haptics.Play(0, MakeHapticRumble(-1.0f, -1.0f, 100.0f), Ms(0));
+    haptics.Update(Ms(10), ALL_CONNECTED);
+    SELF_CHECK(haptics.GetOutput(0).wLeftMotorSpeed == 0 && haptics.GetOutput(0).wRightMotorSpeed == 65535);
+
+    // 範囲外のスロットは受け付けない
+    SELF_CHECK(haptics.Play(-1, MakeHapticRumble(1.0f, 1.0f, 100.0f), Ms(0)) == -1);
+    SELF_CHECK(haptics.Play(XUSER_MAX_COUNT, MakeHapticRumble(1.0f, 1.0f, 100.0f), Ms(0)) == -1);
+    haptics.SetBase(XUSER_MAX_COUNT, 1.0f, 1.0f);
+    haptics.SetBase(-1, 1.0f, 1.0f);
+    haptics.Update(Ms(20), ALL_CONNECTED);
+    for (int i = 1; i < XUSER_MAX_COUNT; ++i)
+        SELF_CHECK(haptics.GetOutput(i).wLeftMotorSpeed == 0 && haptics.GetOutput(i).wRightMotorSpeed == 0);
+
+    // 空きがなくなったら -1
+    int played = 0;
+    while (haptics.Play(1, MakeHapticRumble(0.0f, 0.0f, 1000.0f), Ms(20)) >= 0)
+        ++played;
+    SELF_CHECK(played == CHaptics::MAX_EFFECTS - 1);
+    haptics.StopAll(1);
+    SELF_CHECK(haptics.Play(1, MakeHapticRumble(0.0f, 0.0f, 1000.0f), Ms(20)) >= 0);
+}
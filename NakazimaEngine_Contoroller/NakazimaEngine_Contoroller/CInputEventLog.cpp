@@ -0,0 +1,57 @@
+#include "CInputEventLog.h"
+
+//------------------------------------------------------------------------------
+// コンストラクタ
+//------------------------------------------------------------------------------
+CInputEventLog::CInputEventLog()
+    : m_total(0)
+{
+    ZeroMemory(m_records, sizeof(m_records));
+}
+
+//------------------------------------------------------------------------------
+// 記録の追加（満杯なら一番古い記録を上書き）
+//------------------------------------------------------------------------------
+void CInputEventLog::Push(const InputEventRecord& record)
+{
+    m_records[m_total & (CAPACITY - 1)] = record;
+    ++m_total;
+}
+
+void CInputEventLog::Clear()
+{
+    m_total = 0;
+}
+
+unsigned int CInputEventLog::GetCount() const
+{
+    return m_total < CAPACITY ? m_total : CAPACITY;
+}
+
+//------------------------------------------------------------------------------
+// 古い順に index 番目の記録
+//------------------------------------------------------------------------------
+const InputEventRecord& CInputEventLog::At(unsigned int index) const
+{
+    unsigned int oldest = m_total - GetCount();
+    return m_records[(oldest + index) & (CAPACITY - 1)];
+}
+
+//------------------------------------------------------------------------------
+// frame 以降の最初の記録の位置
+// 記録はフレーム番号の昇順に並んでいるので二分探索できる
+//------------------------------------------------------------------------------
+unsigned int CInputEventLog::FindFirstSince(DWORD frame) const
+{
+    unsigned int low = 0;
+    unsigned int high = GetCount();
+    while (low < high)
+    {
+        unsigned int mid = low + (high - low) / 2;
+        if (At(mid).frame < frame)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
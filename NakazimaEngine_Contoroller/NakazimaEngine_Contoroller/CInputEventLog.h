@@ -0,0 +1,88 @@
+#pragma once
+#include <windows.h>
+
+//------------------------------------------------------------------------------
+// 入力のタイムスタンプ
+// Window と同じ QueryPerformanceCounter の値をそのまま使う
+//------------------------------------------------------------------------------
+inline LONGLONG GetInputTimestamp()
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+// タイムスタンプの1秒あたりのカウント数
+inline LONGLONG GetInputTimestampFrequency()
+{
+    static LONGLONG s_freq = 0;
+    if (s_freq == 0)
+    {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        s_freq = freq.QuadPart;
+    }
+    return s_freq;
+}
+
+//------------------------------------------------------------------------------
+// 記録する入力の種類
+//------------------------------------------------------------------------------
+enum InputEventDevice : BYTE
+{
+    INPUT_EVENT_KEY,            // キーボード（code = 仮想キーコード）
+    INPUT_EVENT_PAD_BUTTON,     // ゲームパッドのボタン（code = XINPUT_GAMEPAD_A 等のビット）
+    INPUT_EVENT_PAD_TRIGGER,    // ゲームパッドのトリガー（code = 0:左 1:右）
+    INPUT_EVENT_PAD_CONNECTION, // ゲームパッドの接続 / 切断（code = 0）
+};
+
+//------------------------------------------------------------------------------
+// InputEventRecord
+// 入力の変化1回分の記録
+//------------------------------------------------------------------------------
+struct InputEventRecord
+{
+    LONGLONG timestamp; // 変化を検出した時刻（GetInputTimestamp の値）
+    DWORD frame;        // 反映された Update のフレーム番号
+    DWORD code;         // キーコード / ボタンのビット / トリガー番号
+    BYTE device;        // InputEventDevice
+    BYTE slot;          // ゲームパッドのスロット番号（キーボードは0）
+    bool down;          // true = 押された（接続された）、false = 離された（切断された）
+};
+
+//------------------------------------------------------------------------------
+// CInputEventLog
+// 入力の変化を固定サイズのリングバッファに記録する（メモリ確保なし）
+// 満杯になったら古い記録から上書きする
+//------------------------------------------------------------------------------
+class CInputEventLog
+{
+public:
+    static const unsigned int CAPACITY = 1024; // 2のべき乗
+
+    CInputEventLog();
+
+    void Push(const InputEventRecord& record);
+    void Clear();
+
+    // 保持している記録の数と、古い順に index 番目の記録
+    unsigned int GetCount() const;
+    const InputEventRecord& At(unsigned int index) const;
+
+    // frame 以降のフレームに反映された記録を古い順に func(record) へ渡す
+    // 保持している範囲より前は、すでに上書きされているので渡されない
+    template<class Func>
+    void ForEachSince(DWORD frame, Func func) const
+    {
+        unsigned int count = GetCount();
+        for (unsigned int i = FindFirstSince(frame); i < count; ++i)
+            func(At(i));
+    }
+
+private:
+    // frame 以降の最初の記録の位置（二分探索）
+    unsigned int FindFirstSince(DWORD frame) const;
+
+    InputEventRecord m_records[CAPACITY];
+    unsigned int m_total; // これまでに記録した総数
+};
@@ -0,0 +1,171 @@
+#include "CInputHistory.h"
+
+#ifdef INPUTLANES_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+#ifdef INPUTLANES_USE_SSE2
+    // 2bit の値 → 2レーン分の bit0
+    alignas(16) const uint64_t LANE_BITS[4][2] =
+    {
+        { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 },
+    };
+
+    // 全レーンのビット列を1フレーム分ずらし、このフレームの値を bit0 に入れる（SSE2 で2レーンずつ）
+    void ShiftMasks(uint64_t* masks, const InputLaneBits& bits)
+    {
+        for (int w = 0; w < INPUT_LANE_WORD_COUNT; ++w)
+        {
+            uint64_t word = bits.word[w];
+            __m128i* lane = reinterpret_cast<__m128i*>(masks + w * 64);
+            for (int b = 0; b < 32; ++b)
+            {
+                __m128i bit = _mm_load_si128(reinterpret_cast<const __m128i*>(LANE_BITS[(word >> (b * 2)) & 3]));
+                _mm_store_si128(lane + b, _mm_or_si128(_mm_slli_epi64(_mm_load_si128(lane + b), 1), bit));
+            }
+        }
+    }
+#else
+    // 全レーンのビット列を1フレーム分ずらし、このフレームの値を bit0 に入れる
+    void ShiftMasks(uint64_t* masks, const InputLaneBits& bits)
+    {
+        for (int w = 0; w < INPUT_LANE_WORD_COUNT; ++w)
+        {
+            uint64_t word = bits.word[w];
+            uint64_t* lane = masks + w * 64;
+            for (int b = 0; b < 64; ++b)
+                lane[b] = (lane[b] << 1) | ((word >> b) & 1);
+        }
+    }
+#endif
+}
+
+//------------------------------------------------------------------------------
+// コンストラクタ
+//------------------------------------------------------------------------------
+CInputHistory::CInputHistory()
+    : m_pushCount(0)
+    , m_idleFrames(0)
+{
+    SetDepth(DEFAULT_DEPTH);
+}
+
+//------------------------------------------------------------------------------
+// リングの深さを変える
+//------------------------------------------------------------------------------
+void CInputHistory::SetDepth(int frames)
+{
+    int depth = MASK_DEPTH;
+    while (depth < frames && depth < MAX_DEPTH)
+        depth <<= 1;
+
+    if (depth != GetDepth())
+    {
+        // 確保し直して、余った分も返す
+        std::vector<Frame>(depth).swap(m_frames);
+    }
+    Reset();
+}
+
+int CInputHistory::GetDepth() const
+{
+    return static_cast<int>(m_frames.size());
+}
+
+//------------------------------------------------------------------------------
+// 記録を消す
+//------------------------------------------------------------------------------
+void CInputHistory::Reset()
+{
+    m_pushCount = 0;
+    m_idleFrames = 0;
+    ZeroMemory(m_pressMask, sizeof(m_pressMask));
+    ZeroMemory(m_triggerMask, sizeof(m_triggerMask));
+    ZeroMemory(m_releaseMask, sizeof(m_releaseMask));
+}
+
+//------------------------------------------------------------------------------
+// フレームの結果を追加する
+//------------------------------------------------------------------------------
+void CInputHistory::Push(const InputFrame& frame, bool changed)
+{
+    Frame& slot = m_frames[m_pushCount & (m_frames.size() - 1)];
+
+    // 変わらないフレームはリングに前のフレームの押下を写すだけにし、ビット列は後でまとめてずらす
+    if (!changed && m_pushCount > 0)
+    {
+        slot.press = m_frames[(m_pushCount - 1) & (m_frames.size() - 1)].press;
+        slot.trigger.Clear();
+        slot.release.Clear();
+        ++m_pushCount;
+        if (m_idleFrames < MASK_DEPTH)
+            ++m_idleFrames;
+        return;
+    }
+
+    FlushIdle();
+    PackInputLanes(frame, slot.press, slot.trigger, slot.release);
+    ++m_pushCount;
+
+    ShiftMasks(m_pressMask, slot.press);
+    ShiftMasks(m_triggerMask, slot.trigger);
+    ShiftMasks(m_releaseMask, slot.release);
+}
+
+//------------------------------------------------------------------------------
+// ずらしていないフレームの分を反映する
+// その間は押下が前のフレーム（リングの最新）のまま、エッジはなかった
+//------------------------------------------------------------------------------
+void CInputHistory::FlushIdle()
+{
+    if (m_idleFrames == 0)
+        return;
+
+    for (int lane = 0; lane < INPUT_LANE_COUNT; ++lane)
+    {
+        m_pressMask[lane] = GetPressMask(lane);
+        m_triggerMask[lane] = GetTriggerMask(lane);
+        m_releaseMask[lane] = GetReleaseMask(lane);
+    }
+    m_idleFrames = 0;
+}
+
+DWORD CInputHistory::GetPushCount() const
+{
+    return m_pushCount;
+}
+
+int CInputHistory::GetCount() const
+{
+    return m_pushCount < m_frames.size() ? static_cast<int>(m_pushCount) : GetDepth();
+}
+
+//------------------------------------------------------------------------------
+// framesAgo フレーム前の状態
+//------------------------------------------------------------------------------
+const CInputHistory::Frame* CInputHistory::GetFrame(int framesAgo) const
+{
+    if (framesAgo < 0 || framesAgo >= GetCount())
+        return nullptr;
+    return &m_frames[(m_pushCount - 1 - framesAgo) & (m_frames.size() - 1)];
+}
+
+//------------------------------------------------------------------------------
+// 最後に立ったフレームが何フレーム前か
+// 直近 MASK_DEPTH フレームならビット列の最下位ビットの位置、それより前はリングを探す
+//------------------------------------------------------------------------------
+int CInputHistory::FramesSince(uint64_t mask, int lane, InputLaneBits Frame::*bits) const
+{
+    if (mask != 0)
+        return CountTrailingZeros64(mask);
+
+    int count = GetCount();
+    for (int framesAgo = MASK_DEPTH; framesAgo < count; ++framesAgo)
+    {
+        if ((GetFrame(framesAgo)->*bits).Test(lane))
+            return framesAgo;
+    }
+    return -1;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+#include "InputLanes.h"
+
+//------------------------------------------------------------------------------
+// CInputHistory
+// 過去のフレームの入力を残しておき、先行入力などの判定に使う
+//   ・レーンごとの直近 MASK_DEPTH フレームのビット列（bit k = k フレーム前）
+//     「K フレーム以内に押したか」「離してから何フレームか」はビット演算1~2回で済む
+//   ・全レーンの状態をフレームごとに詰めたリング（深さは SetDepth で決める）
+//     MASK_DEPTH より前のフレームを調べるときに使う
+// メモリは SetDepth の深さ × 約150byte と、レーンごとの固定分（約10KB）だけ
+// 入力が変わらないフレームはビット列をずらさずに数えておき、調べるとき・次に変わったときにずらす
+//------------------------------------------------------------------------------
+class CInputHistory
+{
+public:
+    static const int MASK_DEPTH = 64;       // ビット列で調べられるフレーム数
+    static const int DEFAULT_DEPTH = 256;   // リングの既定の深さ（フレーム数）
+    static const int MAX_DEPTH = 4096;
+
+    //--------------------------------------
+    // 1フレーム分の全レーンの状態
+    //--------------------------------------
+    struct Frame
+    {
+        InputLaneBits press;    // 押されている
+        InputLaneBits trigger;  // 押された瞬間
+        InputLaneBits release;  // 離された瞬間
+    };
+
+    CInputHistory();
+
+    // リングの深さを変える（2のべき乗に切り上げ、MASK_DEPTH ~ MAX_DEPTH）
+    // 変えたときは記録を消す
+    void SetDepth(int frames);
+    int GetDepth() const;
+
+    // 記録を消す
+    void Reset();
+
+    // フレームの結果を追加する（CInputManager::Update から毎フレーム呼ぶ）
+    // changed = false なら、frame は前のフレームと同じ押下でエッジなしとみなしてよい
+    void Push(const InputFrame& frame, bool changed = true);
+
+    // 追加したフレーム数と、残っているフレーム数（最大 GetDepth()）
+    DWORD GetPushCount() const;
+    int GetCount() const;
+
+    //--------------------------------------
+    // 直近 MASK_DEPTH フレームの判定（frames = 1 ならこのフレームだけ）
+    //--------------------------------------
+    bool WasTriggeredWithin(int lane, int frames) const { return (GetTriggerMask(lane) & WindowMask(frames)) != 0; }
+    bool WasReleasedWithin(int lane, int frames) const { return (GetReleaseMask(lane) & WindowMask(frames)) != 0; }
+    bool WasPressedWithin(int lane, int frames) const { return (GetPressMask(lane) & WindowMask(frames)) != 0; }
+
+    // frames フレームの間ずっと押されていたか
+    bool WasHeldFor(int lane, int frames) const { return (~GetPressMask(lane) & WindowMask(frames)) == 0; }
+
+    // 最後に押した瞬間・離した瞬間から何フレームか（このフレームなら0、残っていなければ -1）
+    int GetFramesSinceTrigger(int lane) const { return FramesSince(GetTriggerMask(lane), lane, &Frame::trigger); }
+    int GetFramesSinceRelease(int lane) const { return FramesSince(GetReleaseMask(lane), lane, &Frame::release); }
+
+    // レーンごとのビット列（bit k = k フレーム前）
+    uint64_t GetPressMask(int lane) const { return Delay(m_pressMask[lane], IsPressNow(lane)); }
+    uint64_t GetTriggerMask(int lane) const { return Delay(m_triggerMask[lane], false); }
+    uint64_t GetReleaseMask(int lane) const { return Delay(m_releaseMask[lane], false); }
+
+    //--------------------------------------
+    // リングの参照
+    //--------------------------------------
+    // framesAgo フレーム前の状態（0 = このフレーム、残っていなければ nullptr）
+    const Frame* GetFrame(int framesAgo) const;
+
+private:
+    // 下位 frames ビットが立ったマスク（1 ~ MASK_DEPTH に丸める）
+    static uint64_t WindowMask(int frames)
+    {
+        if (frames <= 0)
+            return 0;
+        return frames >= MASK_DEPTH ? ~0ULL : (1ULL << frames) - 1;
+    }
+
+    // ずらしていないフレームの分だけビット列をずらす（その間の値は fill）
+    uint64_t Delay(uint64_t mask, bool fill) const
+    {
+        if (m_idleFrames == 0)
+            return mask;
+        return (m_idleFrames >= MASK_DEPTH ? 0 : mask << m_idleFrames) | (fill ? WindowMask(m_idleFrames) : 0);
+    }
+
+    // このフレームで押されているか
+    bool IsPressNow(int lane) const { return m_pushCount > 0 && GetFrame(0)->press.Test(lane); }
+
+    // ずらしていないフレームの分を、全レーンのビット列に反映する
+    void FlushIdle();
+
+    // ビット列になければリングを MASK_DEPTH フレーム前から探す
+    int FramesSince(uint64_t mask, int lane, InputLaneBits Frame::*bits) const;
+
+    std::vector<Frame> m_frames;    // リング（要素数は2のべき乗）
+    DWORD m_pushCount;              // これまでに追加したフレーム数
+    int m_idleFrames;               // ビット列をまだずらしていない、入力が変わらなかったフレーム数（最大 MASK_DEPTH）
+
+    alignas(16) uint64_t m_pressMask[INPUT_LANE_COUNT];
+    alignas(16) uint64_t m_triggerMask[INPUT_LANE_COUNT];
+    alignas(16) uint64_t m_releaseMask[INPUT_LANE_COUNT];
+};
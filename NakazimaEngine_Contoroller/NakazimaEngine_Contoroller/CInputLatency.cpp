@@ -0,0 +1,112 @@
+#include "CInputLatency.h"
+#include <cstdio>
+
+//------------------------------------------------------------------------------
+// コンストラクタ
+//------------------------------------------------------------------------------
+CInputLatency::CInputLatency()
+{
+    Reset();
+}
+
+void CInputLatency::Reset()
+{
+    for (int i = 0; i < INPUT_LATENCY_COUNT; ++i)
+        m_histogram[i].Reset();
+    ZeroMemory(m_sum, sizeof(m_sum));
+    ZeroMemory(m_max, sizeof(m_max));
+    m_lastFrame = 0;
+    m_hasLastFrame = false;
+}
+
+//------------------------------------------------------------------------------
+// Present の直後に呼ぶ
+// ログは反映したフレームの順に並んでいるので、まだ数えていないフレーム以降を探して frame までの分を数える
+//------------------------------------------------------------------------------
+void CInputLatency::OnPresent(const CInputEventLog& log, DWORD frame, LONGLONG presentTime)
+{
+    if (m_hasLastFrame && frame == m_lastFrame)
+        return;
+    DWORD first = (m_hasLastFrame && frame - m_lastFrame < MAX_FRAMES_PER_PRESENT) ? m_lastFrame + 1 : frame;
+    m_lastFrame = frame;
+    m_hasLastFrame = true;
+
+    LONGLONG freq = GetInputTimestampFrequency();
+    log.ForEachSince(first, [&](const InputEventRecord& e)
+    {
+        if (e.frame > frame || e.device == INPUT_EVENT_PAD_CONNECTION)
+            return;
+
+        LONGLONG elapsed = presentTime - e.timestamp;
+        DWORD us = (elapsed > 0) ? static_cast<DWORD>(elapsed * 1000000 / freq) : 0;
+        Record(INPUT_LATENCY_ALL, us);
+        Record(e.device == INPUT_EVENT_KEY ? INPUT_LATENCY_KEY : INPUT_LATENCY_PAD, us);
+    });
+}
+
+void CInputLatency::Record(int series, DWORD us)
+{
+    m_histogram[series].Add(us);
+    m_sum[series] += us;
+    if (us > m_max[series])
+        m_max[series] = us;
+}
+
+//------------------------------------------------------------------------------
+// 統計の取得
+//------------------------------------------------------------------------------
+FrameStatsSummary CInputLatency::GetSummary(InputLatencySeries series) const
+{
+    return m_histogram[series].GetSummary(m_sum[series], m_max[series]);
+}
+
+const CFrameHistogram& CInputLatency::GetHistogram(InputLatencySeries series) const
+{
+    return m_histogram[series];
+}
+
+//------------------------------------------------------------------------------
+// テキストで書き出す
+//   1行目からは 種類ごとの統計（ミリ秒）、その後に空でない区間の 代表値（マイクロ秒）と数
+//------------------------------------------------------------------------------
+bool CInputLatency::Dump(const wchar_t* path) const
+{
+    static const char* const NAMES[INPUT_LATENCY_COUNT] = { "all", "key", "pad" };
+
+    HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    char line[256];
+    DWORD dwWritten;
+    bool ok = true;
+    auto write = [&](int length)
+    {
+        if (length > 0 && !WriteFile(file, line, static_cast<DWORD>(length), &dwWritten, nullptr))
+            ok = false;
+    };
+
+    write(snprintf(line, sizeof(line), "# input-to-present latency\n# series count mean_ms p50_ms p90_ms p99_ms p99.9_ms max_ms\n"));
+    for (int i = 0; i < INPUT_LATENCY_COUNT; ++i)
+    {
+        FrameStatsSummary s = GetSummary(static_cast<InputLatencySeries>(i));
+        write(snprintf(line, sizeof(line), "%s %lu %.3f %.3f %.3f %.3f %.3f %.3f\n",
+            NAMES[i], static_cast<unsigned long>(s.count), s.meanMs, s.p50Ms, s.p90Ms, s.p99Ms, s.p999Ms, s.maxMs));
+    }
+
+    write(snprintf(line, sizeof(line), "# series bucket_us count\n"));
+    for (int i = 0; i < INPUT_LATENCY_COUNT; ++i)
+    {
+        for (int b = 0; b < CFrameHistogram::BUCKET_COUNT; ++b)
+        {
+            DWORD count = m_histogram[i].GetBucketCount(b);
+            if (count == 0)
+                continue;
+            write(snprintf(line, sizeof(line), "%s %lu %lu\n",
+                NAMES[i], static_cast<unsigned long>(CFrameHistogram::GetBucketValue(b)), static_cast<unsigned long>(count)));
+        }
+    }
+
+    CloseHandle(file);
+    return ok;
+}
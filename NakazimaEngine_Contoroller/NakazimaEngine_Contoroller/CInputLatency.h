@@ -0,0 +1,54 @@
+#pragma once
+#include <windows.h>
+#include "CFrameStats.h"
+#include "CInputEventLog.h"
+
+//------------------------------------------------------------------------------
+// 遅延を集計する入力の種類
+//------------------------------------------------------------------------------
+enum InputLatencySeries : BYTE
+{
+    INPUT_LATENCY_ALL,          // キーとパッドの全部
+    INPUT_LATENCY_KEY,          // キーボード
+    INPUT_LATENCY_PAD,          // ゲームパッドのボタン・トリガー
+    INPUT_LATENCY_COUNT,
+};
+
+//------------------------------------------------------------------------------
+// CInputLatency
+// 入力の変化から、それを反映したフレームを Present に渡すまでの時間を集計する
+// 変化は CInputEventLog に検出した時刻と反映したフレーム番号付きで残っているので、
+// Present の直後にそのフレームの変化を探して 時刻の差 を記録する
+// （接続・切断は操作ではないので数えない）
+//------------------------------------------------------------------------------
+class CInputLatency
+{
+public:
+    CInputLatency();
+
+    void Reset();
+
+    // frame の入力を反映した画面を presentTime に Present に渡した
+    // 前回渡したフレームの次から frame までをまとめて数える（固定ティックで1回の描画に複数回 Update した場合）
+    // 同じフレームを2回渡しても2回目は数えない
+    void OnPresent(const CInputEventLog& log, DWORD frame, LONGLONG presentTime);
+
+    FrameStatsSummary GetSummary(InputLatencySeries series) const;
+    const CFrameHistogram& GetHistogram(InputLatencySeries series) const;
+
+    // 統計とヒストグラムをテキストで書き出す
+    bool Dump(const wchar_t* path) const;
+
+private:
+    // 1回の Present でまとめて数えるフレーム数の上限（それより前のフレームは画面に出なかったものとする）
+    static const DWORD MAX_FRAMES_PER_PRESENT = 16;
+
+    void Record(int series, DWORD us);
+
+    CFrameHistogram m_histogram[INPUT_LATENCY_COUNT];
+    ULONGLONG m_sum[INPUT_LATENCY_COUNT];
+    DWORD m_max[INPUT_LATENCY_COUNT];
+
+    DWORD m_lastFrame;          // 最後に数えたフレーム
+    bool m_hasLastFrame;
+};
@@ -1,30 +1,51 @@
 #include "CInputManager.h"
+#include "Main.h"
+#include <Dbt.h>
 #include <algorithm>
+#include <climits>
 
 //------------------------------------------------------------------------------
 // インスタンス取得（唯一のインスタンスを返す）
 //------------------------------------------------------------------------------
-CInputManager& CInputManager::GetInstance()
-{
-    static CInputManager instance;
-    return instance;
-}
+CInputManager CInputManager::s_instance;
 
 //------------------------------------------------------------------------------
 // コンストラクタ
 //------------------------------------------------------------------------------
 CInputManager::CInputManager()
+    : m_frame(0)
+    , m_dirtyMask(0)
+    , m_keyPadChanged(false)
+    , m_forcePadUpdate(false)
+    , m_keyboard(&m_messageKeyboard)
+    , m_padCount(MAX_PAD_COUNT)
+    , m_padBackend(&m_xinputBackend)
+    , m_hapticsSink(nullptr)
+    , m_savedKeyboard(nullptr)
+    , m_sampleCount(0)
+    , m_hasHeldSample(false)
+    , m_heldKeyCount(0)
+    , m_replayingFrame(false)
 {
-    // キー入力配列を初期化
-    ZeroMemory(m_keyTable, sizeof(m_keyTable));
-    ZeroMemory(m_oldKeyTable, sizeof(m_oldKeyTable));
+    // キー入力ビットセットを初期化
+    m_keyTable.Clear();
+    m_oldKeyTable.Clear();
+    m_keyTrigger.Clear();
+    m_keyRelease.Clear();
+
+    // ゲームパッド入力状態を初期化（未接続状態）
+    // 確認待ちは0にして、最初の Update で全スロットを確認する
+    ZeroMemory(m_pads, sizeof(m_pads));
+    for (int i = 0; i < MAX_PAD_COUNT; ++i)
+        m_pads[i].probeInterval = PAD_PROBE_INTERVAL_MIN;
+    m_haptics.SetSink(m_padBackend);
 
-    // ゲームパッド入力状態を初期化
-    ZeroMemory(&m_state, sizeof(m_state));
-    ZeroMemory(&m_oldstate, sizeof(m_oldstate));
+    // スティックは XInput 推奨のデッドゾーンから始める
+    m_stickResponse[STICK_LEFT].Configure(GetDefaultStickSettings(XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE / 32767.0f));
+    m_stickResponse[STICK_RIGHT].Configure(GetDefaultStickSettings(XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE / 32767.0f));
 
-    // 振動を初期化（停止状態）
-    ZeroMemory(&m_vibration, sizeof(m_vibration));
+    m_replayFrame.Clear();
+    m_inputFrame.Clear();
 }
 
 //------------------------------------------------------------------------------
@@ -33,140 +54,931 @@ CInputManager::CInputManager()
 //------------------------------------------------------------------------------
 void CInputManager::Update()
 {
-    //--- キーボード更新 ---
-    for (int i = 0; i < 256; ++i)
+    Update(LLONG_MAX);
+}
+
+//------------------------------------------------------------------------------
+// until までの入力を反映する更新処理
+//------------------------------------------------------------------------------
+void CInputManager::Update(LONGLONG until)
+{
+    ++m_frame;
+
+    // 再生中は記録から1フレーム分を読み出す（最後まで再生したら実際の入力に戻る）
+    // 記録はフレーム単位なので、時刻では分けずにすべて反映する
+    m_replayingFrame = ReadReplayFrame();
+    if (m_replayingFrame)
+        until = LLONG_MAX;
+
+    // バックグラウンドサンプリング中は、溜まったサンプルを先に取り出しておく
+    FetchSamples(until);
+
+    m_dirtyMask = 0;
+    UpdateKeyboard(until);
+    UpdatePads();
+    m_mouse.Update();
+    if (m_mouse.IsChanged())
+        m_dirtyMask |= INPUT_DIRTY_MOUSE;
+
+    // このフレームの結果をまとめて、アクションの評価と記録に使う
+    // キー・パッドが前のフレームから変わっていなければ、結果はフレーム時間しか変わらない
+    // （前のフレームで変わった場合は、エッジを消すためにまとめ直す）
+    bool changed = (m_dirtyMask & (INPUT_DIRTY_KEYBOARD | INPUT_DIRTY_PADS)) != 0;
+    if (changed || m_keyPadChanged)
+        BuildFrame(m_inputFrame);
+    else
+        m_inputFrame.frameTimeUs = GetFrameTimeUs();
+    m_keyPadChanged = changed;
+
+    m_timers.Update(m_inputFrame, changed);
+    m_history.Push(m_inputFrame, changed);
+    m_actionMap.Evaluate(m_inputFrame, changed);
+    if (m_recorder.IsOpen())
+        m_recorder.Write(m_inputFrame);
+
+    PublishSnapshot();
+}
+
+//------------------------------------------------------------------------------
+// サンプリングスレッドが積んだ until までのサンプルをすべて取り出す
+// until より後のサンプルは1つだけ手元に残し、次の Update の最初に使う
+// （サンプルは時刻順に積まれるので、それ以降はリングに残しておけばよい）
+//------------------------------------------------------------------------------
+void CInputManager::FetchSamples(LONGLONG until)
+{
+    m_sampleCount = 0;
+    if (!m_sampler.IsRunning())
+        return;
+
+    if (m_hasHeldSample)
+    {
+        if (m_heldSample.timestamp > until)
+        {
+            m_sampledKeyboard.SetSamples(m_samples, 0);
+            return;
+        }
+        m_samples[m_sampleCount++] = m_heldSample;
+        m_hasHeldSample = false;
+    }
+
+    while (m_sampleCount < static_cast<int>(CInputSampler::RING_SIZE) &&
+        m_sampler.Pop(m_samples[m_sampleCount]))
+    {
+        if (m_samples[m_sampleCount].timestamp > until)
+        {
+            m_heldSample = m_samples[m_sampleCount];
+            m_hasHeldSample = true;
+            break;
+        }
+        ++m_sampleCount;
+    }
+    m_sampledKeyboard.SetSamples(m_samples, m_sampleCount);
+}
+
+//------------------------------------------------------------------------------
+// キーボード更新
+//------------------------------------------------------------------------------
+void CInputManager::UpdateKeyboard(LONGLONG until)
+{
+    // 前フレームの状態を保存
+    m_oldKeyTable = m_keyTable;
+    m_keyTrigger.Clear();
+    m_keyRelease.Clear();
+
+    // 前回の Update 以降に溜まったキーイベントを順番に反映する
+    // 処理量はイベント数に比例し、何も押していなければほぼ0
+    // 1フレーム内で押して離した場合も Trigger と Release の両方が立つ
+    KeyEvent events[KEY_EVENT_BATCH];
+    int count;
+
+    // サンプリング・再生中は、元の取得元のイベントは読み捨てる（溢れさせないため）
+    if (m_savedKeyboard)
     {
-        // 前フレームの状態を保存
-        m_oldKeyTable[i] = m_keyTable[i];
+        m_savedKeyboard->BeginFrame(LLONG_MAX);
+        while (m_savedKeyboard->Fetch(events, ARRAYSIZE(events)) > 0)
+        {
+        }
+    }
 
-        // 現在のキー状態を取得（押されているなら1、押されていなければ0）
-        m_keyTable[i] = (GetAsyncKeyState(i) & 0x8000) ? 1 : 0;
+    // 前回持ち越したイベントから始める
+    // 持ち越しがまだ until より後で取得元を読まなくても、取得元のフレームは進める
+    m_keyboard->BeginFrame(until);
+    count = m_heldKeyCount;
+    CopyMemory(events, m_heldKeys, sizeof(KeyEvent) * count);
+    m_heldKeyCount = 0;
+
+    while (count > 0 || (count = m_keyboard->Fetch(events, ARRAYSIZE(events))) > 0)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            // until より後のイベントは、残りごと次の Update に持ち越す
+            // （取得元にまだ残っているイベントは、次の Update でその後に読む）
+            if (events[i].timestamp > until)
+            {
+                m_heldKeyCount = count - i;
+                CopyMemory(m_heldKeys, events + i, sizeof(KeyEvent) * m_heldKeyCount);
+                return;
+            }
+
+            int key = events[i].key;
+            LogEvent(INPUT_EVENT_KEY, 0, key, events[i].down, events[i].timestamp);
+            m_dirtyMask |= INPUT_DIRTY_KEYBOARD;
+            if (events[i].down)
+            {
+                m_keyTable.Set(key);
+                m_keyTrigger.Set(key);
+            }
+            else
+            {
+                m_keyTable.Reset(key);
+                m_keyRelease.Set(key);
+            }
+        }
+        count = 0;
     }
+}
 
-    //このフレームで入力したキーを保存
-    m_oldstate = m_state;
+//------------------------------------------------------------------------------
+// ゲームパッド更新
+// 使用中の全スロットを1回のループでまとめて更新する
+//------------------------------------------------------------------------------
+void CInputManager::UpdatePads()
+{
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        PadSlot& pad = m_pads[i];
 
-    //--- ゲームパッド更新 ---
+        //このフレームで入力したボタンを保存
+        pad.oldConnected = pad.connected;
+        pad.trigger = 0;
+        pad.release = 0;
+    }
 
-    ZeroMemory(&m_state, sizeof(XINPUT_STATE));
-    DWORD dwResult = XInputGetState(0, &m_state); // プレイヤー1のみ入力を取る
-    if (dwResult != ERROR_SUCCESS)
+    if (m_replayingFrame)
     {
-        // 未接続の場合はすべて0
-        ZeroMemory(&m_state.Gamepad, sizeof(XINPUT_GAMEPAD));
+        ReplayPads();
     }
+    else if (m_sampler.IsRunning())
+    {
+        // サンプリング中は、前回からのサンプルを古い順に反映する（キーだけが変わったサンプルは飛ばす）
+        for (int s = 0; s < m_sampleCount; ++s)
+        {
+            const InputSample& sample = m_samples[s];
+            DWORD changedMask = 0;
+            for (int i = 0; i < m_padCount; ++i)
+            {
+                bool connected = (sample.connectedMask & (1 << i)) != 0;
+                if (connected != m_pads[i].connected || !IsSamePadState(sample.pads[i], m_pads[i].state))
+                    changedMask |= 1 << i;
+            }
+            if (changedMask == 0)
+                continue;
 
-    // アナログスティックのデッドゾーン処理
-    if ((m_state.Gamepad.sThumbLX < XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE &&
-        m_state.Gamepad.sThumbLX > -XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE) &&
-        (m_state.Gamepad.sThumbLY < XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE &&
-            m_state.Gamepad.sThumbLY > -XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE))
+            DWORD buttons[MAX_PAD_COUNT];
+            EvaluatePadButtons(sample.pads, buttons);
+            for (int i = 0; i < m_padCount; ++i)
+            {
+                if (changedMask & (1 << i))
+                    FoldPadState(i, sample.pads[i], buttons[i], (sample.connectedMask & (1 << i)) != 0, sample.timestamp);
+            }
+        }
+    }
+    else
     {
-        // 微小な入力を0として無視
-        m_state.Gamepad.sThumbLX = 0;
-        m_state.Gamepad.sThumbLY = 0;
+        PollPads();
     }
 
-    //--- 振動リセット ---
-    ZeroMemory(&m_vibration, sizeof(XINPUT_VIBRATION));
+    // 設定を変えたときは、状態が変わっていなくても全スロットを判定し直す
+    if (m_forcePadUpdate)
+    {
+        XINPUT_GAMEPAD states[MAX_PAD_COUNT];
+        for (int i = 0; i < m_padCount; ++i)
+            states[i] = m_pads[i].state;
+        DWORD buttons[MAX_PAD_COUNT];
+        EvaluatePadButtons(states, buttons);
+        LONGLONG timestamp = GetInputTimestamp();
+        for (int i = 0; i < m_padCount; ++i)
+            FoldPadState(i, states[i], buttons[i], m_pads[i].connected, timestamp);
+        m_dirtyMask |= (INPUT_DIRTY_PAD0 << m_padCount) - INPUT_DIRTY_PAD0;
+        m_forcePadUpdate = false;
+    }
 
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        if (m_pads[i].trigger | m_pads[i].release)
+            m_dirtyMask |= INPUT_DIRTY_PAD0 << i;
+    }
 
+    // スティックはどれかのスロットが変わったときだけ処理する（処理後の値はスロットに残っている）
+    if (m_dirtyMask & INPUT_DIRTY_PADS)
+        ProcessSticks();
+    UpdateHaptics();
 }
 
 //------------------------------------------------------------------------------
-// キーボード判定関数
+// 全スロットのスティックをまとめて処理する
+// 左スティック・右スティックそれぞれ、全スロット分を1回の呼び出しで処理する
 //------------------------------------------------------------------------------
-bool CInputManager::IsKeyPress(int key) const
+void CInputManager::ProcessSticks()
 {
-    return m_keyTable[key]; // 押されているか
+    SHORT x[STICK_COUNT][MAX_PAD_COUNT];
+    SHORT y[STICK_COUNT][MAX_PAD_COUNT];
+    float outX[STICK_COUNT][MAX_PAD_COUNT];
+    float outY[STICK_COUNT][MAX_PAD_COUNT];
+
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        const XINPUT_GAMEPAD& state = m_pads[i].state;
+        x[STICK_LEFT][i] = state.sThumbLX;
+        y[STICK_LEFT][i] = state.sThumbLY;
+        x[STICK_RIGHT][i] = state.sThumbRX;
+        y[STICK_RIGHT][i] = state.sThumbRY;
+    }
+
+    for (int stick = 0; stick < STICK_COUNT; ++stick)
+        m_stickResponse[stick].Process(x[stick], y[stick], outX[stick], outY[stick], m_padCount);
+
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        float* thumb = m_pads[i].thumb;
+        thumb[0] = outX[STICK_LEFT][i];
+        thumb[1] = outY[STICK_LEFT][i];
+        thumb[2] = outX[STICK_RIGHT][i];
+        thumb[3] = outY[STICK_RIGHT][i];
+    }
 }
 
-bool CInputManager::IsKeyTrigger(int key) const
+//------------------------------------------------------------------------------
+// ゲームパッドの取得元から状態を取得する（サンプリングしていないとき）
+// 接続中のスロットは毎フレーム、未接続のスロットは確認間隔ごとに取得
+// パケット番号が前回と同じスロット、取得した状態が反映済みの状態と同じスロットは何もしない
+// 変わったスロットがあれば、仮想ボタンを全スロットまとめて判定してから反映する
+//------------------------------------------------------------------------------
+void CInputManager::PollPads()
 {
-    return m_keyTable[key] && !m_oldKeyTable[key]; // 押された瞬間
+    XINPUT_GAMEPAD gamepads[MAX_PAD_COUNT];
+    bool connected[MAX_PAD_COUNT];
+    LONGLONG timestamps[MAX_PAD_COUNT];
+    DWORD changedMask = 0;
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        PadSlot& pad = m_pads[i];
+        if (!pad.connected && --pad.probeWait > 0)
+            continue;
+
+        // 取得元は成功すれば全体を書くので、ここでは0にしない
+        XINPUT_STATE state;
+        DWORD dwResult = m_padBackend->Read(i, state);
+        if (dwResult == ERROR_SUCCESS)
+        {
+            pad.probeInterval = PAD_PROBE_INTERVAL_MIN;
+
+            // 状態が変わるたびに番号が進むので、同じなら状態は読まなくてよい
+            if (pad.connected && pad.packetValid && state.dwPacketNumber == pad.packetNumber)
+                continue;
+            pad.packetNumber = state.dwPacketNumber;
+            pad.packetValid = true;
+            gamepads[i] = state.Gamepad;
+            connected[i] = true;
+        }
+        else
+        {
+            // 未接続の場合はすべて0
+            ZeroMemory(&gamepads[i], sizeof(XINPUT_GAMEPAD));
+            connected[i] = false;
+
+            // 切断直後は短い間隔から、見つからない間は間隔を伸ばしていく
+            if (pad.oldConnected)
+                pad.probeInterval = PAD_PROBE_INTERVAL_MIN;
+            pad.probeWait = pad.probeInterval;
+            pad.probeInterval = (std::min)(pad.probeInterval * 2, static_cast<int>(PAD_PROBE_INTERVAL_MAX));
+        }
+
+        // 番号が進んでも、反映済みの状態と同じなら何もしない（未接続のままのスロットも同じ）
+        if (connected[i] != pad.connected || !IsSamePadState(gamepads[i], pad.state))
+        {
+            timestamps[i] = GetInputTimestamp();
+            changedMask |= 1 << i;
+        }
+    }
+
+    if (changedMask == 0)
+        return;
+
+    // 変わっていないスロットは反映済みの状態で判定する（結果は今のボタンワードのまま）
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        if (!(changedMask & (1 << i)))
+            gamepads[i] = m_pads[i].state;
+    }
+    DWORD buttons[MAX_PAD_COUNT];
+    EvaluatePadButtons(gamepads, buttons);
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        if (changedMask & (1 << i))
+            FoldPadState(i, gamepads[i], buttons[i], connected[i], timestamps[i]);
+    }
 }
 
-bool CInputManager::IsKeyRelease(int key) const
+//------------------------------------------------------------------------------
+// 全スロットのボタンワードを求める
+// 仮想ボタンは各スロットの今のボタンワードを前回の状態として、押す・離すのしきい値を選ぶ
+//------------------------------------------------------------------------------
+void CInputManager::EvaluatePadButtons(const XINPUT_GAMEPAD* pads, DWORD* buttons) const
 {
-    return !m_keyTable[key] && m_oldKeyTable[key]; // 離された瞬間
+    for (int i = 0; i < m_padCount; ++i)
+        buttons[i] = m_pads[i].buttons;
+    m_virtualButtons.Process(pads, buttons, m_padCount);
 }
 
 //------------------------------------------------------------------------------
-// ゲームパッド判定
+// 取得したゲームパッド状態を1つ反映する
+// 前回反映した状態との差分を trigger / release に積算するので、
+// 1フレームに複数回呼べばフレーム内の押下・解放もすべて残る
+// 変化したボタン・トリガー・接続状態は timestamp 付きで記録する
 //------------------------------------------------------------------------------
-bool CInputManager::IsPadPress(WORD button) const
+void CInputManager::FoldPadState(int slot, const XINPUT_GAMEPAD& gamepad, DWORD buttons, bool connected, LONGLONG timestamp)
 {
-    return (m_state.Gamepad.wButtons & button) != 0;
+    PadSlot& pad = m_pads[slot];
+
+    if (buttons != pad.buttons || connected != pad.connected || !IsSamePadState(gamepad, pad.state))
+        m_dirtyMask |= INPUT_DIRTY_PAD0 << slot;
+
+    if (connected != pad.connected)
+        LogEvent(INPUT_EVENT_PAD_CONNECTION, static_cast<BYTE>(slot), 0, connected, timestamp);
+
+    DWORD changed = buttons ^ pad.buttons;
+    while (changed)
+    {
+        DWORD bit = changed & (0 - changed); // 最下位のビット
+        bool down = (buttons & bit) != 0;
+        if (bit == PAD_BIT_LEFT_TRIGGER)
+            LogEvent(INPUT_EVENT_PAD_TRIGGER, static_cast<BYTE>(slot), 0, down, timestamp);
+        else if (bit == PAD_BIT_RIGHT_TRIGGER)
+            LogEvent(INPUT_EVENT_PAD_TRIGGER, static_cast<BYTE>(slot), 1, down, timestamp);
+        else
+            LogEvent(INPUT_EVENT_PAD_BUTTON, static_cast<BYTE>(slot), bit, down, timestamp);
+        changed &= changed - 1;
+    }
+
+    pad.trigger |= buttons & ~pad.buttons;
+    pad.release |= ~buttons & pad.buttons;
+    pad.buttons = buttons;
+    pad.state = gamepad;
+    pad.connected = connected;
 }
 
-bool CInputManager::IsPadTrigger(WORD button) const
+//------------------------------------------------------------------------------
+// 変化の記録
+//------------------------------------------------------------------------------
+void CInputManager::LogEvent(BYTE device, BYTE slot, DWORD code, bool down, LONGLONG timestamp)
 {
-    return (m_state.Gamepad.wButtons & button) && !(m_oldstate.Gamepad.wButtons & button);
+    InputEventRecord record;
+    record.timestamp = timestamp;
+    record.frame = m_frame;
+    record.code = code;
+    record.device = device;
+    record.slot = slot;
+    record.down = down;
+    m_eventLog.Push(record);
 }
 
-bool CInputManager::IsPadRelease(WORD button) const
+DWORD CInputManager::GetFrameCount() const
 {
-    return !(m_state.Gamepad.wButtons & button) && (m_oldstate.Gamepad.wButtons & button);
+    return m_frame;
 }
 
-// アナログスティック (-1.0f ~ 1.0f)
-float CInputManager::GetThumbLX() const
+const CInputEventLog& CInputManager::GetEventLog() const
 {
-    return m_state.Gamepad.sThumbLX / 32767.0f;
+    return m_eventLog;
 }
 
-float CInputManager::GetThumbLY() const
+//------------------------------------------------------------------------------
+// ほかのスレッドへの公開
+//------------------------------------------------------------------------------
+void CInputManager::PublishSnapshot()
 {
-    return m_state.Gamepad.sThumbLY / 32767.0f;
+    InputSnapshot snapshot;
+    snapshot.frame = m_frame;
+    snapshot.timestamp = GetInputTimestamp();
+    snapshot.input = m_inputFrame;
+    m_snapshot.Store(snapshot);
 }
 
-// ZLトリガー入力 (0~255)
-BYTE CInputManager::GetLeftTrigger() const
+void CInputManager::ReadSnapshot(InputSnapshot& snapshot) const
 {
-    return m_state.Gamepad.bLeftTrigger;
+    m_snapshot.Load(snapshot);
 }
 
-// ZLトリガーが押された瞬間
-bool CInputManager::IsLeftTriggerTrigger() const
+unsigned int CInputManager::GetSnapshotVersion() const
 {
-    return (m_state.Gamepad.bLeftTrigger > 63) &&
-        !(m_oldstate.Gamepad.bLeftTrigger > 63);
+    return m_snapshot.GetVersion();
 }
 
-// ZLトリガーが離された瞬間
-bool CInputManager::IsLeftTriggerRelease() const
+//------------------------------------------------------------------------------
+// 入力の変化から Present までの時間
+//------------------------------------------------------------------------------
+void CInputManager::MarkPresent(DWORD frame)
 {
-    return !(m_state.Gamepad.bLeftTrigger > 63) &&
-        (m_oldstate.Gamepad.bLeftTrigger > 63);
+    MarkPresent(frame, GetInputTimestamp());
 }
 
-// ZRトリガー入力 (0~255)
-BYTE CInputManager::GetRightTrigger() const
+void CInputManager::MarkPresent(DWORD frame, LONGLONG presentTime)
 {
-    return m_state.Gamepad.bRightTrigger;
+    m_latency.OnPresent(m_eventLog, frame, presentTime);
 }
 
-// ZRトリガーが押された瞬間
-bool CInputManager::IsRightTriggerTrigger() const
+const CInputLatency& CInputManager::GetLatency() const
 {
-    return (m_state.Gamepad.bRightTrigger > 63) &&
-        !(m_oldstate.Gamepad.bRightTrigger > 63);
+    return m_latency;
 }
 
-// ZRトリガーが押された瞬間
-bool CInputManager::IsRightTriggerRelease() const
+void CInputManager::ResetLatency()
 {
-    return !(m_state.Gamepad.bRightTrigger > 63) &&
-        (m_oldstate.Gamepad.bRightTrigger > 63);
+    m_latency.Reset();
+}
+
+bool CInputManager::DumpLatency(const wchar_t* path) const
+{
+    return m_latency.Dump(path);
+}
+
+const InputFrame& CInputManager::GetInputFrame() const
+{
+    return m_inputFrame;
+}
+
+const CInputHistory& CInputManager::GetInputHistory() const
+{
+    return m_history;
+}
+
+void CInputManager::SetInputHistoryDepth(int frames)
+{
+    m_history.SetDepth(frames);
+}
+
+CActionMap& CInputManager::GetActionMap()
+{
+    return m_actionMap;
+}
+
+const CActionMap& CInputManager::GetActionMap() const
+{
+    return m_actionMap;
+}
+
+//------------------------------------------------------------------------------
+// ウィンドウメッセージの受け取り
+//------------------------------------------------------------------------------
+void CInputManager::HandleMessage(UINT message, WPARAM wParam, LPARAM lParam)
+{
+    m_messageKeyboard.HandleMessage(message, wParam, lParam);
+    m_mouse.HandleMessage(message, wParam, lParam);
+
+    // デバイスの追加・削除の通知で、未接続スロットをすぐに確認する
+    // （確認間隔が伸びていても、差し込んだパッドが次の Update で使える）
+    if (message == WM_DEVICECHANGE &&
+        (wParam == DBT_DEVNODES_CHANGED || wParam == DBT_DEVICEARRIVAL))
+    {
+        ProbePadsNow();
+    }
+}
+
+//------------------------------------------------------------------------------
+// マウスを Raw Input で受け取るウィンドウの登録
+//------------------------------------------------------------------------------
+bool CInputManager::RegisterRawMouse(HWND hWnd)
+{
+    return m_mouse.RegisterRawInput(hWnd);
+}
+
+const CMouse& CInputManager::GetMouse() const
+{
+    return m_mouse;
+}
+
+//------------------------------------------------------------------------------
+// キーボード入力の取得元を差し替え
+//------------------------------------------------------------------------------
+void CInputManager::SetKeyboardSource(IKeyboardSource* source)
+{
+    m_keyboard = source ? source : &m_messageKeyboard;
+    m_heldKeyCount = 0;
+
+    // 以前の取得元で押されていたキーは引き継がない
+    m_keyTable.Clear();
+    m_oldKeyTable.Clear();
+    m_keyTrigger.Clear();
+    m_keyRelease.Clear();
+}
+
+//------------------------------------------------------------------------------
+// スティックのデッドゾーン・カーブの設定
+//------------------------------------------------------------------------------
+void CInputManager::SetStickSettings(int stick, const StickSettings& settings)
+{
+    m_stickResponse[stick].Configure(settings);
+    m_forcePadUpdate = true;
+}
+
+const StickSettings& CInputManager::GetStickSettings(int stick) const
+{
+    return m_stickResponse[stick].GetSettings();
+}
+
+//------------------------------------------------------------------------------
+// 仮想ボタンの設定
+// 押している仮想ボタンは、次の Update で新しい表のしきい値から判定し直される
+//------------------------------------------------------------------------------
+void CInputManager::SetVirtualButtons(const VirtualButton* buttons, int count)
+{
+    m_virtualButtons.Configure(buttons, count);
+    m_forcePadUpdate = true;
+}
+
+bool CInputManager::SetVirtualButtonThresholds(DWORD bit, float press, float release)
+{
+    if (!m_virtualButtons.SetThresholds(bit, press, release))
+        return false;
+    m_forcePadUpdate = true;
+    return true;
+}
+
+const CVirtualButtons& CInputManager::GetVirtualButtons() const
+{
+    return m_virtualButtons;
 }
 
 //------------------------------------------------------------------------------
 // ゲームパッド振動設定
 // leftMotor, rightMotor = 0~65535
+// 値が変わっていなければ書き込みは起きないので、毎フレーム呼んでも構わない
 //------------------------------------------------------------------------------
-void CInputManager::SetVibration(WORD leftMotor, WORD rightMotor)
+void CInputManager::SetVibration(WORD leftMotor, WORD rightMotor, int pad)
 {
-    m_vibration.wLeftMotorSpeed = leftMotor;
-    m_vibration.wRightMotorSpeed = rightMotor;
-    XInputSetState(0, &m_vibration);
+    m_haptics.SetBase(pad, leftMotor / 65535.0f, rightMotor / 65535.0f);
+    UpdateHaptics();
+}
+
+int CInputManager::PlayHaptics(const HapticEffect& effect, int pad)
+{
+    int handle = m_haptics.Play(pad, effect, GetInputTimestamp());
+    UpdateHaptics();
+    return handle;
+}
+
+void CInputManager::StopHaptics(int handle)
+{
+    m_haptics.Stop(handle);
+    UpdateHaptics();
+}
+
+void CInputManager::SetHapticsSink(IHapticsSink* sink)
+{
+    m_hapticsSink = sink;
+    m_haptics.SetSink(sink ? sink : m_padBackend);
+}
+
+const CHaptics& CInputManager::GetHaptics() const
+{
+    return m_haptics;
+}
+
+//------------------------------------------------------------------------------
+// 振動の合成と書き込み（未接続のスロットには書き込まない）
+//------------------------------------------------------------------------------
+void CInputManager::UpdateHaptics()
+{
+    BYTE connectedMask = 0;
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        if (m_pads[i].connected)
+            connectedMask |= 1 << i;
+    }
+    m_haptics.Update(GetInputTimestamp(), connectedMask);
+}
+
+//------------------------------------------------------------------------------
+// ゲームパッドの接続管理
+//------------------------------------------------------------------------------
+void CInputManager::SetPadSlotCount(int count)
+{
+    count = (std::max)(1, (std::min)(count, static_cast<int>(MAX_PAD_COUNT)));
+
+    // 使わなくなったスロットは未接続に戻す
+    ResetPadSlots(count);
+    m_padCount = count;
+}
+
+//------------------------------------------------------------------------------
+// first 以降のスロットを未接続に戻す
+//------------------------------------------------------------------------------
+void CInputManager::ResetPadSlots(int first)
+{
+    for (int i = first; i < MAX_PAD_COUNT; ++i)
+    {
+        ZeroMemory(&m_pads[i], sizeof(PadSlot));
+        m_pads[i].probeInterval = PAD_PROBE_INTERVAL_MIN;
+    }
+    m_forcePadUpdate = true;
+}
+
+int CInputManager::GetPadSlotCount() const
+{
+    return m_padCount;
+}
+
+void CInputManager::ProbePadsNow()
+{
+    for (int i = 0; i < MAX_PAD_COUNT; ++i)
+    {
+        m_pads[i].probeWait = 0;
+        m_pads[i].probeInterval = PAD_PROBE_INTERVAL_MIN;
+
+        // 取得元の差し替え・サンプリングの終了後は、前に読んだパケット番号と比べられない
+        m_pads[i].packetValid = false;
+    }
+    m_sampler.ProbePadsNow();
+}
+
+//------------------------------------------------------------------------------
+// ゲームパッドの取得元の差し替え
+// 接続状態は引き継ぎ、次の Update で全スロットを新しい取得元から読み直す
+//------------------------------------------------------------------------------
+bool CInputManager::SetPadBackend(IPadBackend* backend)
+{
+    if (m_sampler.IsRunning())
+        return false;
+
+    m_padBackend = backend ? backend : &m_xinputBackend;
+    if (!m_hapticsSink)
+        m_haptics.SetSink(m_padBackend);
+    ProbePadsNow();
+    return true;
+}
+
+IPadBackend& CInputManager::GetPadBackend() const
+{
+    return *m_padBackend;
+}
+
+//------------------------------------------------------------------------------
+// バックグラウンドサンプリングの開始
+//------------------------------------------------------------------------------
+bool CInputManager::StartBackgroundSampling(int rateHz, bool sampleKeyboard)
+{
+    if (m_replay.IsOpen() || !m_sampler.Start(rateHz, m_padCount, sampleKeyboard, m_padBackend))
+        return false;
+
+    // キーボードもスレッドで取得する場合は、取得元をサンプル列に切り替える
+    if (sampleKeyboard)
+    {
+        m_savedKeyboard = m_keyboard;
+        m_sampledKeyboard.Reset();
+        SetKeyboardSource(&m_sampledKeyboard);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// バックグラウンドサンプリングの停止
+//------------------------------------------------------------------------------
+void CInputManager::StopBackgroundSampling()
+{
+    if (!m_sampler.IsRunning())
+        return;
+
+    bool sampledKeyboard = m_sampler.IsSamplingKeyboard();
+    m_sampler.Stop();
+    m_sampleCount = 0;
+    m_hasHeldSample = false;
+
+    // 元のキーボード入力の取得元に戻す
+    if (sampledKeyboard)
+    {
+        m_sampledKeyboard.Reset();
+        SetKeyboardSource(m_savedKeyboard);
+        m_savedKeyboard = nullptr;
+    }
+
+    // 次の Update からはこちらで取得するので、すぐに全スロットを確認する
+    ProbePadsNow();
+}
+
+bool CInputManager::IsBackgroundSampling() const
+{
+    return m_sampler.IsRunning();
+}
+
+//------------------------------------------------------------------------------
+// 入力の記録
+//------------------------------------------------------------------------------
+bool CInputManager::StartRecording(const wchar_t* path)
+{
+    return m_recorder.Open(path, m_padCount);
+}
+
+void CInputManager::StopRecording()
+{
+    m_recorder.Close();
+}
+
+bool CInputManager::IsRecording() const
+{
+    return m_recorder.IsOpen();
+}
+
+//------------------------------------------------------------------------------
+// このフレームの Update の結果を InputFrame にまとめる
+//------------------------------------------------------------------------------
+void CInputManager::BuildFrame(InputFrame& frame) const
+{
+    frame.Clear();
+    frame.keys = m_keyTable;
+    frame.keyTrigger = m_keyTrigger;
+    frame.keyRelease = m_keyRelease;
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        frame.pads[i] = m_pads[i].state;
+        frame.padTrigger[i] = m_pads[i].trigger;
+        frame.padRelease[i] = m_pads[i].release;
+        frame.padButtons[i] = m_pads[i].buttons;
+        for (int axis = 0; axis < 4; ++axis)
+            frame.thumbs[i][axis] = m_pads[i].thumb[axis];
+        if (m_pads[i].connected)
+            frame.connectedMask |= 1 << i;
+    }
+    frame.frameTimeUs = GetFrameTimeUs();
+}
+
+LONG CInputManager::GetFrameTimeUs() const
+{
+    return static_cast<LONG>(Window::GetFrameTime() * 1000.0 + 0.5);
+}
+
+//------------------------------------------------------------------------------
+// 入力の再生開始
+// キーボードは再生用の取得元に切り替え、パッドは記録のスロット数で再生する
+//------------------------------------------------------------------------------
+bool CInputManager::StartReplay(const wchar_t* path)
+{
+    if (m_sampler.IsRunning())
+        return false;
+
+    bool replaying = m_replay.IsOpen();
+    if (!m_replay.Open(path))
+    {
+        if (replaying)
+            StopReplay();
+        return false;
+    }
+
+    if (!replaying)
+        m_savedKeyboard = m_keyboard;
+    m_replayKeyboard.Reset();
+    SetKeyboardSource(&m_replayKeyboard);
+    // パッドは未接続の状態から再生する
+    ResetPadSlots(0);
+    SetPadSlotCount(m_replay.GetPadCount());
+    m_replayFrame.Clear();
+    m_timers.Reset();
+    m_history.Reset();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// 入力の再生停止（実際の入力に戻す）
+//------------------------------------------------------------------------------
+void CInputManager::StopReplay()
+{
+    if (!m_replay.IsOpen())
+        return;
+
+    m_replay.Close();
+    m_replayKeyboard.Reset();
+    SetKeyboardSource(m_savedKeyboard);
+    m_savedKeyboard = nullptr;
+    m_replayingFrame = false;
+
+    // 再生した状態は捨てて、次の Update で実際のパッドを確認し直す
+    ResetPadSlots(0);
+    m_timers.Reset();
+    m_history.Reset();
+}
+
+bool CInputManager::IsReplaying() const
+{
+    return m_replay.IsOpen();
+}
+
+//------------------------------------------------------------------------------
+// 再生位置の移動
+// 次の Update では frame フレーム目の状態とエッジがそのまま再現される
+//------------------------------------------------------------------------------
+bool CInputManager::SeekReplay(DWORD frame)
+{
+    if (!m_replay.IsOpen())
+        return false;
+
+    // 直前の状態を取り出して、そこから frame フレーム目へ変化させる
+    if (frame > 0)
+    {
+        if (!m_replay.Seek(frame - 1) || !m_replay.Next(m_replayFrame))
+            return false;
+    }
+    else
+    {
+        if (!m_replay.Seek(0))
+            return false;
+        m_replayFrame.Clear();
+    }
+
+    // キー・パッドは直前のフレームの状態にしておく
+    m_replayKeyboard.Reset();
+    m_replayKeyboard.SetFrame(m_replayFrame, GetInputTimestamp());
+    KeyEvent events[64];
+    while (m_replayKeyboard.Fetch(events, ARRAYSIZE(events)) > 0)
+    {
+    }
+    m_keyTable = m_replayFrame.keys;
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        PadSlot& pad = m_pads[i];
+        pad.state = m_replayFrame.pads[i];
+        pad.buttons = 0;
+        m_virtualButtons.Process(&pad.state, &pad.buttons, 1);
+        pad.connected = (m_replayFrame.connectedMask & (1 << i)) != 0;
+    }
+    m_forcePadUpdate = true;
+    return true;
+}
+
+DWORD CInputManager::GetReplayPosition() const
+{
+    return m_replay.GetPosition();
+}
+
+DWORD CInputManager::GetReplayFrameCount() const
+{
+    return m_replay.GetFrameCount();
+}
+
+//------------------------------------------------------------------------------
+// 再生中なら次のフレームを読み出す
+//------------------------------------------------------------------------------
+bool CInputManager::ReadReplayFrame()
+{
+    if (!m_replay.IsOpen())
+        return false;
+
+    if (!m_replay.Next(m_replayFrame))
+    {
+        StopReplay();
+        return false;
+    }
+
+    m_replayKeyboard.SetFrame(m_replayFrame, GetInputTimestamp());
+    Window::SetFrameTime(m_replayFrame.frameTimeUs / 1000.0);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// 再生中のフレームのパッド状態を反映する
+// 前の状態 → 離したボタン → 押したボタン → 最後の状態 の順に反映して、
+// フレーム内で押して離したボタンの Trigger / Release も再現する
+//------------------------------------------------------------------------------
+void CInputManager::ReplayPads()
+{
+    LONGLONG timestamp = GetInputTimestamp();
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        const XINPUT_GAMEPAD& last = m_replayFrame.pads[i];
+        bool connected = (m_replayFrame.connectedMask & (1 << i)) != 0;
+
+        DWORD released = m_pads[i].buttons & ~m_replayFrame.padRelease[i];
+        DWORD pressed = released | m_replayFrame.padTrigger[i];
+        DWORD steps[2] = { released, pressed };
+        for (int s = 0; s < 2; ++s)
+        {
+            if (steps[s] == m_pads[i].buttons)
+                continue;
+
+            // 途中の状態はボタンのビットだけを作る（トリガーはしきい値の上か下か）
+            XINPUT_GAMEPAD gamepad = last;
+            gamepad.wButtons = LOWORD(steps[s]);
+            gamepad.bLeftTrigger = (steps[s] & PAD_BIT_LEFT_TRIGGER) ? 255 : 0;
+            gamepad.bRightTrigger = (steps[s] & PAD_BIT_RIGHT_TRIGGER) ? 255 : 0;
+            DWORD buttons = m_pads[i].buttons;
+            m_virtualButtons.Process(&gamepad, &buttons, 1);
+            FoldPadState(i, gamepad, buttons, connected, timestamp);
+        }
+        DWORD buttons = m_pads[i].buttons;
+        m_virtualButtons.Process(&last, &buttons, 1);
+        FoldPadState(i, last, buttons, connected, timestamp);
+
+        // スティックの仮想ボタンは途中の状態を作れないので、エッジは記録の値も足しておく
+        m_pads[i].trigger |= m_replayFrame.padTrigger[i];
+        m_pads[i].release |= m_replayFrame.padRelease[i];
+    }
 }
@@ -1,52 +1,300 @@
 #pragma once
 #include <windows.h>
 #include <Xinput.h>
+#include "CKeyBitset.h"
+#include "CKeyboardSource.h"
+#include "CInputSampler.h"
+#include "CInputEventLog.h"
+#include "CInputRecording.h"
+#include "CActionMap.h"
+#include "CStickResponse.h"
+#include "CVirtualButtons.h"
+#include "CHaptics.h"
+#include "CPadBackend.h"
+#include "CMouse.h"
+#include "CInputLatency.h"
+#include "CInputTimers.h"
+#include "CInputHistory.h"
+#include "CSeqlock.h"
+#include "InputSnapshot.h"
+#include "InputQuery.h"
+#include "PadButtons.h"
+
+//------------------------------------------------------------------------------
+// このフレームで変化のあったデバイス（CInputManager::GetDirtyMask のビット）
+//------------------------------------------------------------------------------
+const DWORD INPUT_DIRTY_KEYBOARD = 0x01;    // キーボード
+const DWORD INPUT_DIRTY_MOUSE = 0x02;       // マウス
+const DWORD INPUT_DIRTY_PAD0 = 0x04;        // ゲームパッド（スロット i は INPUT_DIRTY_PAD0 << i）
+const DWORD INPUT_DIRTY_PADS = 0x3C;        // ゲームパッドの全スロット
 
 //------------------------------------------------------------------------------
 // CInputManager
 // キーボードおよびゲームパッド入力を管理するシングルトンクラス
 // シングルトン化しているので、インスタンスは GetInstance() から取得
+// 入力判定の関数はヘッダーで定義しているので、呼び出し側で展開される
 //------------------------------------------------------------------------------
 class CInputManager
 {
 public:
     // インスタンス取得（唯一のインスタンスを返す）
-    static CInputManager& GetInstance();
+    // インスタンスは静的メンバなので、関数内 static のような初期化済みかの確認はない
+    static CInputManager& GetInstance() { return s_instance; }
 
     // 毎フレーム呼ぶ更新処理
     void Update();
 
+    // 固定ティックごとに呼ぶ更新処理
+    // until（GetInputTimestamp の値）までに起きたキー入力・サンプルだけを反映し、
+    // それより後のものは次の Update に持ち越す（ティックごとに、そのティックまでのエッジを受け取る）
+    // 直接取得のゲームパッド・マウス・再生は時刻で分けられないので、呼んだ時点までをすべて反映する
+    void Update(LONGLONG until);
+
+    // Update を呼んだ回数（現在のフレーム番号）
+    DWORD GetFrameCount() const;
+
+    // このフレームの Update で入力が変わったか（INPUT_DIRTY_* の組み合わせ）
+    // キー・パッドが変わらなかったフレームは、パッドの反映・スティックの処理・結果のまとめ・
+    // アクションの評価を省き、押している時間などは次に変わったときにまとめて進める
+    // 呼び出し側も、変化がなければ自分の入力処理を省ける
+    bool IsInputChanged() const { return m_dirtyMask != 0; }
+    DWORD GetDirtyMask() const { return m_dirtyMask; }
+    bool IsKeyboardDirty() const { return (m_dirtyMask & INPUT_DIRTY_KEYBOARD) != 0; }
+    bool IsMouseDirty() const { return (m_dirtyMask & INPUT_DIRTY_MOUSE) != 0; }
+    bool IsPadDirty(int pad) const { return (m_dirtyMask & (INPUT_DIRTY_PAD0 << pad)) != 0; }
+
+    // キー・ボタン・トリガー・接続の変化の記録（タイムスタンプ付き）
+    // 例：GetEventLog().ForEachSince(frame, [](const InputEventRecord& e) { ... });
+    const CInputEventLog& GetEventLog() const;
+
+    // このフレームの Update の結果をまとめたもの（キー・パッドの状態とエッジ）
+    const InputFrame& GetInputFrame() const;
+
+    // 過去のフレームの入力（深さはフレーム数、変えると記録は消える）
+    const CInputHistory& GetInputHistory() const;
+    void SetInputHistoryDepth(int frames);
+
+    // Update の結果の写し（どのスレッドからでも、ロックなしで呼べる）
+    // Update の途中でも、最後に公開した1フレーム分がそろった状態で読める
+    // 例：ワーカースレッドで InputSnapshot s; GetInstance().ReadSnapshot(s); s.IsKeyPress('A');
+    void ReadSnapshot(InputSnapshot& snapshot) const;
+    unsigned int GetSnapshotVersion() const;    // 公開した回数（変わっていなければ読み直さなくてよい）
+
+    // 入力の変化から Present までの時間
+    // Present の直後に、その画面に反映した入力のフレーム番号（Update 後の GetFrameCount）を渡す
+    void MarkPresent(DWORD frame);
+    void MarkPresent(DWORD frame, LONGLONG presentTime); // 別スレッドで Present した時刻（GetInputTimestamp の値）を後から渡す
+    const CInputLatency& GetLatency() const;
+    void ResetLatency();
+    bool DumpLatency(const wchar_t* path) const;
+
+    // アクションの割り当て（Update の最後に評価される）
+    // 例：GetActionMap().PushContext(bindings); … GetActionMap().IsPress(ACTION_JUMP)
+    CActionMap& GetActionMap();
+    const CActionMap& GetActionMap() const;
+
+    // WndProc から全メッセージを渡す（キーボードイベントの受け取り）
+    void HandleMessage(UINT message, WPARAM wParam, LPARAM lParam);
+
+    // キーボード入力の取得元を差し替える（nullptr で既定のメッセージ入力に戻す）
+    // 切り替え時はすべてのキーを離した状態から始まる
+    void SetKeyboardSource(IKeyboardSource* source);
+
     //--------------------------------------
     // キーボード入力判定
     //--------------------------------------
-    bool IsKeyPress(int key) const;   // キーが押されているか
-    bool IsKeyTrigger(int key) const; // キーが押された瞬間か
-    bool IsKeyRelease(int key) const; // キーが離された瞬間か
+    // ダブルタップ・キーリピートの既定の時間（ms）
+    static constexpr float DOUBLE_TAP_MS = 250.0f;
+    static constexpr float REPEAT_DELAY_MS = 400.0f;
+    static constexpr float REPEAT_INTERVAL_MS = 50.0f;
+
+    bool IsKeyPress(int key) const { return m_keyTable.Test(key); }     // キーが押されているか
+    bool IsKeyTrigger(int key) const { return m_keyTrigger.Test(key); } // キーが押された瞬間か
+    bool IsKeyRelease(int key) const { return m_keyRelease.Test(key); } // キーが離された瞬間か
+
+    // 複数のキーをまとめて調べる（bit i = keys[i]、最大 INPUT_QUERY_MAX_COUNT 個）
+    InputQueryMasks QueryKeys(const BYTE* keys, int count) const
+    {
+        return QueryKeyMasks(m_keyTable, m_keyTrigger, m_keyRelease, keys, count);
+    }
+    template<int N>
+    InputQueryMasks QueryKeys(const BYTE (&keys)[N]) const { return QueryKeys(keys, N); }
+
+    // 押している時間・ダブルタップ・キーリピート（時間は ms、Update でまとめて数えた値を読むだけ）
+    float GetKeyHoldMs(int key) const { return m_timers.GetHoldMs(GetKeyLane(key)); }
+    float GetKeyLastHoldMs(int key) const { return m_timers.GetLastHoldMs(GetKeyLane(key)); }    // 直前に離したときまで押していた時間
+    bool IsKeyHeld(int key, float ms) const { return m_timers.IsHeld(GetKeyLane(key), ms); }
+    bool IsKeyDoubleTap(int key, float windowMs = DOUBLE_TAP_MS) const { return m_timers.IsDoubleTap(GetKeyLane(key), windowMs); }
+    bool IsKeyRepeat(int key, float delayMs = REPEAT_DELAY_MS, float intervalMs = REPEAT_INTERVAL_MS) const
+    {
+        return m_timers.IsRepeat(GetKeyLane(key), delayMs, intervalMs);
+    }
+
+    // 先行入力（frames はこのフレームを含むフレーム数、最大 CInputHistory::MASK_DEPTH）
+    bool WasKeyTriggeredWithin(int key, int frames) const { return m_history.WasTriggeredWithin(GetKeyLane(key), frames); }
+    bool WasKeyReleasedWithin(int key, int frames) const { return m_history.WasReleasedWithin(GetKeyLane(key), frames); }
+    int GetKeyFramesSinceTrigger(int key) const { return m_history.GetFramesSinceTrigger(GetKeyLane(key)); }   // このフレームなら0、残っていなければ -1
+    int GetKeyFramesSinceRelease(int key) const { return m_history.GetFramesSinceRelease(GetKeyLane(key)); }
+
+    //--------------------------------------
+    // マウス入力判定（button は MOUSE_BUTTON_LEFT 等、記録・再生の対象外）
+    //--------------------------------------
+    // Raw Input で受け取るウィンドウを登録する（失敗時はウィンドウメッセージから求める）
+    bool RegisterRawMouse(HWND hWnd);
+    const CMouse& GetMouse() const;
+
+    bool IsMousePress(DWORD button) const { return m_mouse.IsPress(button); }
+    bool IsMouseTrigger(DWORD button) const { return m_mouse.IsTrigger(button); }
+    bool IsMouseRelease(DWORD button) const { return m_mouse.IsRelease(button); }
+
+    // 前フレームの Update からの移動量（マウスのカウント、右・下が正）とホイール（ノッチ数）
+    LONG GetMouseDeltaX() const { return m_mouse.GetDeltaX(); }
+    LONG GetMouseDeltaY() const { return m_mouse.GetDeltaY(); }
+    float GetMouseWheel() const { return m_mouse.GetWheel(); }
 
     //--------------------------------------
     // ゲームパッド入力判定
+    // pad はスロット番号（0 ~ GetPadSlotCount()-1、省略時はプレイヤー1）
+    //--------------------------------------
+    bool IsPadPress(WORD button, int pad = 0) const { return (m_pads[pad].state.wButtons & button) != 0; } // ボタンが押されているか
+    bool IsPadTrigger(WORD button, int pad = 0) const { return (m_pads[pad].trigger & button) != 0; }       // ボタンが押された瞬間か
+    bool IsPadRelease(WORD button, int pad = 0) const { return (m_pads[pad].release & button) != 0; }       // ボタンが離された瞬間か
+
+    // 複数のボタンをまとめて調べる（bit i = buttons[i]、ボタンはボタンワードのビット）
+    InputQueryMasks QueryPadButtons(const DWORD* buttons, int count, int pad = 0) const
+    {
+        const PadSlot& p = m_pads[pad];
+        return QueryPadMasks(p.buttons, p.trigger, p.release, buttons, count);
+    }
+    template<int N>
+    InputQueryMasks QueryPadButtons(const DWORD (&buttons)[N], int pad = 0) const { return QueryPadButtons(buttons, N, pad); }
+
+    // ボタンワードのビットで調べる（仮想ボタン PAD_BIT_* も使える）
+    bool IsPadButtonPress(DWORD button, int pad = 0) const { return (m_pads[pad].buttons & button) != 0; }
+    bool IsPadButtonTrigger(DWORD button, int pad = 0) const { return (m_pads[pad].trigger & button) != 0; }
+    bool IsPadButtonRelease(DWORD button, int pad = 0) const { return (m_pads[pad].release & button) != 0; }
+
+    // 押している時間・ダブルタップ・キーリピート（button はボタンワードのビット1つ）
+    float GetPadHoldMs(DWORD button, int pad = 0) const { return m_timers.GetHoldMs(GetPadLane(button, pad)); }
+    float GetPadLastHoldMs(DWORD button, int pad = 0) const { return m_timers.GetLastHoldMs(GetPadLane(button, pad)); }
+    bool IsPadHeld(DWORD button, float ms, int pad = 0) const { return m_timers.IsHeld(GetPadLane(button, pad), ms); }
+    bool IsPadDoubleTap(DWORD button, int pad = 0, float windowMs = DOUBLE_TAP_MS) const
+    {
+        return m_timers.IsDoubleTap(GetPadLane(button, pad), windowMs);
+    }
+    bool IsPadRepeat(DWORD button, int pad = 0, float delayMs = REPEAT_DELAY_MS, float intervalMs = REPEAT_INTERVAL_MS) const
+    {
+        return m_timers.IsRepeat(GetPadLane(button, pad), delayMs, intervalMs);
+    }
+
+    // 先行入力（frames はこのフレームを含むフレーム数、最大 CInputHistory::MASK_DEPTH）
+    bool WasPadTriggeredWithin(DWORD button, int frames, int pad = 0) const { return m_history.WasTriggeredWithin(GetPadLane(button, pad), frames); }
+    bool WasPadReleasedWithin(DWORD button, int frames, int pad = 0) const { return m_history.WasReleasedWithin(GetPadLane(button, pad), frames); }
+    int GetPadFramesSinceTrigger(DWORD button, int pad = 0) const { return m_history.GetFramesSinceTrigger(GetPadLane(button, pad)); }
+    int GetPadFramesSinceRelease(DWORD button, int pad = 0) const { return m_history.GetFramesSinceRelease(GetPadLane(button, pad)); }
+
+    // アナログスティック（-1.0f ~ 1.0f、デッドゾーン・カーブ処理済み）
+    float GetThumbLX(int pad = 0) const { return m_pads[pad].thumb[0]; }
+    float GetThumbLY(int pad = 0) const { return m_pads[pad].thumb[1]; }
+    float GetThumbRX(int pad = 0) const { return m_pads[pad].thumb[2]; }
+    float GetThumbRY(int pad = 0) const { return m_pads[pad].thumb[3]; }
+
+    // スティックのデッドゾーン・カーブの設定（全スロット共通）
+    // stick = STICK_LEFT / STICK_RIGHT
+    enum { STICK_LEFT, STICK_RIGHT, STICK_COUNT };
+    void SetStickSettings(int stick, const StickSettings& settings);
+    const StickSettings& GetStickSettings(int stick) const;
+
+    // トリガー入力（0~255、Trigger / Release は仮想ボタンのしきい値で判定）
+    BYTE GetLeftTrigger(int pad = 0) const { return m_pads[pad].state.bLeftTrigger; }
+    bool IsLeftTriggerTrigger(int pad = 0) const { return (m_pads[pad].trigger & PAD_BIT_LEFT_TRIGGER) != 0; }  //バカみたいな名前だな
+    bool IsLeftTriggerRelease(int pad = 0) const { return (m_pads[pad].release & PAD_BIT_LEFT_TRIGGER) != 0; }
+
+    BYTE GetRightTrigger(int pad = 0) const { return m_pads[pad].state.bRightTrigger; }
+    bool IsRightTriggerTrigger(int pad = 0) const { return (m_pads[pad].trigger & PAD_BIT_RIGHT_TRIGGER) != 0; }
+    bool IsRightTriggerRelease(int pad = 0) const { return (m_pads[pad].release & PAD_BIT_RIGHT_TRIGGER) != 0; }
+
+    //--------------------------------------
+    // 仮想ボタン
+    // トリガー・スティックを押す・離すのしきい値で判定して、ボタンワードの上位のビットにする
+    // 表は全スロット共通で、Update ごとに全スロットをまとめて判定する
+    //--------------------------------------
+    void SetVirtualButtons(const VirtualButton* buttons, int count);
+    template<int N>
+    void SetVirtualButtons(const VirtualButton (&buttons)[N]) { SetVirtualButtons(buttons, N); }
+    bool SetVirtualButtonThresholds(DWORD bit, float press, float release);
+    const CVirtualButtons& GetVirtualButtons() const;
+
+    //--------------------------------------
+    // ゲームパッドの振動
+    // 出力はモーターごとに合成し、前回書き込んだ値から変わったときだけ書き込む
+    //--------------------------------------
+    // ずっと続く振動の強さ（次に設定するまで変わらない、毎フレーム呼ぶ必要はない）
+    void SetVibration(WORD leftMotor, WORD rightMotor, int pad = 0);
+
+    // 時間で変化する振動を再生する（終わったら自動で止まる、停止用の番号を返す）
+    int PlayHaptics(const HapticEffect& effect, int pad = 0);
+    void StopHaptics(int handle);
+
+    // 振動の出力先を差し替える（nullptr でゲームパッドの取得元に戻す）
+    void SetHapticsSink(IHapticsSink* sink);
+    const CHaptics& GetHaptics() const;
+
+    //--------------------------------------
+    // ゲームパッドの接続管理
     //--------------------------------------
-    bool IsPadPress(WORD button) const; // ボタンが押されているか
-    bool IsPadTrigger(WORD button) const; // ボタンが押された瞬間か
-    bool IsPadRelease(WORD button) const; // ボタンが離された瞬間か
+    static const int MAX_PAD_COUNT = XUSER_MAX_COUNT; // 最大スロット数（4）
+
+    // 使用するスロット数を設定（1 ~ MAX_PAD_COUNT）
+    void SetPadSlotCount(int count);
+    int GetPadSlotCount() const;
+
+    bool IsPadConnected(int pad) const { return m_pads[pad].connected; }                                   // 接続されているか
+    bool IsPadConnectTrigger(int pad) const { return m_pads[pad].connected && !m_pads[pad].oldConnected; }  // このフレームで接続されたか
+    bool IsPadDisconnectTrigger(int pad) const { return !m_pads[pad].connected && m_pads[pad].oldConnected; } // このフレームで切断されたか
 
-    // アナログスティック（-1.0f ~ 1.0f に正規化済み）
-    float GetThumbLX() const;
-    float GetThumbLY() const;
+    // 未接続スロットを次の Update ですぐに確認させる（デバイス追加の通知時など）
+    // WM_DEVICECHANGE を HandleMessage に渡していれば自動で呼ばれる
+    void ProbePadsNow();
 
-    // トリガー入力（0~255）
-    BYTE GetLeftTrigger() const;
-    bool IsLeftTriggerTrigger() const;  //バカみたいな名前だな
-    bool IsLeftTriggerRelease() const;
+    // ゲームパッドの取得元を差し替える（nullptr で XInput に戻す）
+    // 振動も SetHapticsSink で別に設定していなければこちらへ書き込む
+    // バックグラウンドサンプリング中は差し替えられない（false を返す）
+    bool SetPadBackend(IPadBackend* backend);
+    IPadBackend& GetPadBackend() const;
 
-    BYTE GetRightTrigger() const;
-    bool IsRightTriggerTrigger() const;
-    bool IsRightTriggerRelease() const;
+    //--------------------------------------
+    // バックグラウンドサンプリング
+    // 専用スレッドで rateHz ごとに入力を取得し、Update でまとめて反映する
+    // フレームの間に押して離した入力も Trigger / Release として残る
+    //--------------------------------------
+    // sampleKeyboard = true ならキーボードもスレッドで取得する
+    // （その間は SetKeyboardSource で設定した取得元は使われない）
+    bool StartBackgroundSampling(int rateHz = 1000, bool sampleKeyboard = true);
+    void StopBackgroundSampling();
+    bool IsBackgroundSampling() const;
+
+    //--------------------------------------
+    // 入力の記録と再生
+    // 記録は毎フレームの Update の結果（キー・パッド・エッジ・フレーム時間）を書き出す
+    // 再生中は実際の入力の代わりに記録を読み出し、フレーム時間も記録の値にする
+    // 再生とバックグラウンドサンプリングは同時に使えない
+    //--------------------------------------
+    bool StartRecording(const wchar_t* path);
+    void StopRecording();
+    bool IsRecording() const;
 
-    // ゲームパッド振動設定
-    void SetVibration(WORD leftMotor, WORD rightMotor);
+    bool StartReplay(const wchar_t* path);
+    void StopReplay();
+    bool IsReplaying() const;
+    bool SeekReplay(DWORD frame);       // 次の Update で frame フレーム目を再生する
+    DWORD GetReplayPosition() const;    // 次の Update で再生するフレーム番号
+    DWORD GetReplayFrameCount() const;
 
 private:
+    // 唯一のインスタンス
+    static CInputManager s_instance;
+
     // コンストラクタは private にしてシングルトン化
     CInputManager();
 
@@ -57,13 +305,101 @@ private:
     CInputManager(const CInputManager&) = delete;
     CInputManager& operator=(const CInputManager&) = delete;
 
+    void UpdateKeyboard(LONGLONG until);
+    void UpdatePads();
+    void PollPads();
+    void ProcessSticks();
+    void UpdateHaptics();
+    void FetchSamples(LONGLONG until);
+    bool ReadReplayFrame();
+    void ReplayPads();
+    void BuildFrame(InputFrame& frame) const;
+    LONG GetFrameTimeUs() const;
+    void PublishSnapshot();
+    void ResetPadSlots(int first);
+
+    //--------------------------------------
+    // ゲームパッド1台分の状態
+    //--------------------------------------
+    struct PadSlot
+    {
+        XINPUT_GAMEPAD state;       // 現在のゲームパッド状態
+        DWORD buttons;              // 現在のボタンワード（wButtons + 仮想ボタン）
+        DWORD trigger;              // このフレームで押されたボタン
+        DWORD release;              // このフレームで離されたボタン
+        bool connected;             // 接続中か
+        bool oldConnected;          // 前フレームで接続中だったか
+        bool packetValid;           // packetNumber がこの取得元から読んだ値か
+        DWORD packetNumber;         // 最後に読んだ XINPUT_STATE::dwPacketNumber（同じなら状態は変わっていない）
+        int probeWait;              // 未接続時、次の確認までの残りフレーム数
+        int probeInterval;          // 未接続時の確認間隔（フレーム数、徐々に伸ばす）
+        float thumb[4];             // スティックの処理後の値（LX, LY, RX, RY）
+    };
+
+    // 未接続スロットの確認間隔（フレーム数）
+    // 未接続の XInputGetState は重いので、毎フレームは呼ばずに間隔を倍々で伸ばす
+    // （接続はたいてい WM_DEVICECHANGE で ProbePadsNow されるので、間隔が伸びても遅れない）
+    static const int PAD_PROBE_INTERVAL_MIN = 30;
+    static const int PAD_PROBE_INTERVAL_MAX = 240;
+
+    // 取得したゲームパッド状態（pads[0 ~ m_padCount-1]）から、各スロットの新しいボタンワードを求める
+    void EvaluatePadButtons(const XINPUT_GAMEPAD* pads, DWORD* buttons) const;
+
+    // 取得したゲームパッド状態を1つ反映し、エッジを積算する
+    void FoldPadState(int slot, const XINPUT_GAMEPAD& gamepad, DWORD buttons, bool connected, LONGLONG timestamp);
+
+    // 変化を記録する
+    void LogEvent(BYTE device, BYTE slot, DWORD code, bool down, LONGLONG timestamp);
+
     //--------------------------------------
     // メンバ変数
     //--------------------------------------
-    BYTE m_keyTable[256];     // 現在のキー状態
-    BYTE m_oldKeyTable[256];  // 前フレームのキー状態
+    DWORD m_frame;              // Update を呼んだ回数
+    DWORD m_dirtyMask;          // このフレームで変化のあったデバイス（INPUT_DIRTY_*）
+    bool m_keyPadChanged;       // 前フレームでキー・パッドが変わったか（エッジを消すために結果をまとめ直す）
+    bool m_forcePadUpdate;      // 次の Update で全スロットを処理し直す（設定を変えたとき）
+    CInputEventLog m_eventLog;  // 入力の変化の記録
+    InputFrame m_inputFrame;    // このフレームの Update の結果
+    CActionMap m_actionMap;     // アクションの割り当て
+    CInputLatency m_latency;    // 入力の変化から Present までの時間
+    CInputTimers m_timers;      // キー・ボタンごとの押している時間など
+    CInputHistory m_history;    // 過去のフレームの入力
+    CSeqlock<InputSnapshot> m_snapshot; // ほかのスレッドに公開する Update の結果
+
+    CKeyBitset m_keyTable;      // 現在のキー状態
+    CKeyBitset m_oldKeyTable;   // 前フレームのキー状態
+    CKeyBitset m_keyTrigger;    // このフレームで押されたキー（Update で計算済み）
+    CKeyBitset m_keyRelease;    // このフレームで離されたキー（Update で計算済み）
+
+    CMouse m_mouse;             // マウス
+
+    CMessageKeyboardSource m_messageKeyboard; // 既定のキーボード入力（ウィンドウメッセージ）
+    IKeyboardSource* m_keyboard;              // 現在のキーボード入力の取得元
+
+    PadSlot m_pads[MAX_PAD_COUNT]; // ゲームパッドの状態（全スロットを連続して保持）
+    int m_padCount;                // 使用するスロット数
+    CStickResponse m_stickResponse[STICK_COUNT]; // スティックの処理（左・右）
+    CVirtualButtons m_virtualButtons;              // 仮想ボタンの表
+    CHaptics m_haptics;            // 振動の合成と出力
+    CXInputPadBackend m_xinputBackend; // 既定のゲームパッドの取得元
+    IPadBackend* m_padBackend;     // 現在のゲームパッドの取得元
+    IHapticsSink* m_hapticsSink;   // SetHapticsSink で設定した振動の出力先（nullptr = 取得元へ）
+
+    CInputSampler m_sampler;                      // バックグラウンドサンプリング
+    CSampledKeyboardSource m_sampledKeyboard;     // サンプリング中のキーボード入力
+    IKeyboardSource* m_savedKeyboard;             // サンプリング・再生の開始前のキーボード入力の取得元
+    InputSample m_samples[CInputSampler::RING_SIZE]; // このフレームで取り出したサンプル
+    int m_sampleCount;
+    InputSample m_heldSample;                     // until より後だったので次の Update に持ち越したサンプル
+    bool m_hasHeldSample;
+
+    static const int KEY_EVENT_BATCH = 64;        // 1回に取り出すキーイベント数
+    KeyEvent m_heldKeys[KEY_EVENT_BATCH];         // until より後だったので次の Update に持ち越したキーイベント
+    int m_heldKeyCount;
 
-    XINPUT_STATE m_state;     // 現在のゲームパッド状態
-    XINPUT_STATE m_oldstate;    //前フレームのゲームパッド状態
-    XINPUT_VIBRATION m_vibration; // 振動設定
+    CInputRecorder m_recorder;                    // 入力の記録
+    CInputReplay m_replay;                        // 入力の再生
+    CReplayKeyboardSource m_replayKeyboard;       // 再生中のキーボード入力
+    InputFrame m_replayFrame;                     // このフレームで再生する入力
+    bool m_replayingFrame;                        // このフレームは記録から読み出したか
 };
@@ -0,0 +1,264 @@
+#include "CSelfTest.h"
+#include "CInputManager.h"
+
+namespace
+{
+    const int FRAMES = 100000;
+
+    // 検証用の入力に差し替え、終わったら元に戻す
+    struct ScopedScriptedInput
+    {
+        CScriptedKeyboardSource keyboard;
+        CMockPadBackend pads;
+
+        ScopedScriptedInput()
+        {
+            auto& input = CInputManager::GetInstance();
+            pads.SetConnected(0, true);
+            input.SetKeyboardSource(&keyboard);
+            input.SetPadBackend(&pads);
+            input.Update();
+        }
+
+        ~ScopedScriptedInput()
+        {
+            auto& input = CInputManager::GetInstance();
+            input.SetKeyboardSource(nullptr);
+            input.SetPadBackend(nullptr);
+            input.ResetLatency();
+        }
+    };
+
+    //--------------------------------------
+    // 以前のキーの問い合わせ方の再現
+    // GetInstance は関数内 static（呼ぶたびに初期化済みかを確認）、問い合わせは .cpp にあってインライン化されない
+    //--------------------------------------
+    CInputManager& GetInstanceGuarded()
+    {
+        static CInputManager& instance = CInputManager::GetInstance();
+        return instance;
+    }
+
+    bool IsKeyPressOutOfLine(const CInputManager& input, int key)
+    {
+        return input.IsKeyPress(key);
+    }
+
+    // 関数ポインタを volatile にして、呼び出しをインライン化させない
+    bool (*volatile g_isKeyPressOutOfLine)(const CInputManager&, int) = IsKeyPressOutOfLine;
+
+    void ReportLatency(const char* name, InputLatencySeries series)
+    {
+        FrameStatsSummary s = CInputManager::GetInstance().GetLatency().GetSummary(series);
+        CSelfTest::Report("  latency %-3s: count %lu, p50 %.3f ms, p99 %.3f ms, max %.3f ms",
+            name, static_cast<unsigned long>(s.count), s.p50Ms, s.p99Ms, s.maxMs);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 計測：入力から Present までの計測を含めた、1フレーム分の入力処理
+// キーボードは決まった順のイベント、パッドは検証用の取得元で動かし、
+// Present は Update の直後に済んだことにする（描画なし）
+// 計測そのものの負荷は、MarkPresent を呼ぶ場合と呼ばない場合の差で分かる
+// 遅延は描画の時間を含まないので、ほぼ Update の処理時間になる
+//------------------------------------------------------------------------------
+SELF_BENCH(InputLatencyPipeline)
+{
+    ScopedScriptedInput scripted;
+    auto& input = CInputManager::GetInstance();
+
+    // 4フレームごとにキーを押す・離す、3フレームごとにボタンを押す・離す
+    for (int frame = 0; frame < FRAMES * 2; frame += 4)
+        scripted.keyboard.AddEvent(frame, 'A', (frame / 4) % 2 == 0);
+
+    double elapsed[2];
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        bool present = (pass == 1);
+        input.ResetLatency();
+        double start = CSelfTest::GetTimeUs();
+        for (int frame = 0; frame < FRAMES; ++frame)
+        {
+            if (frame % 3 == 0)
+            {
+                XINPUT_GAMEPAD gamepad = scripted.pads.GetGamepad(0);
+                gamepad.wButtons ^= XINPUT_GAMEPAD_A;
+                scripted.pads.SetGamepad(0, gamepad);
+            }
+            input.Update();
+            if (present)
+                input.MarkPresent(input.GetFrameCount());
+        }
+        elapsed[pass] = CSelfTest::GetTimeUs() - start;
+    }
+
+    CSelfTest::Report("  Update             : %.1f ns/frame", elapsed[0] * 1000.0 / FRAMES);
+    CSelfTest::Report("  Update+MarkPresent : %.1f ns/frame", elapsed[1] * 1000.0 / FRAMES);
+    ReportLatency("all", INPUT_LATENCY_ALL);
+    ReportLatency("key", INPUT_LATENCY_KEY);
+    ReportLatency("pad", INPUT_LATENCY_PAD);
+}
+
+//------------------------------------------------------------------------------
+// 計測：入力が何も変わらないフレームの Update（変化の検出で省ける処理の効果）
+// パッドは4つとも接続し、スティックを倒したまま・アクションも割り当てた状態で比べる
+// 変化するフレームは、毎フレームパッド1つのスティックを動かす場合と、キーを押す・離す場合
+//------------------------------------------------------------------------------
+SELF_BENCH(InputIdleFrame)
+{
+    static const ActionBinding bindings[] =
+    {
+        BindKey(0, 'Z'),
+        BindPadButton(1, XINPUT_GAMEPAD_A),
+        BindPadAxis(2, ACTION_AXIS_THUMB_LX),
+    };
+
+    ScopedScriptedInput scripted;
+    auto& input = CInputManager::GetInstance();
+    input.GetActionMap().PushContext(bindings);
+
+    XINPUT_GAMEPAD gamepad;
+    ZeroMemory(&gamepad, sizeof(gamepad));
+    gamepad.sThumbLX = 20000;
+    for (int i = 0; i < XUSER_MAX_COUNT; ++i)
+    {
+        scripted.pads.SetConnected(i, true);
+        scripted.pads.SetGamepad(i, gamepad);
+    }
+    input.ProbePadsNow();
+    for (int frame = 0; frame < 10; ++frame)
+        input.Update();
+
+    // 何も変わらない
+    int changed = 0;
+    double start = CSelfTest::GetTimeUs();
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        input.Update();
+        changed += input.IsInputChanged() ? 1 : 0;
+    }
+    double idle = CSelfTest::GetTimeUs() - start;
+    int idleChanged = changed;
+
+    // パッド1つのスティックが毎フレーム動く
+    changed = 0;
+    start = CSelfTest::GetTimeUs();
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        gamepad.sThumbLX = static_cast<SHORT>(20000 + (frame & 1023));
+        scripted.pads.SetGamepad(0, gamepad);
+        input.Update();
+        changed += input.IsPadDirty(0) ? 1 : 0;
+    }
+    double pad = CSelfTest::GetTimeUs() - start;
+    int padChanged = changed;
+
+    // キーを毎フレーム押す・離す
+    int base = scripted.keyboard.GetFrame();
+    for (int frame = 0; frame < FRAMES; ++frame)
+        scripted.keyboard.AddEvent(base + frame, 'Z', frame % 2 == 0);
+    changed = 0;
+    start = CSelfTest::GetTimeUs();
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        input.Update();
+        changed += input.IsKeyboardDirty() ? 1 : 0;
+    }
+    double key = CSelfTest::GetTimeUs() - start;
+    int keyChanged = changed;
+
+    input.GetActionMap().PopContext();
+
+    CSelfTest::Report("  idle        : %.1f ns/frame, changed %d/%d", idle * 1000.0 / FRAMES, idleChanged, FRAMES);
+    CSelfTest::Report("  pad stick   : %.1f ns/frame, changed %d/%d", pad * 1000.0 / FRAMES, padChanged, FRAMES);
+    CSelfTest::Report("  key toggle  : %.1f ns/frame, changed %d/%d", key * 1000.0 / FRAMES, keyChanged, FRAMES);
+}
+
+//------------------------------------------------------------------------------
+// 計測：8個のキーを1つずつ調べる場合と、QueryKeys でまとめて調べる場合
+// 同じ決まった順のキー入力で、フレームごとに Update してから何度も問い合わせる
+// 一覧の先頭を毎回ずらして、結果をループの外に出せないようにする
+//------------------------------------------------------------------------------
+SELF_BENCH(InputQueryKeys)
+{
+    static const BYTE KEYS[16] = { 'A', 'D', 'W', 'S', VK_SPACE, 'Q', 'E', 'R', 'A', 'D', 'W', 'S', VK_SPACE, 'Q', 'E', 'R' };
+    const int QUERY_KEYS = 8;
+    const int SCRIPT_FRAMES = 1000;
+    const int REPEAT = 2000;
+
+    ScopedScriptedInput scripted;
+    auto& input = CInputManager::GetInstance();
+
+    // フレームごとにキーを1つ押す・離す（押したままのキーも、エッジのあるキーもある）
+    int base = scripted.keyboard.GetFrame();
+    for (int frame = 0; frame < SCRIPT_FRAMES; ++frame)
+        scripted.keyboard.AddEvent(base + frame, KEYS[frame % QUERY_KEYS], (frame / QUERY_KEYS) % 2 == 0);
+
+    enum { GUARDED, INLINE, INLINE_EDGES, BATCH, METHOD_COUNT };
+    double elapsed[METHOD_COUNT] = {};
+    DWORD sum[METHOD_COUNT] = {};     // 方法ごとの結果の合計（すべて同じ結果になるはず）
+    DWORD batchPress = 0;
+    for (int frame = 0; frame < SCRIPT_FRAMES; ++frame)
+    {
+        input.Update();
+
+        // 以前の書き方：初期化の確認 + インライン化されない呼び出し（押されているかだけ）
+        double start = CSelfTest::GetTimeUs();
+        for (int i = 0; i < REPEAT; ++i)
+        {
+            const BYTE* keys = KEYS + (i & 7);
+            DWORD press = 0;
+            for (int k = 0; k < QUERY_KEYS; ++k)
+                press |= static_cast<DWORD>(g_isKeyPressOutOfLine(GetInstanceGuarded(), keys[k])) << k;
+            sum[GUARDED] += press;
+        }
+        elapsed[GUARDED] += CSelfTest::GetTimeUs() - start;
+
+        // 今の IsKeyPress（押されているかだけ）
+        start = CSelfTest::GetTimeUs();
+        for (int i = 0; i < REPEAT; ++i)
+        {
+            const BYTE* keys = KEYS + (i & 7);
+            DWORD press = 0;
+            for (int k = 0; k < QUERY_KEYS; ++k)
+                press |= static_cast<DWORD>(CInputManager::GetInstance().IsKeyPress(keys[k])) << k;
+            sum[INLINE] += press;
+        }
+        elapsed[INLINE] += CSelfTest::GetTimeUs() - start;
+
+        // 今の IsKeyPress / IsKeyTrigger / IsKeyRelease（QueryKeys と同じ結果を作る）
+        start = CSelfTest::GetTimeUs();
+        for (int i = 0; i < REPEAT; ++i)
+        {
+            const BYTE* keys = KEYS + (i & 7);
+            InputQueryMasks masks = { 0, 0, 0 };
+            for (int k = 0; k < QUERY_KEYS; ++k)
+            {
+                const CInputManager& in = CInputManager::GetInstance();
+                masks.press |= static_cast<DWORD>(in.IsKeyPress(keys[k])) << k;
+                masks.trigger |= static_cast<DWORD>(in.IsKeyTrigger(keys[k])) << k;
+                masks.release |= static_cast<DWORD>(in.IsKeyRelease(keys[k])) << k;
+            }
+            sum[INLINE_EDGES] += masks.press + masks.trigger + masks.release;
+        }
+        elapsed[INLINE_EDGES] += CSelfTest::GetTimeUs() - start;
+
+        // QueryKeys でまとめて
+        start = CSelfTest::GetTimeUs();
+        for (int i = 0; i < REPEAT; ++i)
+        {
+            InputQueryMasks masks = CInputManager::GetInstance().QueryKeys(KEYS + (i & 7), QUERY_KEYS);
+            sum[BATCH] += masks.press + masks.trigger + masks.release;
+            batchPress += masks.press;
+        }
+        elapsed[BATCH] += CSelfTest::GetTimeUs() - start;
+    }
+
+    const double calls = static_cast<double>(SCRIPT_FRAMES) * REPEAT;
+    CSelfTest::Report("  guarded + out-of-line IsKeyPress x8 : %.2f ns", elapsed[GUARDED] * 1000.0 / calls);
+    CSelfTest::Report("  inline IsKeyPress x8                : %.2f ns", elapsed[INLINE] * 1000.0 / calls);
+    CSelfTest::Report("  inline Press/Trigger/Release x8     : %.2f ns", elapsed[INLINE_EDGES] * 1000.0 / calls);
+    CSelfTest::Report("  QueryKeys (8 keys, 3 masks)         : %.2f ns", elapsed[BATCH] * 1000.0 / calls);
+    bool match = sum[GUARDED] == batchPress && sum[INLINE] == batchPress && sum[INLINE_EDGES] == sum[BATCH];
+    CSelfTest::Report("  results %s", match ? "match" : "DIFFER");
+}
@@ -0,0 +1,631 @@
+#include "CInputRecording.h"
+#include "PadButtons.h"
+
+//------------------------------------------------------------------------------
+// InputFrame：すべて0にする
+//------------------------------------------------------------------------------
+void InputFrame::Clear()
+{
+    keys.Clear();
+    keyTrigger.Clear();
+    keyRelease.Clear();
+    ZeroMemory(pads, sizeof(pads));
+    ZeroMemory(padTrigger, sizeof(padTrigger));
+    ZeroMemory(padRelease, sizeof(padRelease));
+    connectedMask = 0;
+    frameTimeUs = 0;
+    ZeroMemory(thumbs, sizeof(thumbs));
+    ZeroMemory(padButtons, sizeof(padButtons));
+}
+
+//------------------------------------------------------------------------------
+// 符号化の補助関数
+//------------------------------------------------------------------------------
+namespace
+{
+    // フラグのビット
+    const BYTE FLAG_KEYS = 0x01;
+    const BYTE FLAG_KEY_EDGES = 0x02;
+    const BYTE FLAG_PAD0 = 0x04; // FLAG_PAD0 << スロット番号
+    const BYTE FLAG_FRAME_TIME = 0x40;
+    const BYTE FLAG_KEYFRAME = 0x80;
+
+    // パッドごとの変化フィールドのビット
+    const BYTE FIELD_BUTTONS = 0x01;
+    const BYTE FIELD_LEFT_TRIGGER = 0x02;
+    const BYTE FIELD_RIGHT_TRIGGER = 0x04;
+    const BYTE FIELD_THUMB_LX = 0x08;
+    const BYTE FIELD_THUMB_LY = 0x10;
+    const BYTE FIELD_THUMB_RX = 0x20;
+    const BYTE FIELD_THUMB_RY = 0x40;
+    const BYTE FIELD_MISC = 0x80;   // 接続状態とエッジ補正
+
+    const size_t HEADER_SIZE = 8;
+
+    // 7bit ずつの可変長整数
+    void PutVarint(std::vector<BYTE>& out, ULONGLONG value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<BYTE>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<BYTE>(value));
+    }
+
+    bool GetVarint(const BYTE*& p, const BYTE* end, ULONGLONG& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (p >= end)
+                return false;
+            BYTE b = *p++;
+            value |= static_cast<ULONGLONG>(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    // 符号付きの差分は絶対値が小さいほど短くなるように変換する
+    void PutZigzag(std::vector<BYTE>& out, LONGLONG value)
+    {
+        PutVarint(out, (static_cast<ULONGLONG>(value) << 1) ^ static_cast<ULONGLONG>(value >> 63));
+    }
+
+    bool GetZigzag(const BYTE*& p, const BYTE* end, LONGLONG& value)
+    {
+        ULONGLONG raw;
+        if (!GetVarint(p, end, raw))
+            return false;
+        value = static_cast<LONGLONG>(raw >> 1) ^ -static_cast<LONGLONG>(raw & 1);
+        return true;
+    }
+
+    // ビットの立っているキー番号の一覧（個数 + キー番号）
+    void PutKeyList(std::vector<BYTE>& out, const CKeyBitset& bits)
+    {
+        int count = 0;
+        bits.ForEach([&count](int) { ++count; });
+        PutVarint(out, count);
+        bits.ForEach([&out](int key) { out.push_back(static_cast<BYTE>(key)); });
+    }
+
+    bool GetKeyList(const BYTE*& p, const BYTE* end, CKeyBitset& bits)
+    {
+        ULONGLONG count;
+        if (!GetVarint(p, end, count) || count > static_cast<ULONGLONG>(end - p))
+            return false;
+        bits.Clear();
+        for (ULONGLONG i = 0; i < count; ++i)
+            bits.Set(*p++);
+        return true;
+    }
+
+    CKeyBitset XorBits(const CKeyBitset& a, const CKeyBitset& b)
+    {
+        CKeyBitset result;
+        for (int i = 0; i < CKeyBitset::WORD_COUNT; ++i)
+            result.word[i] = a.word[i] ^ b.word[i];
+        return result;
+    }
+
+    // スティックの差分
+    void PutAxis(std::vector<BYTE>& out, SHORT now, SHORT base)
+    {
+        PutZigzag(out, static_cast<LONGLONG>(now) - base);
+    }
+
+    bool GetAxis(const BYTE*& p, const BYTE* end, SHORT& axis)
+    {
+        LONGLONG delta;
+        if (!GetZigzag(p, end, delta))
+            return false;
+        axis = static_cast<SHORT>(axis + delta);
+        return true;
+    }
+
+    //--------------------------------------------------------------------------
+    // 1フレーム分を base からの差分として書き出す
+    // エッジは「base → cur の状態変化から分かる分」との差（フレーム内の押して
+    // 離した等）だけを書くので、普通のフレームでは0byte になる
+    //--------------------------------------------------------------------------
+    void EncodeFrame(const InputFrame& base, const InputFrame& cur, int padCount,
+        bool keyframe, std::vector<BYTE>& out)
+    {
+        size_t flagPos = out.size();
+        out.push_back(0);
+        BYTE flags = keyframe ? FLAG_KEYFRAME : 0;
+
+        //--- キー ---
+        CKeyBitset toggled = XorBits(cur.keys, base.keys);
+        if (toggled.Any())
+        {
+            flags |= FLAG_KEYS;
+            PutKeyList(out, toggled);
+        }
+
+        CKeyBitset trigger, release;
+        ComputeKeyEdges(cur.keys, base.keys, trigger, release);
+        CKeyBitset extraTrigger = XorBits(cur.keyTrigger, trigger);
+        CKeyBitset extraRelease = XorBits(cur.keyRelease, release);
+        if (extraTrigger.Any() || extraRelease.Any())
+        {
+            flags |= FLAG_KEY_EDGES;
+            PutKeyList(out, extraTrigger);
+            PutKeyList(out, extraRelease);
+        }
+
+        //--- ゲームパッド ---
+        for (int i = 0; i < padCount; ++i)
+        {
+            const XINPUT_GAMEPAD& a = base.pads[i];
+            const XINPUT_GAMEPAD& b = cur.pads[i];
+            DWORD baseButtons = MakePadButtons(a);
+            DWORD buttons = MakePadButtons(b);
+            DWORD extraPadTrigger = cur.padTrigger[i] ^ (buttons & ~baseButtons);
+            DWORD extraPadRelease = cur.padRelease[i] ^ (~buttons & baseButtons);
+            BYTE bit = static_cast<BYTE>(1 << i);
+
+            BYTE fields = 0;
+            if (a.wButtons != b.wButtons) fields |= FIELD_BUTTONS;
+            if (a.bLeftTrigger != b.bLeftTrigger) fields |= FIELD_LEFT_TRIGGER;
+            if (a.bRightTrigger != b.bRightTrigger) fields |= FIELD_RIGHT_TRIGGER;
+            if (a.sThumbLX != b.sThumbLX) fields |= FIELD_THUMB_LX;
+            if (a.sThumbLY != b.sThumbLY) fields |= FIELD_THUMB_LY;
+            if (a.sThumbRX != b.sThumbRX) fields |= FIELD_THUMB_RX;
+            if (a.sThumbRY != b.sThumbRY) fields |= FIELD_THUMB_RY;
+            if (((base.connectedMask ^ cur.connectedMask) & bit) || extraPadTrigger || extraPadRelease)
+                fields |= FIELD_MISC;
+            if (!fields)
+                continue;
+
+            flags |= FLAG_PAD0 << i;
+            out.push_back(fields);
+            if (fields & FIELD_BUTTONS)
+            {
+                out.push_back(LOBYTE(b.wButtons));
+                out.push_back(HIBYTE(b.wButtons));
+            }
+            if (fields & FIELD_LEFT_TRIGGER) out.push_back(b.bLeftTrigger);
+            if (fields & FIELD_RIGHT_TRIGGER) out.push_back(b.bRightTrigger);
+            if (fields & FIELD_THUMB_LX) PutAxis(out, b.sThumbLX, a.sThumbLX);
+            if (fields & FIELD_THUMB_LY) PutAxis(out, b.sThumbLY, a.sThumbLY);
+            if (fields & FIELD_THUMB_RX) PutAxis(out, b.sThumbRX, a.sThumbRX);
+            if (fields & FIELD_THUMB_RY) PutAxis(out, b.sThumbRY, a.sThumbRY);
+            if (fields & FIELD_MISC)
+            {
+                out.push_back((cur.connectedMask & bit) ? 1 : 0);
+                PutVarint(out, extraPadTrigger);
+                PutVarint(out, extraPadRelease);
+            }
+        }
+
+        //--- フレーム時間 ---
+        if (cur.frameTimeUs != base.frameTimeUs)
+        {
+            flags |= FLAG_FRAME_TIME;
+            PutZigzag(out, static_cast<LONGLONG>(cur.frameTimeUs) - base.frameTimeUs);
+        }
+
+        out[flagPos] = flags;
+    }
+
+    //--------------------------------------------------------------------------
+    // 1フレーム分を読み出して state を更新する（EncodeFrame の逆）
+    //--------------------------------------------------------------------------
+    bool DecodeFrame(const BYTE*& p, const BYTE* end, int padCount, InputFrame& state, bool& keyframe)
+    {
+        if (p >= end)
+            return false;
+        BYTE flags = *p++;
+        keyframe = (flags & FLAG_KEYFRAME) != 0;
+        if (keyframe)
+            state.Clear();
+
+        //--- キー ---
+        CKeyBitset baseKeys = state.keys;
+        if (flags & FLAG_KEYS)
+        {
+            CKeyBitset toggled;
+            if (!GetKeyList(p, end, toggled))
+                return false;
+            state.keys = XorBits(state.keys, toggled);
+        }
+
+        ComputeKeyEdges(state.keys, baseKeys, state.keyTrigger, state.keyRelease);
+        if (flags & FLAG_KEY_EDGES)
+        {
+            CKeyBitset extraTrigger, extraRelease;
+            if (!GetKeyList(p, end, extraTrigger) || !GetKeyList(p, end, extraRelease))
+                return false;
+            state.keyTrigger = XorBits(state.keyTrigger, extraTrigger);
+            state.keyRelease = XorBits(state.keyRelease, extraRelease);
+        }
+
+        //--- ゲームパッド ---
+        for (int i = 0; i < padCount; ++i)
+        {
+            XINPUT_GAMEPAD& b = state.pads[i];
+            DWORD baseButtons = MakePadButtons(b);
+            ULONGLONG extraPadTrigger = 0;
+            ULONGLONG extraPadRelease = 0;
+
+            if (flags & (FLAG_PAD0 << i))
+            {
+                if (p >= end)
+                    return false;
+                BYTE fields = *p++;
+                if (fields & FIELD_BUTTONS)
+                {
+                    if (end - p < 2)
+                        return false;
+                    b.wButtons = MAKEWORD(p[0], p[1]);
+                    p += 2;
+                }
+                if (fields & FIELD_LEFT_TRIGGER)
+                {
+                    if (p >= end)
+                        return false;
+                    b.bLeftTrigger = *p++;
+                }
+                if (fields & FIELD_RIGHT_TRIGGER)
+                {
+                    if (p >= end)
+                        return false;
+                    b.bRightTrigger = *p++;
+                }
+                if ((fields & FIELD_THUMB_LX) && !GetAxis(p, end, b.sThumbLX)) return false;
+                if ((fields & FIELD_THUMB_LY) && !GetAxis(p, end, b.sThumbLY)) return false;
+                if ((fields & FIELD_THUMB_RX) && !GetAxis(p, end, b.sThumbRX)) return false;
+                if ((fields & FIELD_THUMB_RY) && !GetAxis(p, end, b.sThumbRY)) return false;
+                if (fields & FIELD_MISC)
+                {
+                    if (p >= end)
+                        return false;
+                    BYTE bit = static_cast<BYTE>(1 << i);
+                    if (*p++)
+                        state.connectedMask |= bit;
+                    else
+                        state.connectedMask &= ~bit;
+                    if (!GetVarint(p, end, extraPadTrigger) || !GetVarint(p, end, extraPadRelease))
+                        return false;
+                }
+            }
+
+            DWORD buttons = MakePadButtons(b);
+            state.padTrigger[i] = (buttons & ~baseButtons) ^ static_cast<DWORD>(extraPadTrigger);
+            state.padRelease[i] = (~buttons & baseButtons) ^ static_cast<DWORD>(extraPadRelease);
+        }
+
+        //--- フレーム時間 ---
+        if (flags & FLAG_FRAME_TIME)
+        {
+            LONGLONG delta;
+            if (!GetZigzag(p, end, delta))
+                return false;
+            state.frameTimeUs = static_cast<LONG>(state.frameTimeUs + delta);
+        }
+        return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+// CInputRecorder
+//------------------------------------------------------------------------------
+CInputRecorder::CInputRecorder()
+    : m_file(INVALID_HANDLE_VALUE)
+    , m_padCount(0)
+    , m_frameCount(0)
+{
+    m_prev.Clear();
+}
+
+CInputRecorder::~CInputRecorder()
+{
+    Close();
+}
+
+//------------------------------------------------------------------------------
+// 記録ファイルを作成してヘッダを書く
+//------------------------------------------------------------------------------
+bool CInputRecorder::Open(const wchar_t* path, int padCount)
+{
+    Close();
+
+    m_file = CreateFile(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    m_padCount = padCount;
+    m_frameCount = 0;
+    m_prev.Clear();
+    m_buffer.clear();
+    m_buffer.reserve(64 * 1024);
+
+    // ヘッダ
+    for (int i = 0; i < 4; ++i)
+        m_buffer.push_back(static_cast<BYTE>(INPUT_RECORD_MAGIC >> (i * 8)));
+    m_buffer.push_back(LOBYTE(INPUT_RECORD_VERSION));
+    m_buffer.push_back(HIBYTE(INPUT_RECORD_VERSION));
+    m_buffer.push_back(static_cast<BYTE>(padCount));
+    m_buffer.push_back(0);
+    return true;
+}
+
+void CInputRecorder::Close()
+{
+    if (m_file == INVALID_HANDLE_VALUE)
+        return;
+
+    Flush();
+    CloseHandle(m_file);
+    m_file = INVALID_HANDLE_VALUE;
+}
+
+bool CInputRecorder::IsOpen() const
+{
+    return m_file != INVALID_HANDLE_VALUE;
+}
+
+//------------------------------------------------------------------------------
+// 1フレーム分を書き込む（ある程度溜まったらまとめてファイルへ）
+//------------------------------------------------------------------------------
+void CInputRecorder::Write(const InputFrame& frame)
+{
+    if (!IsOpen())
+        return;
+
+    bool keyframe = (m_frameCount % INPUT_RECORD_KEYFRAME_INTERVAL) == 0;
+    InputFrame zero;
+    zero.Clear();
+    EncodeFrame(keyframe ? zero : m_prev, frame, m_padCount, keyframe, m_buffer);
+
+    m_prev = frame;
+    ++m_frameCount;
+
+    if (m_buffer.size() >= 60 * 1024)
+        Flush();
+}
+
+DWORD CInputRecorder::GetFrameCount() const
+{
+    return m_frameCount;
+}
+
+void CInputRecorder::Flush()
+{
+    if (m_buffer.empty())
+        return;
+
+    DWORD dwWritten = 0;
+    WriteFile(m_file, m_buffer.data(), static_cast<DWORD>(m_buffer.size()), &dwWritten, nullptr);
+    m_buffer.clear();
+}
+
+//------------------------------------------------------------------------------
+// CInputReplay
+//------------------------------------------------------------------------------
+CInputReplay::CInputReplay()
+    : m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(nullptr)
+    , m_data(nullptr)
+    , m_size(0)
+    , m_padCount(0)
+    , m_frameCount(0)
+    , m_offset(0)
+    , m_position(0)
+{
+    m_state.Clear();
+}
+
+CInputReplay::~CInputReplay()
+{
+    Close();
+}
+
+//------------------------------------------------------------------------------
+// 記録ファイルをメモリマップし、全フレームを一度なめてキーフレームの位置を調べる
+// 途中で壊れている場合は、そこまでを有効なフレームとして扱う
+//------------------------------------------------------------------------------
+bool CInputReplay::Open(const wchar_t* path)
+{
+    Close();
+
+    m_file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart < static_cast<LONGLONG>(HEADER_SIZE))
+    {
+        Close();
+        return false;
+    }
+
+    m_mapping = CreateFileMapping(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping)
+    {
+        Close();
+        return false;
+    }
+
+    m_data = static_cast<const BYTE*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data)
+    {
+        Close();
+        return false;
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+
+    // ヘッダの確認
+    DWORD magic = m_data[0] | (m_data[1] << 8) | (m_data[2] << 16) | (static_cast<DWORD>(m_data[3]) << 24);
+    WORD version = MAKEWORD(m_data[4], m_data[5]);
+    m_padCount = m_data[6];
+    if (magic != INPUT_RECORD_MAGIC || version != INPUT_RECORD_VERSION || m_padCount > XUSER_MAX_COUNT)
+    {
+        Close();
+        return false;
+    }
+
+    // キーフレームの位置を集める
+    const BYTE* p = m_data + HEADER_SIZE;
+    const BYTE* end = m_data + m_size;
+    InputFrame state;
+    state.Clear();
+    m_frameCount = 0;
+    m_keyframes.clear();
+    while (p < end)
+    {
+        const BYTE* frameStart = p;
+        bool keyframe;
+        if (!DecodeFrame(p, end, m_padCount, state, keyframe))
+            break;
+        if (m_frameCount % INPUT_RECORD_KEYFRAME_INTERVAL == 0)
+        {
+            if (!keyframe)
+                break;
+            m_keyframes.push_back(frameStart - m_data);
+        }
+        ++m_frameCount;
+    }
+
+    return Seek(0);
+}
+
+void CInputReplay::Close()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+    m_size = 0;
+    m_frameCount = 0;
+    m_keyframes.clear();
+    m_offset = 0;
+    m_position = 0;
+}
+
+bool CInputReplay::IsOpen() const
+{
+    return m_data != nullptr;
+}
+
+//------------------------------------------------------------------------------
+// 次のフレームを読み出す
+//------------------------------------------------------------------------------
+bool CInputReplay::Next(InputFrame& frame)
+{
+    if (!IsOpen() || m_position >= m_frameCount)
+        return false;
+
+    const BYTE* p = m_data + m_offset;
+    bool keyframe;
+    if (!DecodeFrame(p, m_data + m_size, m_padCount, m_state, keyframe))
+        return false;
+
+    m_offset = p - m_data;
+    ++m_position;
+    frame = m_state;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// シーク：直前のキーフレームから目的のフレームの手前まで読み進める
+// 読み進めるのは最大 KEYFRAME_INTERVAL - 1 フレーム
+//------------------------------------------------------------------------------
+bool CInputReplay::Seek(DWORD frame)
+{
+    if (!IsOpen() || frame > m_frameCount)
+        return false;
+
+    size_t index = frame / INPUT_RECORD_KEYFRAME_INTERVAL;
+    if (index >= m_keyframes.size())
+    {
+        // 最後のフレームのさらに後ろ（読み出せるフレームはもうない）
+        m_offset = m_size;
+        m_position = m_frameCount;
+        return true;
+    }
+
+    m_offset = m_keyframes[index];
+    m_position = static_cast<DWORD>(index * INPUT_RECORD_KEYFRAME_INTERVAL);
+    m_state.Clear();
+
+    InputFrame skipped;
+    while (m_position < frame)
+    {
+        if (!Next(skipped))
+            return false;
+    }
+    return true;
+}
+
+DWORD CInputReplay::GetFrameCount() const
+{
+    return m_frameCount;
+}
+
+DWORD CInputReplay::GetPosition() const
+{
+    return m_position;
+}
+
+int CInputReplay::GetPadCount() const
+{
+    return m_padCount;
+}
+
+//------------------------------------------------------------------------------
+// CReplayKeyboardSource
+//------------------------------------------------------------------------------
+CReplayKeyboardSource::CReplayKeyboardSource()
+    : m_step(3)
+    , m_timestamp(0)
+{
+    m_reported.Clear();
+}
+
+//------------------------------------------------------------------------------
+// 前の状態 p、エッジ trigger / release、最後の状態 s から
+//   1. p から release のキーを離す
+//   2. trigger のキーを押す
+//   3. s にする（フレーム内で押して離したキーはここで離す）
+// の順にイベントを作る
+//------------------------------------------------------------------------------
+void CReplayKeyboardSource::SetFrame(const InputFrame& frame, LONGLONG timestamp)
+{
+    for (int i = 0; i < CKeyBitset::WORD_COUNT; ++i)
+    {
+        m_steps[0].word[i] = m_reported.word[i] & ~frame.keyRelease.word[i];
+        m_steps[1].word[i] = m_steps[0].word[i] | frame.keyTrigger.word[i];
+    }
+    m_steps[2] = frame.keys;
+    m_step = 0;
+    m_timestamp = timestamp;
+}
+
+void CReplayKeyboardSource::Reset()
+{
+    m_step = 3;
+    m_reported.Clear();
+}
+
+int CReplayKeyboardSource::Fetch(KeyEvent* events, int maxEvents)
+{
+    int count = 0;
+    while (m_step < 3 && count < maxEvents)
+    {
+        count = EmitKeyDiff(m_steps[m_step], m_reported, m_timestamp, events, count, maxEvents);
+        if (m_reported == m_steps[m_step])
+            ++m_step;
+    }
+    return count;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <windows.h>
+#include <Xinput.h>
+#include <vector>
+#include "CKeyBitset.h"
+#include "CKeyboardSource.h"
+
+//------------------------------------------------------------------------------
+// InputFrame
+// 記録・再生する1フレーム分の入力状態
+//------------------------------------------------------------------------------
+struct InputFrame
+{
+    CKeyBitset keys;                            // キー状態
+    CKeyBitset keyTrigger;                      // このフレームで押されたキー
+    CKeyBitset keyRelease;                      // このフレームで離されたキー
+    XINPUT_GAMEPAD pads[XUSER_MAX_COUNT];       // ゲームパッド状態（取得した値のまま）
+    DWORD padTrigger[XUSER_MAX_COUNT];          // このフレームで押されたボタン（ボタンワードのビット）
+    DWORD padRelease[XUSER_MAX_COUNT];          // このフレームで離されたボタン
+    BYTE connectedMask;                         // bit i = スロット i が接続中
+    LONG frameTimeUs;                           // Window::GetFrameTime()（マイクロ秒）
+
+    // 以下は記録しない（再生時は pads から計算し直す）
+    float thumbs[XUSER_MAX_COUNT][4];           // スティックの処理後の値（LX, LY, RX, RY）
+    DWORD padButtons[XUSER_MAX_COUNT];          // ボタンワード（仮想ボタンを含む）
+
+    void Clear();
+};
+
+//------------------------------------------------------------------------------
+// 記録ファイルの形式
+//   ヘッダ（8byte）："NKIR" + バージョン(WORD) + スロット数(BYTE) + 予備(BYTE)
+//   以降フレームごとに、前フレームからの差分だけを書く
+//     フラグ(BYTE)：bit0 キー状態 / bit1 キーのエッジ補正 / bit2~5 各パッド /
+//                   bit6 フレーム時間 / bit7 キーフレーム（全状態を0からの差分で書く）
+//   変化のないフレームは、フラグとフレーム時間の差分の数byteで済む
+//   KEYFRAME_INTERVAL フレームごとにキーフレームを入れ、シークの起点にする
+//------------------------------------------------------------------------------
+const DWORD INPUT_RECORD_MAGIC = 0x52494B4E; // "NKIR"
+const WORD INPUT_RECORD_VERSION = 1;
+const int INPUT_RECORD_KEYFRAME_INTERVAL = 256;
+
+//------------------------------------------------------------------------------
+// CInputRecorder
+// InputFrame を差分符号化してファイルへ書き出す
+//------------------------------------------------------------------------------
+class CInputRecorder
+{
+public:
+    CInputRecorder();
+    ~CInputRecorder();
+
+    bool Open(const wchar_t* path, int padCount);
+    void Close();
+    bool IsOpen() const;
+
+    // 1フレーム分を書き込む
+    void Write(const InputFrame& frame);
+
+    DWORD GetFrameCount() const;
+
+private:
+    void Flush();
+
+    HANDLE m_file;
+    int m_padCount;
+    DWORD m_frameCount;
+    InputFrame m_prev;              // 前フレームの状態（差分の基準）
+    std::vector<BYTE> m_buffer;     // 書き込み待ちのデータ
+};
+
+//------------------------------------------------------------------------------
+// CInputReplay
+// 記録ファイルをメモリマップして、フレーム単位で読み出す
+// 開いた時点でキーフレームの位置を調べておくので、シークはすぐに終わる
+//------------------------------------------------------------------------------
+class CInputReplay
+{
+public:
+    CInputReplay();
+    ~CInputReplay();
+
+    bool Open(const wchar_t* path);
+    void Close();
+    bool IsOpen() const;
+
+    // 次のフレームを読み出す（最後まで読んだら false）
+    bool Next(InputFrame& frame);
+
+    // frame フレーム目（0始まり）から読み出すようにする
+    bool Seek(DWORD frame);
+
+    DWORD GetFrameCount() const;
+    DWORD GetPosition() const;  // 次に読み出すフレーム番号
+    int GetPadCount() const;
+
+private:
+    HANDLE m_file;
+    HANDLE m_mapping;
+    const BYTE* m_data;
+    size_t m_size;
+
+    int m_padCount;
+    DWORD m_frameCount;
+    std::vector<size_t> m_keyframes;  // キーフレームのファイル内位置
+
+    size_t m_offset;                  // 次に読み出す位置
+    DWORD m_position;                 // 次に読み出すフレーム番号
+    InputFrame m_state;               // 最後に読み出した状態
+};
+
+//------------------------------------------------------------------------------
+// CReplayKeyboardSource
+// 再生中のフレームのキー状態とエッジを、キーイベントの並びに戻すソース
+// フレーム内で押して離したキーも Trigger / Release が再現される
+//------------------------------------------------------------------------------
+class CReplayKeyboardSource : public IKeyboardSource
+{
+public:
+    CReplayKeyboardSource();
+
+    // このフレームで再現する状態を設定する
+    void SetFrame(const InputFrame& frame, LONGLONG timestamp);
+
+    // 取り出し済みの状態を0に戻す（使い始めに呼ぶ）
+    void Reset();
+
+    int Fetch(KeyEvent* events, int maxEvents) override;
+
+private:
+    CKeyBitset m_steps[3];  // 順に到達させるキー状態
+    int m_step;
+    LONGLONG m_timestamp;
+    CKeyBitset m_reported;
+};
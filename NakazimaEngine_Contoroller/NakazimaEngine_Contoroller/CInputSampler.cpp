@@ -0,0 +1,203 @@
+#include "CInputSampler.h"
+#include "CFramePacer.h"
+#include <algorithm>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+// コンストラクタ / デストラクタ
+//------------------------------------------------------------------------------
+CInputSampler::CInputSampler()
+    : m_running(false)
+    , m_probeRequest(false)
+    , m_rateHz(1000)
+    , m_padCount(XUSER_MAX_COUNT)
+    , m_sampleKeyboard(true)
+    , m_padBackend(&m_xinputBackend)
+    , m_connectedMask(0)
+{
+    ZeroMemory(m_probeWait, sizeof(m_probeWait));
+}
+
+CInputSampler::~CInputSampler()
+{
+    Stop();
+}
+
+//------------------------------------------------------------------------------
+// サンプリング開始
+//------------------------------------------------------------------------------
+bool CInputSampler::Start(int rateHz, int padCount, bool sampleKeyboard, IPadBackend* padBackend)
+{
+    if (m_thread.joinable())
+        return false;
+
+    m_rateHz = (std::max)(1, rateHz);
+    m_padCount = (std::max)(0, (std::min)(padCount, static_cast<int>(XUSER_MAX_COUNT)));
+    m_sampleKeyboard = sampleKeyboard;
+    m_padBackend = padBackend ? padBackend : &m_xinputBackend;
+    m_connectedMask = 0;
+    ZeroMemory(m_probeWait, sizeof(m_probeWait));
+    m_ring.Clear();
+
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&CInputSampler::ThreadMain, this);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// サンプリング停止
+//------------------------------------------------------------------------------
+void CInputSampler::Stop()
+{
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+bool CInputSampler::IsRunning() const
+{
+    return m_running.load(std::memory_order_acquire);
+}
+
+bool CInputSampler::IsSamplingKeyboard() const
+{
+    return m_sampleKeyboard;
+}
+
+bool CInputSampler::Pop(InputSample& sample)
+{
+    return m_ring.Pop(sample);
+}
+
+void CInputSampler::ProbePadsNow()
+{
+    m_probeRequest.store(true, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+// サンプリングスレッド本体
+// 周期ごとに入力を取得し、前回積んだサンプルから変化があれば積む
+// リングが満杯のときは積めなかった状態を次の周期で積み直す
+//------------------------------------------------------------------------------
+void CInputSampler::ThreadMain()
+{
+    // 周期の待ち方はフレームレートの調整と同じ（締め切りの少し前までタイマーで眠り、残りはスピン）
+    // 1kHz ではミリ秒単位の Sleep では待てないので、スピンは周期の 1/4 までにしてコアを使い切らないようにする
+    // 大きく遅れた場合は追いつこうとせず仕切り直す
+    CFramePacer pacer;
+    pacer.SetTargetRate(m_rateHz);
+    pacer.SetSpinMs((std::min)(pacer.GetSpinMs(), 250.0 / m_rateHz));
+    pacer.SetMissPolicy(FRAME_MISS_RESYNC);
+    pacer.Start();
+
+    InputSample sample;
+    InputSample lastPushed;
+    bool hasLast = false;
+
+    while (m_running.load(std::memory_order_acquire))
+    {
+        TakeSample(sample);
+
+        bool changed = !hasLast ||
+            sample.connectedMask != lastPushed.connectedMask ||
+            sample.keys != lastPushed.keys ||
+            memcmp(sample.pads, lastPushed.pads, sizeof(sample.pads)) != 0;
+        if (changed && m_ring.Push(sample))
+        {
+            lastPushed = sample;
+            hasLast = true;
+        }
+
+        pacer.Wait();
+    }
+}
+
+//------------------------------------------------------------------------------
+// 現在の入力状態を1サンプル分取得する
+//------------------------------------------------------------------------------
+void CInputSampler::TakeSample(InputSample& sample)
+{
+    sample.timestamp = GetInputTimestamp();
+
+    //--- キーボード ---
+    sample.keys.Clear();
+    if (m_sampleKeyboard)
+    {
+        for (int i = 0; i < CKeyBitset::KEY_COUNT; ++i)
+        {
+            if (GetAsyncKeyState(i) & 0x8000)
+                sample.keys.Set(i);
+        }
+    }
+
+    //--- ゲームパッド ---
+    // 未接続スロットは PROBE_INTERVAL_MS ごとにだけ確認する
+    const int probeInterval = (std::max)(1, m_rateHz * PROBE_INTERVAL_MS / 1000);
+    bool probeAll = m_probeRequest.exchange(false, std::memory_order_acq_rel);
+
+    ZeroMemory(sample.pads, sizeof(sample.pads));
+    for (int i = 0; i < m_padCount; ++i)
+    {
+        BYTE bit = static_cast<BYTE>(1 << i);
+        if (!(m_connectedMask & bit) && !probeAll && --m_probeWait[i] > 0)
+            continue;
+
+        XINPUT_STATE state;
+        ZeroMemory(&state, sizeof(XINPUT_STATE));
+        if (m_padBackend->Read(i, state) == ERROR_SUCCESS)
+        {
+            sample.pads[i] = state.Gamepad;
+            m_connectedMask |= bit;
+        }
+        else
+        {
+            m_connectedMask &= ~bit;
+            m_probeWait[i] = probeInterval;
+        }
+    }
+    sample.connectedMask = m_connectedMask;
+}
+
+//------------------------------------------------------------------------------
+// CSampledKeyboardSource
+//------------------------------------------------------------------------------
+CSampledKeyboardSource::CSampledKeyboardSource()
+    : m_samples(nullptr)
+    , m_count(0)
+    , m_cursor(0)
+{
+    m_reported.Clear();
+}
+
+void CSampledKeyboardSource::SetSamples(const InputSample* samples, int count)
+{
+    m_samples = samples;
+    m_count = count;
+    m_cursor = 0;
+}
+
+void CSampledKeyboardSource::Reset()
+{
+    m_samples = nullptr;
+    m_count = 0;
+    m_cursor = 0;
+    m_reported.Clear();
+}
+
+//------------------------------------------------------------------------------
+// サンプルごとのキー状態の差分を、古いサンプルから順にイベントにする
+// 途中のサンプルで押して離したキーも、押下と解放の2イベントになる
+//------------------------------------------------------------------------------
+int CSampledKeyboardSource::Fetch(KeyEvent* events, int maxEvents)
+{
+    int count = 0;
+    while (m_cursor < m_count && count < maxEvents)
+    {
+        const InputSample& sample = m_samples[m_cursor];
+        const CKeyBitset& keys = sample.keys;
+        count = EmitKeyDiff(keys, m_reported, sample.timestamp, events, count, maxEvents);
+        if (m_reported == keys)
+            ++m_cursor;
+    }
+    return count;
+}
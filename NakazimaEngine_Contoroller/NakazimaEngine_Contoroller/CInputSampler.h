@@ -0,0 +1,100 @@
+#pragma once
+#include <windows.h>
+#include <Xinput.h>
+#include <atomic>
+#include <thread>
+#include "CKeyBitset.h"
+#include "CKeyboardSource.h"
+#include "CSpscRing.h"
+#include "CPadBackend.h"
+
+//------------------------------------------------------------------------------
+// InputSample
+// 入力サンプリングスレッドが取得した、ある時刻の入力状態
+//------------------------------------------------------------------------------
+struct InputSample
+{
+    LONGLONG timestamp;                     // 取得時刻（GetInputTimestamp の値）
+    CKeyBitset keys;                        // キー状態（キーボードを取得しない場合は0）
+    XINPUT_GAMEPAD pads[XUSER_MAX_COUNT];   // ゲームパッド状態（未接続は0）
+    BYTE connectedMask;                     // bit i が立っていればスロット i が接続中
+};
+
+//------------------------------------------------------------------------------
+// CInputSampler
+// 専用スレッドでキーボードとゲームパッドを一定周期（1kHz 等）で取得し、
+// 状態が変化したときだけサンプルをリングバッファへ積む
+// 描画フレームの間に起きた押下・解放も、サンプルとして取りこぼさず残る
+//------------------------------------------------------------------------------
+class CInputSampler
+{
+public:
+    static const unsigned int RING_SIZE = 256;
+
+    CInputSampler();
+    ~CInputSampler();
+
+    // サンプリング開始（すでに動いていれば false）
+    // ゲームパッドは padBackend から読む（nullptr なら XInputGetState、停止するまで差し替えない）
+    bool Start(int rateHz, int padCount, bool sampleKeyboard, IPadBackend* padBackend = nullptr);
+
+    // サンプリング停止（スレッドの終了を待つ）
+    void Stop();
+
+    bool IsRunning() const;
+    bool IsSamplingKeyboard() const;
+
+    // 溜まっているサンプルを古い順に1つ取り出す（ゲームスレッドから呼ぶ）
+    bool Pop(InputSample& sample);
+
+    // 未接続スロットを次のサンプルですぐに確認させる
+    void ProbePadsNow();
+
+private:
+    // 未接続スロットの確認間隔（ms）
+    static const int PROBE_INTERVAL_MS = 500;
+
+    void ThreadMain();
+    void TakeSample(InputSample& sample);
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_probeRequest;
+
+    int m_rateHz;
+    int m_padCount;
+    bool m_sampleKeyboard;
+    CXInputPadBackend m_xinputBackend;
+    IPadBackend* m_padBackend;
+
+    // 以下はサンプリングスレッドだけが触る
+    int m_probeWait[XUSER_MAX_COUNT];  // 未接続スロットの次の確認までのサンプル数
+    BYTE m_connectedMask;
+
+    CSpscRing<InputSample, RING_SIZE> m_ring;
+};
+
+//------------------------------------------------------------------------------
+// CSampledKeyboardSource
+// 1フレーム分のサンプル列のキー状態を、順番にキーイベントへ変換するソース
+// CInputManager がバックグラウンドサンプリング中に使う
+//------------------------------------------------------------------------------
+class CSampledKeyboardSource : public IKeyboardSource
+{
+public:
+    CSampledKeyboardSource();
+
+    // このフレームで変換するサンプル列を設定する
+    void SetSamples(const InputSample* samples, int count);
+
+    // 取り出し済みの状態を0に戻す（使い始めに呼ぶ）
+    void Reset();
+
+    int Fetch(KeyEvent* events, int maxEvents) override;
+
+private:
+    const InputSample* m_samples;
+    int m_count;
+    int m_cursor;
+    CKeyBitset m_reported;  // 取り出し済みのキー状態
+};
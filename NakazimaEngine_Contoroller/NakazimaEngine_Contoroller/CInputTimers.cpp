@@ -0,0 +1,171 @@
+#include "CInputTimers.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef INPUTLANES_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+#ifdef INPUTLANES_USE_SSE2
+    // 4bit の値 → 4レーン分のマスク（bit i が立っていればレーン i が全ビット1）
+    alignas(16) const uint32_t LANE_MASKS[16][4] =
+    {
+        { 0, 0, 0, 0 }, { ~0u, 0, 0, 0 }, { 0, ~0u, 0, 0 }, { ~0u, ~0u, 0, 0 },
+        { 0, 0, ~0u, 0 }, { ~0u, 0, ~0u, 0 }, { 0, ~0u, ~0u, 0 }, { ~0u, ~0u, ~0u, 0 },
+        { 0, 0, 0, ~0u }, { ~0u, 0, 0, ~0u }, { 0, ~0u, 0, ~0u }, { ~0u, ~0u, 0, ~0u },
+        { 0, 0, ~0u, ~0u }, { ~0u, 0, ~0u, ~0u }, { 0, ~0u, ~0u, ~0u }, { ~0u, ~0u, ~0u, ~0u },
+    };
+
+    __m128 LoadLaneMask(uint64_t word, int bit)
+    {
+        return _mm_load_ps(reinterpret_cast<const float*>(LANE_MASKS[(word >> bit) & 15]));
+    }
+#endif
+}
+
+//------------------------------------------------------------------------------
+// コンストラクタ
+//------------------------------------------------------------------------------
+CInputTimers::CInputTimers()
+{
+    Reset();
+}
+
+//------------------------------------------------------------------------------
+// すべて離して長い時間が経った状態に戻す
+// 最初の押下や再生の開始直後がダブルタップにならないよう、間隔は上限にしておく
+//------------------------------------------------------------------------------
+void CInputTimers::Reset()
+{
+    m_frameMs = 0.0f;
+    m_idleMs = 0.0f;
+    m_press.Clear();
+    m_trigger.Clear();
+    for (int i = 0; i < LANE_COUNT; ++i)
+    {
+        m_holdMs[i] = 0.0f;
+        m_lastHoldMs[i] = 0.0f;
+        m_sinceTapMs[i] = static_cast<float>(MAX_MS);
+        m_tapIntervalMs[i] = static_cast<float>(MAX_MS);
+    }
+}
+
+//------------------------------------------------------------------------------
+// フレームの結果で数え直す
+//------------------------------------------------------------------------------
+void CInputTimers::Update(const InputFrame& frame, bool changed)
+{
+    m_frameMs = frame.frameTimeUs > 0 ? frame.frameTimeUs / 1000.0f : 0.0f;
+
+    // 変わらないフレームは、押しているレーンの時間がそろって進むだけなので、足しておくだけにする
+    if (!changed)
+    {
+        m_trigger.Clear();
+        m_idleMs = (std::min)(m_idleMs + m_frameMs, static_cast<float>(MAX_MS));
+        return;
+    }
+
+    // 溜めていた分を、前のフレームの押下のまま（エッジなしで）進めてから数え直す
+    InputLaneBits release;
+    if (m_idleMs > 0.0f)
+    {
+        m_trigger.Clear();
+        release.Clear();
+        Advance(release, m_idleMs);
+        m_idleMs = 0.0f;
+    }
+
+    PackInputLanes(frame, m_press, m_trigger, release);
+    Advance(release, m_frameMs);
+}
+
+void CInputTimers::Advance(const InputLaneBits& release, float frameMs)
+{
+#ifdef INPUTLANES_USE_SSE2
+    UpdateSSE2(release, frameMs);
+#else
+    UpdateScalar(release, frameMs);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// スカラー版
+//   押し続けている時間：押していて、このフレームで押したのでなければ frameMs 進める（それ以外は0）
+//   離した瞬間：そこまで押していた時間を残す
+//   押した瞬間：前に押した瞬間からの時間を間隔として残し、数え直す
+//------------------------------------------------------------------------------
+void CInputTimers::UpdateScalar(const InputLaneBits& release, float frameMs)
+{
+    const float maxMs = static_cast<float>(MAX_MS);
+
+    for (int i = 0; i < LANE_COUNT; ++i)
+    {
+        bool press = m_press.Test(i);
+        bool trigger = m_trigger.Test(i);
+        bool released = release.Test(i);
+
+        float held = (std::min)(m_holdMs[i] + frameMs, maxMs);
+        if (released)
+            m_lastHoldMs[i] = held;
+        m_holdMs[i] = (press && !trigger) ? held : 0.0f;
+
+        float since = (std::min)(m_sinceTapMs[i] + frameMs, maxMs);
+        if (trigger)
+            m_tapIntervalMs[i] = since;
+        m_sinceTapMs[i] = trigger ? 0.0f : since;
+    }
+}
+
+#ifdef INPUTLANES_USE_SSE2
+//------------------------------------------------------------------------------
+// SSE2版（4レーンずつ、分岐なし）
+// 各ビット列の4bit ずつを表でマスクに広げ、選択は and / andnot / or で行う
+//------------------------------------------------------------------------------
+void CInputTimers::UpdateSSE2(const InputLaneBits& release, float frameMs)
+{
+    const __m128 dt = _mm_set1_ps(frameMs);
+    const __m128 maxMs = _mm_set1_ps(static_cast<float>(MAX_MS));
+
+    for (int i = 0; i < LANE_COUNT; i += 4)
+    {
+        int word = i >> 6;
+        int bit = i & 63;
+        __m128 press = LoadLaneMask(m_press.word[word], bit);
+        __m128 trigger = LoadLaneMask(m_trigger.word[word], bit);
+        __m128 released = LoadLaneMask(release.word[word], bit);
+
+        __m128 held = _mm_min_ps(_mm_add_ps(_mm_load_ps(m_holdMs + i), dt), maxMs);
+        __m128 lastHold = _mm_load_ps(m_lastHoldMs + i);
+        _mm_store_ps(m_lastHoldMs + i, _mm_or_ps(_mm_and_ps(released, held), _mm_andnot_ps(released, lastHold)));
+        _mm_store_ps(m_holdMs + i, _mm_and_ps(_mm_andnot_ps(trigger, press), held));
+
+        __m128 since = _mm_min_ps(_mm_add_ps(_mm_load_ps(m_sinceTapMs + i), dt), maxMs);
+        __m128 interval = _mm_load_ps(m_tapIntervalMs + i);
+        _mm_store_ps(m_tapIntervalMs + i, _mm_or_ps(_mm_and_ps(trigger, since), _mm_andnot_ps(trigger, interval)));
+        _mm_store_ps(m_sinceTapMs + i, _mm_andnot_ps(trigger, since));
+    }
+}
+#endif
+
+//------------------------------------------------------------------------------
+// キーリピート
+// 押し続けている時間の、前のフレームからこのフレームの間に
+// delayMs + intervalMs * n（n = 0, 1, 2, ...）をまたいだら true
+//------------------------------------------------------------------------------
+bool CInputTimers::IsRepeat(int lane, float delayMs, float intervalMs) const
+{
+    if (IsTrigger(lane))
+        return true;
+    if (!IsPress(lane))
+        return false;
+
+    float hold = GetHoldMs(lane);
+    float previous = hold - m_frameMs;
+    if (hold < delayMs)
+        return false;
+    if (previous < delayMs || intervalMs <= 0.0f)
+        return true;
+    return std::floor((hold - delayMs) / intervalMs) != std::floor((previous - delayMs) / intervalMs);
+}
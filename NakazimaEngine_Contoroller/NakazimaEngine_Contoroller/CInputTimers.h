@@ -0,0 +1,71 @@
+#pragma once
+#include <windows.h>
+#include "InputLanes.h"
+
+//------------------------------------------------------------------------------
+// CInputTimers
+// すべてのキーとゲームパッドのボタンの押している時間などを、毎フレームまとめて数える
+// 値ごとに全レーン（InputLanes.h）分の配列を持ち、SSE2 で4レーンずつ更新する
+// 更新の手間はフレームごとに一定で、調べる側は配列を1~2か所読むだけで済む
+// 時間はフレーム時間（InputFrame::frameTimeUs）で進むので、再生中も記録と同じ結果になる
+// 入力が変わらないフレームは経過時間を足しておくだけにし、次に変わったときにまとめて進める
+//------------------------------------------------------------------------------
+class CInputTimers
+{
+public:
+    static const int LANE_COUNT = INPUT_LANE_COUNT;
+
+    CInputTimers();
+
+    // すべて離して長い時間が経った状態に戻す
+    void Reset();
+
+    // フレームの結果で数え直す（CInputManager::Update から毎フレーム呼ぶ）
+    // changed = false なら、frame は前のフレームと同じ押下でエッジなしとみなしてよい
+    void Update(const InputFrame& frame, bool changed = true);
+
+    // 押し続けている時間（ms、押した瞬間のフレームは0、離している間も0）
+    float GetHoldMs(int lane) const
+    {
+        if (!IsPress(lane))
+            return 0.0f;
+        float hold = m_holdMs[lane] + m_idleMs;
+        return hold < MAX_MS ? hold : static_cast<float>(MAX_MS);
+    }
+
+    // 押し続けている時間が ms 以上か
+    bool IsHeld(int lane, float ms) const { return IsPress(lane) && GetHoldMs(lane) >= ms; }
+
+    // 直前に離したときまで押していた時間（ms、離した瞬間のフレームから次に離すまで変わらない）
+    float GetLastHoldMs(int lane) const { return m_lastHoldMs[lane]; }
+
+    // 押した瞬間で、その前に押した瞬間から windowMs 以内か
+    bool IsDoubleTap(int lane, float windowMs) const { return IsTrigger(lane) && m_tapIntervalMs[lane] <= windowMs; }
+
+    // キーリピート：押した瞬間と、押し続けて delayMs 経ってから intervalMs ごとに true
+    bool IsRepeat(int lane, float delayMs, float intervalMs) const;
+
+private:
+    bool IsPress(int lane) const { return m_press.Test(lane); }
+    bool IsTrigger(int lane) const { return m_trigger.Test(lane); }
+
+    // 全レーンを frameMs 進める（ビルド設定で速い実装を選ぶ）
+    void Advance(const InputLaneBits& release, float frameMs);
+    void UpdateScalar(const InputLaneBits& release, float frameMs);
+#ifdef INPUTLANES_USE_SSE2
+    void UpdateSSE2(const InputLaneBits& release, float frameMs);
+#endif
+
+    // 数える時間の上限（ms、float で frameMs を足しても桁落ちしない範囲に留める）
+    static const int MAX_MS = 10000000;
+
+    float m_frameMs;                        // このフレームの時間
+    float m_idleMs;                         // 入力が変わらなかったフレームの時間の合計（まだ進めていない分）
+    InputLaneBits m_press;                  // 押されているレーン
+    InputLaneBits m_trigger;                // このフレームで押されたレーン
+
+    alignas(16) float m_holdMs[LANE_COUNT];         // 押し続けている時間
+    alignas(16) float m_lastHoldMs[LANE_COUNT];     // 直前に離したときまで押していた時間
+    alignas(16) float m_sinceTapMs[LANE_COUNT];     // 最後に押した瞬間からの時間
+    alignas(16) float m_tapIntervalMs[LANE_COUNT];  // 最後に押した瞬間と、その前に押した瞬間の間隔
+};
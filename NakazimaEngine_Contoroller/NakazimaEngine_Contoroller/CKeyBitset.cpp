@@ -0,0 +1,72 @@
+#include "CKeyBitset.h"
+
+#if defined(KEYBITSET_USE_AVX2)
+#include <immintrin.h>
+#elif defined(KEYBITSET_USE_SSE2)
+#include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+// エッジ検出（ビルド設定で最速の実装を選ぶ）
+//------------------------------------------------------------------------------
+void ComputeKeyEdges(const CKeyBitset& now, const CKeyBitset& old,
+    CKeyBitset& trigger, CKeyBitset& release)
+{
+#if defined(KEYBITSET_USE_AVX2)
+    ComputeKeyEdgesAVX2(now, old, trigger, release);
+#elif defined(KEYBITSET_USE_SSE2)
+    ComputeKeyEdgesSSE2(now, old, trigger, release);
+#else
+    ComputeKeyEdgesScalar(now, old, trigger, release);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// スカラー版（64bit × 4回）
+//------------------------------------------------------------------------------
+void ComputeKeyEdgesScalar(const CKeyBitset& now, const CKeyBitset& old,
+    CKeyBitset& trigger, CKeyBitset& release)
+{
+    for (int i = 0; i < CKeyBitset::WORD_COUNT; ++i)
+    {
+        trigger.word[i] = now.word[i] & ~old.word[i];
+        release.word[i] = ~now.word[i] & old.word[i];
+    }
+}
+
+#ifdef KEYBITSET_USE_SSE2
+//------------------------------------------------------------------------------
+// SSE2版（128bit × 2回）
+// _mm_andnot_si128(a, b) は ~a & b を返す
+//------------------------------------------------------------------------------
+void ComputeKeyEdgesSSE2(const CKeyBitset& now, const CKeyBitset& old,
+    CKeyBitset& trigger, CKeyBitset& release)
+{
+    const __m128i* pNow = reinterpret_cast<const __m128i*>(now.word);
+    const __m128i* pOld = reinterpret_cast<const __m128i*>(old.word);
+    __m128i* pTrigger = reinterpret_cast<__m128i*>(trigger.word);
+    __m128i* pRelease = reinterpret_cast<__m128i*>(release.word);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        __m128i n = _mm_load_si128(pNow + i);
+        __m128i o = _mm_load_si128(pOld + i);
+        _mm_store_si128(pTrigger + i, _mm_andnot_si128(o, n));
+        _mm_store_si128(pRelease + i, _mm_andnot_si128(n, o));
+    }
+}
+#endif
+
+#ifdef KEYBITSET_USE_AVX2
+//------------------------------------------------------------------------------
+// AVX2版（256bit × 1回）
+//------------------------------------------------------------------------------
+void ComputeKeyEdgesAVX2(const CKeyBitset& now, const CKeyBitset& old,
+    CKeyBitset& trigger, CKeyBitset& release)
+{
+    __m256i n = _mm256_load_si256(reinterpret_cast<const __m256i*>(now.word));
+    __m256i o = _mm256_load_si256(reinterpret_cast<const __m256i*>(old.word));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(trigger.word), _mm256_andnot_si256(o, n));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(release.word), _mm256_andnot_si256(n, o));
+}
+#endif
@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// 使用する SIMD 命令セットの選択（コンパイルオプションに従う）
+#if defined(__AVX2__)
+#define KEYBITSET_USE_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KEYBITSET_USE_SSE2
+#endif
+
+//------------------------------------------------------------------------------
+// 64bit 値の最下位の立っているビット位置（value != 0 が前提）
+//------------------------------------------------------------------------------
+inline int CountTrailingZeros64(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#elif defined(_MSC_VER)
+    // 32bit ビルドでは下位・上位に分けて調べる
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<unsigned long>(value)))
+        return static_cast<int>(index);
+    _BitScanForward(&index, static_cast<unsigned long>(value >> 32));
+    return static_cast<int>(index) + 32;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// CKeyBitset
+// 256キー分の状態を 1キー1bit（uint64_t × 4 = 256bit）で保持するビットセット
+// Windows に依存しないので、単体での検証や計測にもそのまま使える
+//------------------------------------------------------------------------------
+struct alignas(32) CKeyBitset
+{
+    static const int KEY_COUNT = 256;
+    static const int WORD_COUNT = KEY_COUNT / 64;
+
+    uint64_t word[WORD_COUNT];
+
+    // 全キーを0にする
+    void Clear()
+    {
+        word[0] = word[1] = word[2] = word[3] = 0;
+    }
+
+    // 指定キーのビットを調べる
+    constexpr bool Test(int key) const
+    {
+        return (word[key >> 6] >> (key & 63)) & 1;
+    }
+
+    // 指定キーのビットを立てる / 落とす
+    void Set(int key)
+    {
+        word[key >> 6] |= (uint64_t)1 << (key & 63);
+    }
+
+    void Reset(int key)
+    {
+        word[key >> 6] &= ~((uint64_t)1 << (key & 63));
+    }
+
+    // どれか1つでもビットが立っているか
+    bool Any() const
+    {
+        return (word[0] | word[1] | word[2] | word[3]) != 0;
+    }
+
+    // 立っているビットのキー番号を小さい順に func(key) へ渡す
+    // 処理量は立っているビットの数に比例する
+    template<class Func>
+    void ForEach(Func func) const
+    {
+        for (int i = 0; i < WORD_COUNT; ++i)
+        {
+            uint64_t bits = word[i];
+            while (bits)
+            {
+                func(i * 64 + CountTrailingZeros64(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    bool operator==(const CKeyBitset& rhs) const
+    {
+        return ((word[0] ^ rhs.word[0]) | (word[1] ^ rhs.word[1]) |
+            (word[2] ^ rhs.word[2]) | (word[3] ^ rhs.word[3])) == 0;
+    }
+
+    bool operator!=(const CKeyBitset& rhs) const
+    {
+        return !(*this == rhs);
+    }
+};
+
+//------------------------------------------------------------------------------
+// エッジ検出
+// 現在の状態 now と前フレームの状態 old から
+//   trigger = now & ~old （押された瞬間）
+//   release = ~now & old （離された瞬間）
+// を一括で求める。ComputeKeyEdges() はビルド設定で使える最速の実装を呼ぶ
+//------------------------------------------------------------------------------
+void ComputeKeyEdges(const CKeyBitset& now, const CKeyBitset& old,
+    CKeyBitset& trigger, CKeyBitset& release);
+
+// 実装ごとの関数（計測・検証用に個別にも呼べる）
+void ComputeKeyEdgesScalar(const CKeyBitset& now, const CKeyBitset& old,
+    CKeyBitset& trigger, CKeyBitset& release);
+#ifdef KEYBITSET_USE_SSE2
+void ComputeKeyEdgesSSE2(const CKeyBitset& now, const CKeyBitset& old,
+    CKeyBitset& trigger, CKeyBitset& release);
+#endif
+#ifdef KEYBITSET_USE_AVX2
+void ComputeKeyEdgesAVX2(const CKeyBitset& now, const CKeyBitset& old,
+    CKeyBitset& trigger, CKeyBitset& release);
+#endif
@@ -0,0 +1,166 @@
+#include "CSelfTest.h"
+#include "CKeyBitset.h"
+#include <cstring>
+#include <random>
+
+namespace
+{
+    // 1キー1byte の表（変更前の形式）で求めたエッジと比べる
+    struct ByteTable
+    {
+        BYTE now[CKeyBitset::KEY_COUNT];
+        BYTE old[CKeyBitset::KEY_COUNT];
+    };
+
+    // 乱数で押下を変えた1フレームを作る（1フレームに数キーだけ変わる、キー入力に近い形）
+    void NextFrame(std::mt19937& random, CKeyBitset& keys, ByteTable& table, int changes)
+    {
+        memcpy(table.old, table.now, sizeof(table.now));
+        for (int i = 0; i < changes; ++i)
+        {
+            int key = static_cast<int>(random() & 255);
+            table.now[key] ^= 1;
+            if (table.now[key])
+                keys.Set(key);
+            else
+                keys.Reset(key);
+        }
+    }
+
+    bool MatchEdges(const CKeyBitset& trigger, const CKeyBitset& release, const ByteTable& table)
+    {
+        for (int key = 0; key < CKeyBitset::KEY_COUNT; ++key)
+        {
+            if (trigger.Test(key) != (table.now[key] && !table.old[key]))
+                return false;
+            if (release.Test(key) != (!table.now[key] && table.old[key]))
+                return false;
+        }
+        return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+// ビットの操作
+//------------------------------------------------------------------------------
+SELF_TEST(KeyBitsetBits)
+{
+    CKeyBitset keys;
+    keys.Clear();
+    SELF_CHECK(!keys.Any());
+
+    static const int KEYS[] = { 0, 1, 63, 64, 127, 128, 200, 255 };
+    for (int key : KEYS)
+        keys.Set(key);
+    for (int key = 0; key < CKeyBitset::KEY_COUNT; ++key)
+    {
+        bool expected = false;
+        for (int k : KEYS)
+            expected |= (k == key);
+        SELF_CHECK(keys.Test(key) == expected);
+    }
+
+    int index = 0;
+    bool ordered = true;
+    keys.ForEach([&](int key) { ordered &= (index < 8 && KEYS[index++] == key); });
+    SELF_CHECK(ordered && index == 8);
+
+    CKeyBitset other = keys;
+    SELF_CHECK(other == keys);
+    other.Reset(255);
+    SELF_CHECK(other != keys && !other.Test(255) && other.Test(200));
+}
+
+//------------------------------------------------------------------------------
+// エッジ検出（各実装と、1キー1byte の表で求めた結果が一致する）
+//------------------------------------------------------------------------------
+SELF_TEST(KeyBitsetEdges)
+{
+    std::mt19937 random(1);
+    CKeyBitset now, old, trigger, release;
+    now.Clear();
+    ByteTable table = {};
+
+    for (int frame = 0; frame < 10000; ++frame)
+    {
+        old = now;
+        NextFrame(random, now, table, frame % 7 == 0 ? 64 : 3);
+
+        ComputeKeyEdgesScalar(now, old, trigger, release);
+        SELF_CHECK(MatchEdges(trigger, release, table));
+#ifdef KEYBITSET_USE_SSE2
+        ComputeKeyEdgesSSE2(now, old, trigger, release);
+        SELF_CHECK(MatchEdges(trigger, release, table));
+#endif
+#ifdef KEYBITSET_USE_AVX2
+        ComputeKeyEdgesAVX2(now, old, trigger, release);
+        SELF_CHECK(MatchEdges(trigger, release, table));
+#endif
+        ComputeKeyEdges(now, old, trigger, release);
+        SELF_CHECK(MatchEdges(trigger, release, table));
+    }
+}
+
+//------------------------------------------------------------------------------
+// 計測：1フレーム分の更新と、ゲーム側の典型的な問い合わせ
+//   ・決まったキー16個の Trigger / Release
+//   ・このフレームで押されたキーの列挙
+// 変更前の形式（表のコピーと、問い合わせごとの比較）と比べる
+//------------------------------------------------------------------------------
+SELF_BENCH(KeyBitsetEdges)
+{
+    const int FRAMES = 200000;
+    static const int QUERY_KEYS[16] = { 'W', 'A', 'S', 'D', 'Q', 'E', 'R', 'F', 0x20, 0x10, 0x11, 0x1B, 0x25, 0x26, 0x27, 0x28 };
+
+    // 入力は先に作っておき、計測には含めない
+    std::mt19937 random(2);
+    CKeyBitset now, old, trigger, release;
+    now.Clear();
+    ByteTable table = {};
+    static CKeyBitset s_frames[256];
+    static ByteTable s_tables[256];
+    for (int i = 0; i < 256; ++i)
+    {
+        NextFrame(random, now, table, 3);
+        s_frames[i] = now;
+        s_tables[i] = table;
+    }
+
+    volatile int sink = 0;
+    double start = CSelfTest::GetTimeUs();
+    BYTE keyTable[CKeyBitset::KEY_COUNT] = {};
+    BYTE oldKeyTable[CKeyBitset::KEY_COUNT] = {};
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        memcpy(oldKeyTable, keyTable, sizeof(keyTable));
+        memcpy(keyTable, s_tables[frame & 255].now, sizeof(keyTable));
+        int count = 0;
+        for (int key : QUERY_KEYS)
+            count += (keyTable[key] && !oldKeyTable[key]) + (!keyTable[key] && oldKeyTable[key]);
+        for (int key = 0; key < CKeyBitset::KEY_COUNT; ++key)
+        {
+            if (keyTable[key] && !oldKeyTable[key])
+                count += key;
+        }
+        sink = sink + count;
+    }
+    double byteUs = CSelfTest::GetTimeUs() - start;
+
+    start = CSelfTest::GetTimeUs();
+    now.Clear();
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        old = now;
+        now = s_frames[frame & 255];
+        ComputeKeyEdges(now, old, trigger, release);
+        int count = 0;
+        for (int key : QUERY_KEYS)
+            count += trigger.Test(key) + release.Test(key);
+        trigger.ForEach([&](int key) { count += key; });
+        sink = sink + count;
+    }
+    double bitsetUs = CSelfTest::GetTimeUs() - start;
+
+    CSelfTest::Report("  byte table: %.1f ns/frame", byteUs * 1000.0 / FRAMES);
+    CSelfTest::Report("  bitset    : %.1f ns/frame", bitsetUs * 1000.0 / FRAMES);
+}
@@ -0,0 +1,263 @@
+#include "CKeyboardSource.h"
+
+//------------------------------------------------------------------------------
+// キー状態の差分をイベントとして書き出す
+//------------------------------------------------------------------------------
+int EmitKeyDiff(const CKeyBitset& now, CKeyBitset& reported, LONGLONG timestamp,
+    KeyEvent* events, int count, int maxEvents)
+{
+    CKeyBitset trigger, release;
+    ComputeKeyEdges(now, reported, trigger, release);
+
+    for (int i = 0; i < CKeyBitset::WORD_COUNT; ++i)
+    {
+        // 変化したキーをキー番号の小さい順に書き出す
+        uint64_t changed = release.word[i] | trigger.word[i];
+        while (changed && count < maxEvents)
+        {
+            int key = i * 64 + CountTrailingZeros64(changed);
+            bool down = now.Test(key);
+            events[count].timestamp = timestamp;
+            events[count].key = static_cast<BYTE>(key);
+            events[count].down = down;
+            ++count;
+
+            if (down)
+                reported.Set(key);
+            else
+                reported.Reset(key);
+
+            changed &= changed - 1;
+        }
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// CMessageKeyboardSource：コンストラクタ
+//------------------------------------------------------------------------------
+CMessageKeyboardSource::CMessageKeyboardSource()
+    : m_head(0)
+    , m_tail(0)
+    , m_overflow(false)
+{
+    ZeroMemory(m_queue, sizeof(m_queue));
+    m_state.Clear();
+    m_reported.Clear();
+}
+
+//------------------------------------------------------------------------------
+// CMessageKeyboardSource：ウィンドウメッセージの処理
+// Shift / Ctrl / Alt は左右別のキー（VK_LSHIFT 等）と共通のキー（VK_SHIFT 等）
+// の両方を更新する（GetAsyncKeyState と同じ見え方にするため）
+//------------------------------------------------------------------------------
+void CMessageKeyboardSource::HandleMessage(UINT message, WPARAM wParam, LPARAM lParam)
+{
+    switch (message)
+    {
+    case WM_KEYDOWN:
+    case WM_SYSKEYDOWN:
+    case WM_KEYUP:
+    case WM_SYSKEYUP:
+    {
+        bool down = (message == WM_KEYDOWN || message == WM_SYSKEYDOWN);
+        int key = static_cast<int>(wParam & 0xFF);
+        bool extended = (lParam & (1 << 24)) != 0;
+
+        switch (key)
+        {
+        case VK_SHIFT:
+        {
+            // スキャンコードから左右を判別する
+            UINT scanCode = (lParam >> 16) & 0xFF;
+            int sided = static_cast<int>(MapVirtualKey(scanCode, MAPVK_VSC_TO_VK_EX));
+            if (sided != VK_LSHIFT && sided != VK_RSHIFT)
+                sided = VK_LSHIFT;
+            SetKey(sided, down);
+            SetKey(VK_SHIFT, m_state.Test(VK_LSHIFT) || m_state.Test(VK_RSHIFT));
+            break;
+        }
+        case VK_CONTROL:
+            SetKey(extended ? VK_RCONTROL : VK_LCONTROL, down);
+            SetKey(VK_CONTROL, m_state.Test(VK_LCONTROL) || m_state.Test(VK_RCONTROL));
+            break;
+        case VK_MENU:
+            SetKey(extended ? VK_RMENU : VK_LMENU, down);
+            SetKey(VK_MENU, m_state.Test(VK_LMENU) || m_state.Test(VK_RMENU));
+            break;
+        default:
+            SetKey(key, down);
+            break;
+        }
+        break;
+    }
+
+    case WM_KILLFOCUS:
+        // フォーカスを失うと WM_KEYUP が届かないので、すべて離したことにする
+        ReleaseAll();
+        break;
+    }
+}
+
+//------------------------------------------------------------------------------
+// CMessageKeyboardSource：イベントの取り出し
+//------------------------------------------------------------------------------
+int CMessageKeyboardSource::Fetch(KeyEvent* events, int maxEvents)
+{
+    int count = 0;
+    while (count < maxEvents && m_head != m_tail)
+    {
+        const KeyEvent& e = m_queue[m_head & (QUEUE_SIZE - 1)];
+        if (e.down)
+            m_reported.Set(e.key);
+        else
+            m_reported.Reset(e.key);
+        events[count++] = e;
+        ++m_head;
+    }
+
+    // キューが溢れていた場合は、取りこぼした分を状態の差分から補う
+    if (m_overflow && m_head == m_tail)
+    {
+        count = EmitKeyDiff(m_state, m_reported, GetInputTimestamp(), events, count, maxEvents);
+        if (m_reported == m_state)
+            m_overflow = false;
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// CMessageKeyboardSource：キー状態を変更し、変化があればイベントを積む
+// オートリピートによる連続した WM_KEYDOWN はここで無視される
+//------------------------------------------------------------------------------
+void CMessageKeyboardSource::SetKey(int key, bool down)
+{
+    if (m_state.Test(key) == down)
+        return;
+
+    if (down)
+        m_state.Set(key);
+    else
+        m_state.Reset(key);
+
+    Push(key, down);
+}
+
+void CMessageKeyboardSource::Push(int key, bool down)
+{
+    if (m_tail - m_head >= QUEUE_SIZE)
+    {
+        // 満杯なら積まずに、Fetch() で差分から補う
+        m_overflow = true;
+        return;
+    }
+
+    KeyEvent& e = m_queue[m_tail & (QUEUE_SIZE - 1)];
+    e.timestamp = GetInputTimestamp(); // メッセージを受け取った時刻
+    e.key = static_cast<BYTE>(key);
+    e.down = down;
+    ++m_tail;
+}
+
+void CMessageKeyboardSource::ReleaseAll()
+{
+    CKeyBitset pressed = m_state;
+    pressed.ForEach([this](int key) { SetKey(key, false); });
+}
+
+//------------------------------------------------------------------------------
+// CAsyncKeyboardSource：コンストラクタ
+//------------------------------------------------------------------------------
+CAsyncKeyboardSource::CAsyncKeyboardSource()
+    : m_pollTime(0)
+    , m_polled(false)
+{
+    m_pending.Clear();
+    m_reported.Clear();
+}
+
+//------------------------------------------------------------------------------
+// CAsyncKeyboardSource：Update の始まり（次の Fetch() で取得し直す）
+//------------------------------------------------------------------------------
+void CAsyncKeyboardSource::BeginFrame(LONGLONG /*until*/)
+{
+    m_polled = false;
+}
+
+//------------------------------------------------------------------------------
+// CAsyncKeyboardSource：イベントの取り出し
+// 1回の Update につき GetAsyncKeyState での全キー走査は1度だけ行う
+//------------------------------------------------------------------------------
+int CAsyncKeyboardSource::Fetch(KeyEvent* events, int maxEvents)
+{
+    if (!m_polled)
+    {
+        m_pending.Clear();
+        for (int i = 0; i < CKeyBitset::KEY_COUNT; ++i)
+        {
+            if (GetAsyncKeyState(i) & 0x8000)
+                m_pending.Set(i);
+        }
+        m_pollTime = GetInputTimestamp();
+        m_polled = true;
+    }
+
+    return EmitKeyDiff(m_pending, m_reported, m_pollTime, events, 0, maxEvents);
+}
+
+//------------------------------------------------------------------------------
+// CScriptedKeyboardSource：コンストラクタ
+//------------------------------------------------------------------------------
+CScriptedKeyboardSource::CScriptedKeyboardSource()
+    : m_cursor(0)
+    , m_frame(0)
+    , m_current(-1)
+    , m_until(0)
+{
+}
+
+void CScriptedKeyboardSource::AddEvent(int frame, int key, bool down)
+{
+    ScriptEntry entry;
+    entry.frame = frame;
+    entry.event.timestamp = 0;
+    entry.event.key = static_cast<BYTE>(key);
+    entry.event.down = down;
+    m_script.push_back(entry);
+}
+
+void CScriptedKeyboardSource::Rewind()
+{
+    m_cursor = 0;
+    m_frame = 0;
+    m_current = -1;
+}
+
+//------------------------------------------------------------------------------
+// CScriptedKeyboardSource：次のフレームへ進む
+//------------------------------------------------------------------------------
+void CScriptedKeyboardSource::BeginFrame(LONGLONG until)
+{
+    m_current = m_frame++;
+    m_until = until;
+}
+
+//------------------------------------------------------------------------------
+// CScriptedKeyboardSource：現在フレームのイベントを取り出す
+// 時刻を until までにするので、Update(until) でも登録したフレームで反映される
+//------------------------------------------------------------------------------
+int CScriptedKeyboardSource::Fetch(KeyEvent* events, int maxEvents)
+{
+    int count = 0;
+    LONGLONG now = GetInputTimestamp();
+    if (now > m_until)
+        now = m_until;
+    while (count < maxEvents && m_cursor < m_script.size() &&
+        m_script[m_cursor].frame <= m_current)
+    {
+        events[count] = m_script[m_cursor++].event;
+        events[count].timestamp = now;
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+#include "CKeyBitset.h"
+#include "CInputEventLog.h"
+
+//------------------------------------------------------------------------------
+// KeyEvent
+// キーが押された / 離された 1回分の出来事
+//------------------------------------------------------------------------------
+struct KeyEvent
+{
+    LONGLONG timestamp; // 発生時刻（GetInputTimestamp の値）
+    BYTE key;           // 仮想キーコード（0~255）
+    bool down;          // true = 押された、false = 離された
+};
+
+//------------------------------------------------------------------------------
+// now と reported の差分をイベントとして events[count] 以降へ書き出す
+// 書き出した分は reported に反映する（maxEvents に達したら途中で止まる）
+// timestamp は書き出すイベントの発生時刻。戻り値は書き出し後のイベント数
+//------------------------------------------------------------------------------
+int EmitKeyDiff(const CKeyBitset& now, CKeyBitset& reported, LONGLONG timestamp,
+    KeyEvent* events, int count, int maxEvents);
+
+//------------------------------------------------------------------------------
+// IKeyboardSource
+// キーボード入力の取得元インターフェース
+// CInputManager::Update() は毎フレーム BeginFrame() を1回呼んでから Fetch() を呼び、
+// 受け取ったイベントを順番にキー状態へ反映する
+// （until より後のイベントがあれば、0 が返る前に Fetch() をやめることがある）
+//------------------------------------------------------------------------------
+class IKeyboardSource
+{
+public:
+    virtual ~IKeyboardSource() = default;
+
+    // Update 1回分の取り出しを始める（until はこの Update で反映するイベントの最後の時刻）
+    virtual void BeginFrame(LONGLONG /*until*/) {}
+
+    // 前回の呼び出し以降に溜まったイベントを最大 maxEvents 個取り出す
+    // 戻り値は取り出したイベント数
+    virtual int Fetch(KeyEvent* events, int maxEvents) = 0;
+};
+
+//------------------------------------------------------------------------------
+// CMessageKeyboardSource
+// ウィンドウメッセージ（WM_KEYDOWN / WM_KEYUP 等）からキーイベントを溜める
+// WndProc から HandleMessage() を呼ぶ。GetAsyncKeyState は使わない
+//------------------------------------------------------------------------------
+class CMessageKeyboardSource : public IKeyboardSource
+{
+public:
+    CMessageKeyboardSource();
+
+    // WndProc から受け取ったメッセージを処理する（キー関係以外は無視）
+    void HandleMessage(UINT message, WPARAM wParam, LPARAM lParam);
+
+    int Fetch(KeyEvent* events, int maxEvents) override;
+
+private:
+    static const int QUEUE_SIZE = 256;   // 2のべき乗
+
+    void Push(int key, bool down);
+    void SetKey(int key, bool down);
+    void ReleaseAll();
+
+    KeyEvent m_queue[QUEUE_SIZE];   // 未取得イベントのリングバッファ
+    unsigned int m_head;            // 次に取り出す位置
+    unsigned int m_tail;            // 次に書き込む位置
+    bool m_overflow;                // キューが溢れたか
+
+    CKeyBitset m_state;             // メッセージから見た現在のキー状態
+    CKeyBitset m_reported;          // Fetch() で取り出し済みのキー状態
+};
+
+//------------------------------------------------------------------------------
+// CAsyncKeyboardSource
+// 従来通り GetAsyncKeyState で 256キーを調べ、前回との差分をイベントにする
+// ウィンドウメッセージを受け取れない場面向け
+//------------------------------------------------------------------------------
+class CAsyncKeyboardSource : public IKeyboardSource
+{
+public:
+    CAsyncKeyboardSource();
+
+    void BeginFrame(LONGLONG until) override;
+    int Fetch(KeyEvent* events, int maxEvents) override;
+
+private:
+    CKeyBitset m_pending;   // 今回 GetAsyncKeyState で取得した状態
+    LONGLONG m_pollTime;    // 今回の取得時刻
+    CKeyBitset m_reported;  // 取り出し済みの状態
+    bool m_polled;          // 今回分の取得が済んでいるか
+};
+
+//------------------------------------------------------------------------------
+// CScriptedKeyboardSource
+// あらかじめ登録したイベントをフレーム単位で再生するソース（検証用）
+// BeginFrame() のたびに 1フレーム進む
+//------------------------------------------------------------------------------
+class CScriptedKeyboardSource : public IKeyboardSource
+{
+public:
+    CScriptedKeyboardSource();
+
+    // frame フレーム目に key を押す / 離す（frame は昇順で登録する）
+    // タイムスタンプは取り出した時刻になる（BeginFrame の until より後にはしない）
+    void AddEvent(int frame, int key, bool down);
+
+    // 先頭に巻き戻す
+    void Rewind();
+
+    void BeginFrame(LONGLONG until) override;
+    int Fetch(KeyEvent* events, int maxEvents) override;
+
+    // 次の BeginFrame で再生するフレーム
+    int GetFrame() const { return m_frame; }
+
+private:
+    struct ScriptEntry
+    {
+        int frame;
+        KeyEvent event;
+    };
+
+    std::vector<ScriptEntry> m_script;
+    size_t m_cursor;
+    int m_frame;
+    int m_current;          // 再生中のフレーム（BeginFrame 前は -1）
+    LONGLONG m_until;       // 再生中のフレームの until
+};
@@ -0,0 +1,85 @@
+#include "CSelfTest.h"
+#include "CInputManager.h"
+
+namespace
+{
+    const int TICKS = 10000;
+    const int BURST_FRAME = 500;    // 1回に取り出す数より多いイベントを登録するフレーム
+    const int BURST_KEYS = 40;      // BURST_FRAME で押して離すキー（VK_F1 から）
+
+    // 'A' は 3フレームごとに押す・離す、'B' は 7フレームごとに同じフレームで押して離す
+    bool IsATrigger(int frame) { return frame % 6 == 0; }
+    bool IsARelease(int frame) { return frame % 6 == 3; }
+    bool IsBTap(int frame) { return frame % 7 == 0; }
+}
+
+//------------------------------------------------------------------------------
+// 固定ティックの Update(tickEnd) でも、登録したフレームどおりに再生される
+// ティックの終わりは実際の時刻より前にするので、取り出した時刻をそのまま使うと持ち越されてしまう
+//------------------------------------------------------------------------------
+SELF_TEST(KeyboardScriptedTicks)
+{
+    CScriptedKeyboardSource script;
+    for (int frame = 0; frame < TICKS; ++frame)
+    {
+        if (IsATrigger(frame))
+            script.AddEvent(frame, 'A', true);
+        if (IsARelease(frame))
+            script.AddEvent(frame, 'A', false);
+        if (IsBTap(frame))
+        {
+            script.AddEvent(frame, 'B', true);
+            script.AddEvent(frame, 'B', false);
+        }
+        if (frame == BURST_FRAME)
+        {
+            for (int i = 0; i < BURST_KEYS; ++i)
+            {
+                script.AddEvent(frame, VK_F1 + i, true);
+                script.AddEvent(frame, VK_F1 + i, false);
+            }
+        }
+    }
+
+    auto& input = CInputManager::GetInstance();
+    input.SetKeyboardSource(&script);
+
+    LONGLONG step = GetInputTimestampFrequency() / 1000;
+    LONGLONG start = GetInputTimestamp() - step * TICKS * 2;
+    int mismatch = 0;
+    bool burst = true;
+    for (int frame = 0; frame < TICKS; ++frame)
+    {
+        input.Update(start + step * frame);
+        bool a = frame % 6 < 3;
+        bool b = IsBTap(frame);
+        if (input.IsKeyTrigger('A') != IsATrigger(frame) || input.IsKeyRelease('A') != IsARelease(frame) ||
+            input.IsKeyPress('A') != a || input.IsKeyTrigger('B') != b || input.IsKeyRelease('B') != b ||
+            input.IsKeyPress('B'))
+        {
+            ++mismatch;
+        }
+        for (int i = 0; i < BURST_KEYS; ++i)
+        {
+            bool tapped = (frame == BURST_FRAME);
+            burst &= input.IsKeyTrigger(VK_F1 + i) == tapped && input.IsKeyRelease(VK_F1 + i) == tapped;
+        }
+    }
+    SELF_CHECK(mismatch == 0);
+    SELF_CHECK(burst);
+    SELF_CHECK(script.GetFrame() == TICKS);
+
+    // Update() でも同じ
+    script.Rewind();
+    input.SetKeyboardSource(&script);
+    mismatch = 0;
+    for (int frame = 0; frame < 100; ++frame)
+    {
+        input.Update();
+        if (input.IsKeyTrigger('A') != IsATrigger(frame) || input.IsKeyRelease('A') != IsARelease(frame))
+            ++mismatch;
+    }
+    SELF_CHECK(mismatch == 0);
+
+    input.SetKeyboardSource(nullptr);
+}
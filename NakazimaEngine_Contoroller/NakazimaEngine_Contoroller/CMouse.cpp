@@ -0,0 +1,250 @@
+#include "CMouse.h"
+
+namespace
+{
+    // Raw Input のボタンのフラグ（押された, 離された）とボタンの対応
+    const struct
+    {
+        USHORT down;
+        USHORT up;
+        DWORD button;
+    } RAW_BUTTONS[] =
+    {
+        { RI_MOUSE_LEFT_BUTTON_DOWN, RI_MOUSE_LEFT_BUTTON_UP, MOUSE_BUTTON_LEFT },
+        { RI_MOUSE_RIGHT_BUTTON_DOWN, RI_MOUSE_RIGHT_BUTTON_UP, MOUSE_BUTTON_RIGHT },
+        { RI_MOUSE_MIDDLE_BUTTON_DOWN, RI_MOUSE_MIDDLE_BUTTON_UP, MOUSE_BUTTON_MIDDLE },
+        { RI_MOUSE_BUTTON_4_DOWN, RI_MOUSE_BUTTON_4_UP, MOUSE_BUTTON_X1 },
+        { RI_MOUSE_BUTTON_5_DOWN, RI_MOUSE_BUTTON_5_UP, MOUSE_BUTTON_X2 },
+    };
+}
+
+//------------------------------------------------------------------------------
+// コンストラクタ
+//------------------------------------------------------------------------------
+CMouse::CMouse()
+    : m_rawInput(false)
+{
+    Reset();
+}
+
+//------------------------------------------------------------------------------
+// 状態を捨てて、すべて離した状態にする
+//------------------------------------------------------------------------------
+void CMouse::Reset()
+{
+    m_state = 0;
+    m_pendingTrigger = 0;
+    m_pendingRelease = 0;
+    m_pendingX = 0;
+    m_pendingY = 0;
+    m_pendingWheel = 0;
+    m_pendingHWheel = 0;
+    m_lastMoveX = 0;
+    m_lastMoveY = 0;
+    m_hasLastMove = false;
+
+    m_buttons = 0;
+    m_trigger = 0;
+    m_release = 0;
+    m_deltaX = 0;
+    m_deltaY = 0;
+    m_wheel = 0;
+    m_hWheel = 0;
+    m_cursorX = 0;
+    m_cursorY = 0;
+}
+
+//------------------------------------------------------------------------------
+// Raw Input の登録（汎用デスクトップ / マウス）
+// 従来のメッセージも止めないので、カーソル位置やウィンドウ操作はそのまま使える
+//------------------------------------------------------------------------------
+bool CMouse::RegisterRawInput(HWND hWnd)
+{
+    RAWINPUTDEVICE device;
+    device.usUsagePage = 0x01;  // HID_USAGE_PAGE_GENERIC
+    device.usUsage = 0x02;      // HID_USAGE_GENERIC_MOUSE
+    device.dwFlags = 0;
+    device.hwndTarget = hWnd;
+    m_rawInput = RegisterRawInputDevices(&device, 1, sizeof(device)) != FALSE;
+    return m_rawInput;
+}
+
+bool CMouse::IsRawInput() const
+{
+    return m_rawInput;
+}
+
+//------------------------------------------------------------------------------
+// ウィンドウメッセージの処理
+// Raw Input を使っている間、移動量・ボタン・ホイールは WM_INPUT だけから求める
+//------------------------------------------------------------------------------
+void CMouse::HandleMessage(UINT message, WPARAM wParam, LPARAM lParam)
+{
+    switch (message)
+    {
+    case WM_INPUT:
+        if (m_rawInput)
+            HandleRawInput(reinterpret_cast<HRAWINPUT>(lParam));
+        break;
+
+    case WM_MOUSEMOVE:
+    {
+        m_cursorX = static_cast<SHORT>(LOWORD(lParam));
+        m_cursorY = static_cast<SHORT>(HIWORD(lParam));
+        if (!m_rawInput)
+        {
+            if (m_hasLastMove)
+            {
+                m_pendingX += m_cursorX - m_lastMoveX;
+                m_pendingY += m_cursorY - m_lastMoveY;
+            }
+            m_lastMoveX = m_cursorX;
+            m_lastMoveY = m_cursorY;
+            m_hasLastMove = true;
+        }
+        break;
+    }
+
+    case WM_LBUTTONDOWN:
+    case WM_LBUTTONUP:
+        if (!m_rawInput)
+            SetButton(MOUSE_BUTTON_LEFT, message == WM_LBUTTONDOWN);
+        break;
+
+    case WM_RBUTTONDOWN:
+    case WM_RBUTTONUP:
+        if (!m_rawInput)
+            SetButton(MOUSE_BUTTON_RIGHT, message == WM_RBUTTONDOWN);
+        break;
+
+    case WM_MBUTTONDOWN:
+    case WM_MBUTTONUP:
+        if (!m_rawInput)
+            SetButton(MOUSE_BUTTON_MIDDLE, message == WM_MBUTTONDOWN);
+        break;
+
+    case WM_XBUTTONDOWN:
+    case WM_XBUTTONUP:
+        if (!m_rawInput)
+            SetButton(HIWORD(wParam) == XBUTTON1 ? MOUSE_BUTTON_X1 : MOUSE_BUTTON_X2, message == WM_XBUTTONDOWN);
+        break;
+
+    case WM_MOUSEWHEEL:
+        if (!m_rawInput)
+            m_pendingWheel += GET_WHEEL_DELTA_WPARAM(wParam);
+        break;
+
+    case WM_KILLFOCUS:
+        // フォーカスを失うと離したことが届かないので、すべて離したことにする
+        for (const auto& raw : RAW_BUTTONS)
+            SetButton(raw.button, false);
+        m_hasLastMove = false;
+        break;
+    }
+}
+
+//------------------------------------------------------------------------------
+// WM_INPUT 1回分の処理
+//------------------------------------------------------------------------------
+void CMouse::HandleRawInput(HRAWINPUT handle)
+{
+    RAWINPUT raw;
+    UINT size = sizeof(raw);
+    if (GetRawInputData(handle, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1))
+        return;
+    if (raw.header.dwType == RIM_TYPEMOUSE)
+        ProcessRawMouse(raw.data.mouse);
+}
+
+//------------------------------------------------------------------------------
+// メッセージキューに残っている WM_INPUT をまとめて読む
+// 高レートのマウスでは1フレームに数十~数百届くので、メッセージを1つずつ配らずに済ませる
+//------------------------------------------------------------------------------
+void CMouse::DrainRawInput()
+{
+    for (;;)
+    {
+        UINT size = sizeof(m_rawBuffer);
+        UINT count = GetRawInputBuffer(m_rawBuffer, &size, sizeof(RAWINPUTHEADER));
+        if (count == 0 || count == static_cast<UINT>(-1))
+            break;
+
+        RAWINPUT* raw = m_rawBuffer;
+        for (UINT i = 0; i < count; ++i)
+        {
+            if (raw->header.dwType == RIM_TYPEMOUSE)
+                ProcessRawMouse(raw->data.mouse);
+            raw = NEXTRAWINPUTBLOCK(raw);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Raw Input のマウス1回分（確保なし、移動量とホイールは足し込むだけ）
+// 絶対座標で届くもの（タブレット・リモートデスクトップ等）は移動量にしない
+//------------------------------------------------------------------------------
+void CMouse::ProcessRawMouse(const RAWMOUSE& mouse)
+{
+    if (!(mouse.usFlags & MOUSE_MOVE_ABSOLUTE))
+    {
+        m_pendingX += mouse.lLastX;
+        m_pendingY += mouse.lLastY;
+    }
+
+    USHORT flags = mouse.usButtonFlags;
+    if (flags == 0)
+        return;
+    for (const auto& button : RAW_BUTTONS)
+    {
+        if (flags & button.down)
+            SetButton(button.button, true);
+        if (flags & button.up)
+            SetButton(button.button, false);
+    }
+    if (flags & RI_MOUSE_WHEEL)
+        m_pendingWheel += static_cast<SHORT>(mouse.usButtonData);
+    if (flags & RI_MOUSE_HWHEEL)
+        m_pendingHWheel += static_cast<SHORT>(mouse.usButtonData);
+}
+
+//------------------------------------------------------------------------------
+// ボタンの変化を溜める（同じフレームで押して離したら両方残る）
+//------------------------------------------------------------------------------
+void CMouse::SetButton(DWORD button, bool down)
+{
+    if (down && !(m_state & button))
+    {
+        m_state |= button;
+        m_pendingTrigger |= button;
+    }
+    else if (!down && (m_state & button))
+    {
+        m_state &= ~button;
+        m_pendingRelease |= button;
+    }
+}
+
+//------------------------------------------------------------------------------
+// 前回の Update からの入力をこのフレームの値にする
+// まだ配られていない WM_INPUT もここで読んでおく
+//------------------------------------------------------------------------------
+void CMouse::Update()
+{
+    if (m_rawInput)
+        DrainRawInput();
+
+    m_buttons = m_state;
+    m_trigger = m_pendingTrigger;
+    m_release = m_pendingRelease;
+    m_deltaX = m_pendingX;
+    m_deltaY = m_pendingY;
+    m_wheel = m_pendingWheel;
+    m_hWheel = m_pendingHWheel;
+
+    m_pendingTrigger = 0;
+    m_pendingRelease = 0;
+    m_pendingX = 0;
+    m_pendingY = 0;
+    m_pendingWheel = 0;
+    m_pendingHWheel = 0;
+}
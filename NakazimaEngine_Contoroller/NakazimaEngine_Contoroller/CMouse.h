@@ -0,0 +1,95 @@
+#pragma once
+#include <windows.h>
+
+//------------------------------------------------------------------------------
+// マウスのボタン（ビットの組み合わせで指定できる）
+//------------------------------------------------------------------------------
+const DWORD MOUSE_BUTTON_LEFT = 0x01;
+const DWORD MOUSE_BUTTON_RIGHT = 0x02;
+const DWORD MOUSE_BUTTON_MIDDLE = 0x04;
+const DWORD MOUSE_BUTTON_X1 = 0x08;
+const DWORD MOUSE_BUTTON_X2 = 0x10;
+
+//------------------------------------------------------------------------------
+// CMouse
+// マウスのボタン・ホイール・移動量
+// 移動量は Raw Input（WM_INPUT）の相対値を、次の Update までそのまま足し込む
+// （カーソルの加速やウィンドウ端で止まる影響を受けず、高 DPI・高レートのマウスでも取りこぼさない）
+// WM_INPUT 1回あたりの処理は数回の加算だけで、Update ではキューに残った分を GetRawInputBuffer でまとめて読む
+// Raw Input を登録できなかったときは WM_MOUSEMOVE 等のメッセージから求める
+// ボタンはフレームの間に押して離しても Trigger / Release の両方が立つ
+//------------------------------------------------------------------------------
+class CMouse
+{
+public:
+    CMouse();
+
+    // Raw Input でマウスを受け取るウィンドウを登録する（失敗したらメッセージから求める）
+    bool RegisterRawInput(HWND hWnd);
+    bool IsRawInput() const;
+
+    // WndProc から受け取ったメッセージを処理する（マウス関係以外は無視）
+    void HandleMessage(UINT message, WPARAM wParam, LPARAM lParam);
+
+    // 前回の Update からの入力をこのフレームの値にする
+    void Update();
+
+    // 状態を捨てて、すべて離した状態にする
+    void Reset();
+
+    //--------------------------------------
+    // このフレームの値
+    //--------------------------------------
+    bool IsPress(DWORD button) const { return (m_buttons & button) != 0; }
+    bool IsTrigger(DWORD button) const { return (m_trigger & button) != 0; }
+    bool IsRelease(DWORD button) const { return (m_release & button) != 0; }
+
+    // 移動量（マウスのカウント、右・下が正）
+    LONG GetDeltaX() const { return m_deltaX; }
+    LONG GetDeltaY() const { return m_deltaY; }
+
+    // ホイール（1ノッチ = 1.0f、縦は奥・横は右が正）
+    float GetWheel() const { return m_wheel / static_cast<float>(WHEEL_DELTA); }
+    float GetHWheel() const { return m_hWheel / static_cast<float>(WHEEL_DELTA); }
+
+    // カーソル位置（クライアント座標、WM_MOUSEMOVE の最後の値）
+    int GetCursorX() const { return m_cursorX; }
+    int GetCursorY() const { return m_cursorY; }
+
+    // このフレームでボタン・移動量・ホイールのどれかが変わったか
+    bool IsChanged() const { return (m_trigger | m_release) != 0 || m_deltaX != 0 || m_deltaY != 0 || m_wheel != 0 || m_hWheel != 0; }
+
+private:
+    void HandleRawInput(HRAWINPUT handle);
+    void DrainRawInput();
+    void ProcessRawMouse(const RAWMOUSE& mouse);
+    void SetButton(DWORD button, bool down);
+
+    static const int RAW_BUFFER_COUNT = 64;
+
+    bool m_rawInput;            // Raw Input を登録できたか
+    RAWINPUT m_rawBuffer[RAW_BUFFER_COUNT]; // GetRawInputBuffer で読む先
+
+    // 次の Update までに溜めている値
+    DWORD m_state;              // メッセージから見た現在のボタン
+    DWORD m_pendingTrigger;     // 押されたボタン
+    DWORD m_pendingRelease;     // 離されたボタン
+    LONG m_pendingX;
+    LONG m_pendingY;
+    LONG m_pendingWheel;
+    LONG m_pendingHWheel;
+    int m_lastMoveX;            // メッセージから移動量を求めるときの前回の位置
+    int m_lastMoveY;
+    bool m_hasLastMove;
+
+    // このフレームの値
+    DWORD m_buttons;
+    DWORD m_trigger;
+    DWORD m_release;
+    LONG m_deltaX;
+    LONG m_deltaY;
+    LONG m_wheel;
+    LONG m_hWheel;
+    int m_cursorX;
+    int m_cursorY;
+};
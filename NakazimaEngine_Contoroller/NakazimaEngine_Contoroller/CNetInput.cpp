@@ -0,0 +1,462 @@
+#include "CNetInput.h"
+#include <cmath>
+
+namespace
+{
+    const int PLAYER_BITS = 2;
+    const int FRAME_BITS = 32;
+    const int COUNT_BITS = 6;
+    const int STICK_BITS = 8;
+
+    //--------------------------------------
+    // ビット単位の書き込み（下位ビットから詰める）
+    //--------------------------------------
+    struct BitWriter
+    {
+        BYTE* data;
+        int capacity;   // バイト数
+        int position;   // ビット位置
+        bool overflow;
+
+        void Write(uint64_t value, int bits)
+        {
+            while (bits > 0)
+            {
+                int index = position >> 3;
+                int offset = position & 7;
+                int count = (8 - offset) < bits ? (8 - offset) : bits;
+                if (index >= capacity)
+                {
+                    overflow = true;
+                    return;
+                }
+                if (offset == 0)
+                    data[index] = 0;
+                data[index] |= static_cast<BYTE>((value & ((1u << count) - 1)) << offset);
+                value >>= count;
+                bits -= count;
+                position += count;
+            }
+        }
+
+        int GetSize() const { return (position + 7) >> 3; }
+    };
+
+    //--------------------------------------
+    // ビット単位の読み出し
+    //--------------------------------------
+    struct BitReader
+    {
+        const BYTE* data;
+        int size;       // バイト数
+        int position;   // ビット位置
+        bool overflow;
+
+        uint64_t Read(int bits)
+        {
+            uint64_t value = 0;
+            int shift = 0;
+            while (bits > 0)
+            {
+                int index = position >> 3;
+                int offset = position & 7;
+                int count = (8 - offset) < bits ? (8 - offset) : bits;
+                if (index >= size)
+                {
+                    overflow = true;
+                    return 0;
+                }
+                value |= static_cast<uint64_t>((data[index] >> offset) & ((1u << count) - 1)) << shift;
+                shift += count;
+                bits -= count;
+                position += count;
+            }
+            return value;
+        }
+    };
+
+    uint64_t GetActionMask(int actionCount)
+    {
+        return actionCount >= 64 ? ~0ULL : (1ULL << actionCount) - 1;
+    }
+
+    signed char QuantizeStick(float value)
+    {
+        float scaled = std::floor(value * 127.0f + 0.5f);
+        return static_cast<signed char>(scaled < -127.0f ? -127.0f : (scaled > 127.0f ? 127.0f : scaled));
+    }
+}
+
+//------------------------------------------------------------------------------
+// 送る入力を作る
+//------------------------------------------------------------------------------
+NetInput MakeNetInput(const CActionMap& actions, const InputFrame& frame, int pad)
+{
+    NetInput input;
+    input.actions = 0;
+    for (int i = 0; i < CActionMap::MAX_ACTION_COUNT; ++i)
+    {
+        if (actions.IsPress(i))
+            input.actions |= 1ULL << i;
+    }
+    for (int axis = 0; axis < 4; ++axis)
+        input.sticks[axis] = QuantizeStick(frame.thumbs[pad][axis]);
+    return input;
+}
+
+//------------------------------------------------------------------------------
+// CNetInputHistory
+//------------------------------------------------------------------------------
+CNetInputHistory::CNetInputHistory()
+{
+    Reset();
+}
+
+void CNetInputHistory::Reset()
+{
+    for (int i = 0; i < CAPACITY; ++i)
+    {
+        m_slots[i].frame = NO_FRAME;
+        m_slots[i].confirmed = false;
+        m_slots[i].predicted = false;
+    }
+    m_nextConfirm = 0;
+    ZeroMemory(&m_lastConfirmed, sizeof(m_lastConfirmed));
+    m_rollbackFrame = NO_FRAME;
+    m_mispredictionCount = 0;
+}
+
+//------------------------------------------------------------------------------
+// 確定した入力を記録する
+// 予測を返していたフレームで値が違えば、そこから巻き戻す
+// 途中のフレームが抜けていても記録しておき、抜けが埋まったらまとめて確定を進める
+//------------------------------------------------------------------------------
+bool CNetInputHistory::AddConfirmed(DWORD frame, const NetInput& input)
+{
+    if (frame < m_nextConfirm)
+        return true;
+    if (frame - m_nextConfirm >= static_cast<DWORD>(CAPACITY))
+        return false;
+
+    Slot& slot = GetSlot(frame);
+    if (slot.frame == frame)
+    {
+        if (slot.confirmed)
+            return true;
+        if (slot.predicted && slot.input != input)
+        {
+            if (m_rollbackFrame == NO_FRAME || frame < m_rollbackFrame)
+                m_rollbackFrame = frame;
+            ++m_mispredictionCount;
+        }
+    }
+
+    slot.frame = frame;
+    slot.input = input;
+    slot.confirmed = true;
+    slot.predicted = false;
+
+    for (;;)
+    {
+        const Slot& next = GetSlot(m_nextConfirm);
+        if (next.frame != m_nextConfirm || !next.confirmed)
+            break;
+        m_lastConfirmed = next.input;
+        ++m_nextConfirm;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// frame の入力
+// 確定していなければ、最後に確定した入力をそのまま続けると予測する
+//------------------------------------------------------------------------------
+bool CNetInputHistory::GetInput(DWORD frame, NetInput& input)
+{
+    if (GetConfirmed(frame, input))
+        return true;
+
+    input = m_lastConfirmed;
+
+    // 確定を待っている範囲なら、返した予測を覚えておく
+    if (frame >= m_nextConfirm && frame - m_nextConfirm < static_cast<DWORD>(CAPACITY))
+    {
+        Slot& slot = GetSlot(frame);
+        slot.frame = frame;
+        slot.input = input;
+        slot.confirmed = false;
+        slot.predicted = true;
+    }
+    return false;
+}
+
+bool CNetInputHistory::GetConfirmed(DWORD frame, NetInput& input) const
+{
+    const Slot& slot = GetSlot(frame);
+    if (slot.frame != frame || !slot.confirmed)
+        return false;
+    input = slot.input;
+    return true;
+}
+
+DWORD CNetInputHistory::GetConfirmedFrame() const
+{
+    return m_nextConfirm == 0 ? NO_FRAME : m_nextConfirm - 1;
+}
+
+DWORD CNetInputHistory::GetNextConfirmFrame() const
+{
+    return m_nextConfirm;
+}
+
+DWORD CNetInputHistory::GetRollbackFrame() const
+{
+    return m_rollbackFrame;
+}
+
+void CNetInputHistory::ClearRollback()
+{
+    m_rollbackFrame = NO_FRAME;
+}
+
+int CNetInputHistory::GetMispredictionCount() const
+{
+    return m_mispredictionCount;
+}
+
+//------------------------------------------------------------------------------
+// CNetInputSession
+//------------------------------------------------------------------------------
+CNetInputSession::CNetInputSession()
+{
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+        m_transport[i] = nullptr;
+    Configure(0, 2, CActionMap::MAX_ACTION_COUNT);
+}
+
+void CNetInputSession::Configure(int localPlayer, int playerCount, int actionCount)
+{
+    m_playerCount = playerCount < 1 ? 1 : (playerCount > MAX_PLAYERS ? MAX_PLAYERS : playerCount);
+    m_localPlayer = localPlayer < 0 ? 0 : (localPlayer >= m_playerCount ? m_playerCount - 1 : localPlayer);
+    m_actionCount = actionCount < 1 ? 1 : (actionCount > CActionMap::MAX_ACTION_COUNT ? CActionMap::MAX_ACTION_COUNT : actionCount);
+    Reset();
+}
+
+void CNetInputSession::Reset()
+{
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        m_history[i].Reset();
+        m_ackFrame[i] = 0;
+    }
+    m_localFrame = 0;
+}
+
+void CNetInputSession::SetTransport(int player, INetTransport* transport)
+{
+    if (player >= 0 && player < MAX_PLAYERS && player != m_localPlayer)
+        m_transport[player] = transport;
+}
+
+//------------------------------------------------------------------------------
+// ローカルの入力を確定する
+// 予測が MAX_PREDICTION_FRAMES を超える・相手の受信が遅れすぎているときは false（待つ）
+//------------------------------------------------------------------------------
+bool CNetInputSession::AddLocalInput(DWORD frame, const NetInput& input)
+{
+    if (frame != m_localFrame)
+        return false;
+
+    // 相手の確定・受信が追いつくまで先へは進めない
+    for (int player = 0; player < m_playerCount; ++player)
+    {
+        if (player == m_localPlayer)
+            continue;
+        // 相手の方が先に進んで確定していることもあるので、差は符号付きで比べる
+        LONG confirmLead = static_cast<LONG>(frame - m_history[player].GetNextConfirmFrame());
+        LONG ackLead = static_cast<LONG>(frame - m_ackFrame[player]);
+        if (confirmLead >= MAX_PREDICTION_FRAMES || ackLead >= MAX_PREDICTION_FRAMES)
+            return false;
+    }
+
+    NetInput masked = input;
+    masked.actions &= GetActionMask(m_actionCount);
+    m_history[m_localPlayer].AddConfirmed(frame, masked);
+    ++m_localFrame;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// 相手が受け取っていないローカルの入力を古い方から送る（多すぎるときは MAX_PACKET_FRAMES 個）
+// 送るものがなくても、受信済みのフレームを伝えるために送る
+//------------------------------------------------------------------------------
+void CNetInputSession::SendInputs()
+{
+    for (int player = 0; player < m_playerCount; ++player)
+    {
+        if (player == m_localPlayer || !m_transport[player])
+            continue;
+
+        DWORD first = m_ackFrame[player];
+        DWORD count = m_localFrame - first;
+        if (count > static_cast<DWORD>(MAX_PACKET_FRAMES))
+            count = MAX_PACKET_FRAMES;
+
+        int size = EncodePacket(m_packet, MAX_PACKET_SIZE, m_localPlayer, first,
+            static_cast<int>(count), m_history[player].GetNextConfirmFrame());
+        if (size > 0)
+            m_transport[player]->Send(m_packet, size);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 届いているパケットをすべて読む
+//------------------------------------------------------------------------------
+void CNetInputSession::ReceiveInputs()
+{
+    for (int player = 0; player < m_playerCount; ++player)
+    {
+        if (player == m_localPlayer || !m_transport[player])
+            continue;
+
+        int size;
+        while ((size = m_transport[player]->Receive(m_packet, MAX_PACKET_SIZE)) > 0)
+            DecodePacket(m_packet, size);
+    }
+}
+
+bool CNetInputSession::GetInput(int player, DWORD frame, NetInput& input)
+{
+    return m_history[player].GetInput(frame, input);
+}
+
+DWORD CNetInputSession::GetConfirmedFrame() const
+{
+    DWORD next = m_history[0].GetNextConfirmFrame();
+    for (int i = 1; i < m_playerCount; ++i)
+    {
+        DWORD n = m_history[i].GetNextConfirmFrame();
+        if (n < next)
+            next = n;
+    }
+    return next == 0 ? CNetInputHistory::NO_FRAME : next - 1;
+}
+
+DWORD CNetInputSession::GetRollbackFrame() const
+{
+    DWORD frame = CNetInputHistory::NO_FRAME;
+    for (int i = 0; i < m_playerCount; ++i)
+    {
+        DWORD f = m_history[i].GetRollbackFrame();
+        if (f < frame)
+            frame = f;
+    }
+    return frame;
+}
+
+void CNetInputSession::ClearRollback()
+{
+    for (int i = 0; i < m_playerCount; ++i)
+        m_history[i].ClearRollback();
+}
+
+const CNetInputHistory& CNetInputSession::GetHistory(int player) const
+{
+    return m_history[player];
+}
+
+int CNetInputSession::GetLocalPlayer() const
+{
+    return m_localPlayer;
+}
+
+int CNetInputSession::GetPlayerCount() const
+{
+    return m_playerCount;
+}
+
+//------------------------------------------------------------------------------
+// パケットの符号化
+// 前のフレーム（先頭は入力なし）と同じなら1bit、スティックが同じならアクションのビットだけ
+//------------------------------------------------------------------------------
+int CNetInputSession::EncodePacket(BYTE* buffer, int capacity, int player, DWORD firstFrame, int frameCount, DWORD ackFrame) const
+{
+    if (frameCount < 0 || frameCount > MAX_PACKET_FRAMES)
+        return 0;
+
+    BitWriter writer = { buffer, capacity, 0, false };
+    writer.Write(player, PLAYER_BITS);
+    writer.Write(firstFrame, FRAME_BITS);
+    writer.Write(ackFrame, FRAME_BITS);
+    writer.Write(frameCount, COUNT_BITS);
+
+    NetInput previous;
+    ZeroMemory(&previous, sizeof(previous));
+    for (int i = 0; i < frameCount; ++i)
+    {
+        NetInput input;
+        if (!m_history[player].GetConfirmed(firstFrame + i, input))
+            return 0;
+
+        bool same = input == previous;
+        writer.Write(same ? 1 : 0, 1);
+        if (!same)
+        {
+            writer.Write(input.actions, m_actionCount);
+            bool sticksChanged = input.sticks[0] != previous.sticks[0] || input.sticks[1] != previous.sticks[1] ||
+                input.sticks[2] != previous.sticks[2] || input.sticks[3] != previous.sticks[3];
+            writer.Write(sticksChanged ? 1 : 0, 1);
+            if (sticksChanged)
+            {
+                for (int axis = 0; axis < 4; ++axis)
+                    writer.Write(static_cast<BYTE>(input.sticks[axis]), STICK_BITS);
+            }
+        }
+        previous = input;
+    }
+    return writer.overflow ? 0 : writer.GetSize();
+}
+
+//------------------------------------------------------------------------------
+// パケットの復号
+// 全体を読めたときだけ履歴に反映する
+//------------------------------------------------------------------------------
+bool CNetInputSession::DecodePacket(const BYTE* data, int size)
+{
+    BitReader reader = { data, size, 0, false };
+    int player = static_cast<int>(reader.Read(PLAYER_BITS));
+    DWORD firstFrame = static_cast<DWORD>(reader.Read(FRAME_BITS));
+    DWORD ackFrame = static_cast<DWORD>(reader.Read(FRAME_BITS));
+    int frameCount = static_cast<int>(reader.Read(COUNT_BITS));
+    if (reader.overflow || player == m_localPlayer || player >= m_playerCount || frameCount > MAX_PACKET_FRAMES)
+        return false;
+
+    NetInput inputs[MAX_PACKET_FRAMES];
+    NetInput previous;
+    ZeroMemory(&previous, sizeof(previous));
+    for (int i = 0; i < frameCount; ++i)
+    {
+        NetInput input = previous;
+        if (reader.Read(1) == 0)
+        {
+            input.actions = reader.Read(m_actionCount);
+            if (reader.Read(1) != 0)
+            {
+                for (int axis = 0; axis < 4; ++axis)
+                    input.sticks[axis] = static_cast<signed char>(static_cast<BYTE>(reader.Read(STICK_BITS)));
+            }
+        }
+        inputs[i] = input;
+        previous = input;
+    }
+    if (reader.overflow)
+        return false;
+
+    // 相手が受け取ったローカルの入力（送っていない先のフレームは信じない）
+    if (ackFrame > m_ackFrame[player] && ackFrame <= m_localFrame)
+        m_ackFrame[player] = ackFrame;
+
+    for (int i = 0; i < frameCount; ++i)
+        m_history[player].AddConfirmed(firstFrame + i, inputs[i]);
+    return true;
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include "CActionMap.h"
+#include "CNetTransport.h"
+
+//------------------------------------------------------------------------------
+// NetInput
+// 通信で送る1フレーム分の入力（割り当て済みのアクションと量子化したスティックだけ）
+// 両方の端末はこの値だけでシミュレーションするので、量子化後の値を使うこと
+//------------------------------------------------------------------------------
+struct NetInput
+{
+    uint64_t actions;       // bit i = アクション i が押されている
+    signed char sticks[4];  // LX, LY, RX, RY（-127 ~ 127）
+
+    bool IsPress(int action) const { return ((actions >> action) & 1) != 0; }
+    float GetStick(int axis) const { return sticks[axis] / 127.0f; }
+};
+
+inline bool operator==(const NetInput& a, const NetInput& b)
+{
+    return a.actions == b.actions &&
+        a.sticks[0] == b.sticks[0] && a.sticks[1] == b.sticks[1] &&
+        a.sticks[2] == b.sticks[2] && a.sticks[3] == b.sticks[3];
+}
+
+inline bool operator!=(const NetInput& a, const NetInput& b)
+{
+    return !(a == b);
+}
+
+// アクションの評価結果と、スロット pad のスティックから作る
+NetInput MakeNetInput(const CActionMap& actions, const InputFrame& frame, int pad = 0);
+
+//------------------------------------------------------------------------------
+// CNetInputHistory
+// プレイヤー1人分の入力の履歴（固定サイズのリング、メモリ確保なし）
+//   ・確定した入力（ローカルの入力・届いたリモートの入力）を記録する
+//   ・まだ届いていないフレームは、最後に確定した入力が続くと予測して返し、予測した値を覚えておく
+//   ・届いた入力が予測と違えば、巻き戻すフレーム（GetRollbackFrame）を更新する
+//------------------------------------------------------------------------------
+class CNetInputHistory
+{
+public:
+    static const int CAPACITY = 128;            // 覚えておくフレーム数（2のべき乗）
+    static const DWORD NO_FRAME = 0xFFFFFFFF;
+
+    CNetInputHistory();
+
+    void Reset();
+
+    // 確定した入力を記録する（既に確定したフレームは無視、先の方すぎるフレームは false）
+    bool AddConfirmed(DWORD frame, const NetInput& input);
+
+    // frame の入力（確定していれば true、予測なら false）
+    bool GetInput(DWORD frame, NetInput& input);
+
+    // 確定した入力（確定していなければ false、予測は記録しない）
+    bool GetConfirmed(DWORD frame, NetInput& input) const;
+
+    // このフレームまではすべて確定している（まだなければ NO_FRAME）
+    DWORD GetConfirmedFrame() const;
+    // 次に確定を待っているフレーム
+    DWORD GetNextConfirmFrame() const;
+
+    // 予測が外れた最も古いフレーム（なければ NO_FRAME）
+    DWORD GetRollbackFrame() const;
+    void ClearRollback();
+    int GetMispredictionCount() const;
+
+private:
+    struct Slot
+    {
+        DWORD frame;            // このスロットのフレーム番号（NO_FRAME = 未使用）
+        NetInput input;         // 確定した入力、または返した予測
+        bool confirmed;
+        bool predicted;         // 予測を返したことがある
+    };
+
+    Slot& GetSlot(DWORD frame) { return m_slots[frame & (CAPACITY - 1)]; }
+    const Slot& GetSlot(DWORD frame) const { return m_slots[frame & (CAPACITY - 1)]; }
+
+    Slot m_slots[CAPACITY];
+    DWORD m_nextConfirm;        // これより前のフレームはすべて確定
+    NetInput m_lastConfirmed;   // m_nextConfirm - 1 の入力（予測に使う）
+    DWORD m_rollbackFrame;
+    int m_mispredictionCount;
+};
+
+//------------------------------------------------------------------------------
+// CNetInputSession
+// ロールバック方式の対戦用に、各プレイヤーの入力をまとめて送受信する
+// 毎フレーム：
+//   AddLocalInput(frame, MakeNetInput(...)) → SendInputs() → ReceiveInputs()（false なら待って次のフレームでやり直す）
+//   GetRollbackFrame() が NO_FRAME でなければ、そのフレームからシミュレーションし直して ClearRollback()
+//   各プレイヤーの入力は GetInput(player, frame, input) で取り出す（届いていなければ予測）
+//
+// パケット（ビット単位で詰める）：
+//   送信者(2) 先頭フレーム(32) 受信済みフレーム(32) フレーム数(6)
+//   フレームごとに：前と同じ(1) / アクション(actionCount) スティック変化(1) [スティック 8×4]
+// 相手がまだ受け取っていないフレームを毎回まとめて送るので、失ったパケットは次で補われる
+// 送受信とも固定サイズのバッファで行い、メモリ確保はしない
+//------------------------------------------------------------------------------
+class CNetInputSession
+{
+public:
+    static const int MAX_PLAYERS = 4;
+    static const int MAX_PACKET_FRAMES = 32;    // 1パケットで送る最大フレーム数
+    static const int MAX_PREDICTION_FRAMES = 64; // 確定より先に進める最大フレーム数（CNetInputHistory::CAPACITY より小さく）
+    static const int MAX_PACKET_SIZE = NET_MAX_PACKET_SIZE;
+
+    CNetInputSession();
+
+    // actionCount = 送るアクションの数（1 ~ CActionMap::MAX_ACTION_COUNT、全員で同じ値にする）
+    void Configure(int localPlayer, int playerCount, int actionCount);
+    void Reset();
+
+    // リモートのプレイヤーとの通信路（nullptr で切り離す）
+    void SetTransport(int player, INetTransport* transport);
+
+    // ローカルの入力を確定する（frame は 0 から1ずつ進めること、actionCount より上のアクションは落とす）
+    // 相手の入力が MAX_PREDICTION_FRAMES 以上届いていなければ false（受信してから同じフレームでやり直す）
+    bool AddLocalInput(DWORD frame, const NetInput& input);
+
+    // 相手が受け取っていないローカルの入力を送る
+    void SendInputs();
+
+    // 届いているパケットをすべて読む
+    void ReceiveInputs();
+
+    // プレイヤーの入力（確定していれば true、予測なら false）
+    bool GetInput(int player, DWORD frame, NetInput& input);
+
+    // 全員分が確定しているフレーム（なければ CNetInputHistory::NO_FRAME）
+    DWORD GetConfirmedFrame() const;
+
+    // 巻き戻すフレーム（全員分で最も古いもの、なければ CNetInputHistory::NO_FRAME）
+    DWORD GetRollbackFrame() const;
+    void ClearRollback();
+
+    const CNetInputHistory& GetHistory(int player) const;
+    int GetLocalPlayer() const;
+    int GetPlayerCount() const;
+
+    // パケットの符号化（単体でも使える）
+    // 書き込んだバイト数を返す（入り切らなければ0）
+    int EncodePacket(BYTE* buffer, int capacity, int player, DWORD firstFrame, int frameCount, DWORD ackFrame) const;
+    bool DecodePacket(const BYTE* data, int size);
+
+private:
+    CNetInputHistory m_history[MAX_PLAYERS];
+    INetTransport* m_transport[MAX_PLAYERS];
+    DWORD m_ackFrame[MAX_PLAYERS];      // 相手が受け取り済みのローカルの入力（このフレームより前）
+    DWORD m_localFrame;                 // 次に確定するローカルのフレーム
+    int m_localPlayer;
+    int m_playerCount;
+    int m_actionCount;
+    BYTE m_packet[MAX_PACKET_SIZE];     // 送受信用
+};
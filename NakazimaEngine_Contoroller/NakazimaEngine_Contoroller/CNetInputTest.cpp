@@ -0,0 +1,166 @@
+#include "CSelfTest.h"
+#include "CNetInput.h"
+#include "CNetTransport.h"
+
+namespace
+{
+    const DWORD FRAMES = 600;               // 各プレイヤーが入力するフレーム数
+    const int MAX_TICKS = FRAMES * 4;       // これだけ回しても確定しなければ失敗
+
+    DWORD Hash(DWORD value)
+    {
+        value ^= value >> 16;
+        value *= 0x7FEB352Du;
+        value ^= value >> 15;
+        value *= 0x846CA68Bu;
+        value ^= value >> 16;
+        return value;
+    }
+
+    // プレイヤーの入力（数フレームずつ同じ値が続くので、予測が当たることも外れることもある）
+    NetInput MakeInput(int player, DWORD frame)
+    {
+        NetInput input;
+        ZeroMemory(&input, sizeof(input));
+        input.actions = Hash(player * 0x10000 + frame / (5 + player)) & 0xFFFF;
+        input.sticks[0] = static_cast<signed char>(Hash(player * 0x10000 + frame / 7 + 0x8000) % 255 - 127);
+        return input;
+    }
+
+    // シミュレーションの代わりに、両者の入力を状態へ混ぜ込む
+    ULONGLONG Step(ULONGLONG state, const NetInput& a, const NetInput& b)
+    {
+        state ^= a.actions * 0x9E3779B97F4A7C15ULL;
+        state *= 0xFF51AFD7ED558CCDULL;
+        state ^= b.actions + (static_cast<BYTE>(a.sticks[0]) << 16) + (static_cast<BYTE>(b.sticks[0]) << 24);
+        state *= 0xC4CEB9FE1A85EC53ULL;
+        return state ^ (state >> 29);
+    }
+
+    struct Peer
+    {
+        CNetInputSession session;
+        ULONGLONG states[FRAMES + 1];   // states[f] = フレーム f の前の状態
+        DWORD frame;                    // 次に入力するフレーム
+        DWORD simulated;                // states[simulated] まで求めてある
+        int rollbacks;
+    };
+
+    //--------------------------------------
+    // 2人を link でつないで FRAMES フレーム進め、確定した状態が正しいか確かめる
+    // startTick[i] のティックになるまでプレイヤー i は入力を始めない
+    //--------------------------------------
+    void RunLoopback(const char* name, int delay, int jitter, int loss, const int (&startTick)[2])
+    {
+        CLoopbackLink link;
+        link.Configure(delay, jitter, loss, 7);
+
+        static Peer peers[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            Peer& peer = peers[i];
+            peer.session.Configure(i, 2, 16);
+            peer.session.SetTransport(1 - i, &link.GetEnd(i));
+            peer.states[0] = 0;
+            peer.frame = 0;
+            peer.simulated = 0;
+            peer.rollbacks = 0;
+        }
+
+        int tick = 0;
+        for (; tick < MAX_TICKS; ++tick)
+        {
+            bool done = true;
+            for (int i = 0; i < 2; ++i)
+            {
+                Peer& peer = peers[i];
+                if (tick >= startTick[i] && peer.frame < FRAMES &&
+                    peer.session.AddLocalInput(peer.frame, MakeInput(i, peer.frame)))
+                {
+                    ++peer.frame;
+                }
+                peer.session.SendInputs();
+                peer.session.ReceiveInputs();
+
+                DWORD rollback = peer.session.GetRollbackFrame();
+                if (rollback != CNetInputHistory::NO_FRAME)
+                {
+                    if (rollback < peer.simulated)
+                        peer.simulated = rollback;
+                    peer.session.ClearRollback();
+                    ++peer.rollbacks;
+                }
+                for (; peer.simulated < peer.frame; ++peer.simulated)
+                {
+                    NetInput a, b;
+                    peer.session.GetInput(0, peer.simulated, a);
+                    peer.session.GetInput(1, peer.simulated, b);
+                    peer.states[peer.simulated + 1] = Step(peer.states[peer.simulated], a, b);
+                }
+
+                DWORD confirmed = peer.session.GetConfirmedFrame();
+                if (confirmed == CNetInputHistory::NO_FRAME || confirmed < FRAMES - 1)
+                    done = false;
+            }
+            link.Tick();
+            if (done)
+                break;
+        }
+
+        // 両者とも最後まで確定し、予測で求めた状態が正しい入力で求めた状態と一致する
+        SELF_CHECK(tick < MAX_TICKS);
+        bool match = true;
+        ULONGLONG state = 0;
+        for (DWORD frame = 0; frame < FRAMES; ++frame)
+        {
+            state = Step(state, MakeInput(0, frame), MakeInput(1, frame));
+            match &= peers[0].states[frame + 1] == state && peers[1].states[frame + 1] == state;
+        }
+        SELF_CHECK(peers[0].frame == FRAMES && peers[1].frame == FRAMES);
+        SELF_CHECK(match);
+
+        CSelfTest::Report("  %s: delay %d jitter %d loss %d%%, start %d/%d: %d ticks, sent %d lost %d, rollbacks %d/%d",
+            name, delay, jitter, loss, startTick[0], startTick[1], tick, link.GetSentCount(), link.GetLostCount(),
+            peers[0].rollbacks, peers[1].rollbacks);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 遅延・揺らぎ・損失のある通信路で、両者が同じ結果になる
+//------------------------------------------------------------------------------
+SELF_TEST(NetInputLoopback)
+{
+    const int together[2] = { 0, 0 };
+    RunLoopback("ideal", 0, 0, 0, together);
+    RunLoopback("lossy", 3, 2, 20, together);
+    RunLoopback("slow", 8, 4, 40, together);
+}
+
+//------------------------------------------------------------------------------
+// 片方が先に始めても止まらない（相手の確定が自分のフレームより先にある）
+//------------------------------------------------------------------------------
+SELF_TEST(NetInputPeerAhead)
+{
+    const int secondAhead[2] = { 2, 0 };
+    const int firstAhead[2] = { 0, 20 };
+    RunLoopback("peer 1 ahead", 3, 2, 20, secondAhead);
+    RunLoopback("peer 0 ahead", 1, 0, 0, firstAhead);
+
+    // 相手から自分より先のフレームまで届いていても入力できる
+    CLoopbackLink link;
+    link.Configure(0, 0, 0);
+    static CNetInputSession sessions[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        sessions[i].Configure(i, 2, 16);
+        sessions[i].SetTransport(1 - i, &link.GetEnd(i));
+    }
+    for (DWORD frame = 0; frame < 10; ++frame)
+        SELF_CHECK(sessions[1].AddLocalInput(frame, MakeInput(1, frame)));
+    sessions[1].SendInputs();
+    link.Tick();
+    sessions[0].ReceiveInputs();
+    SELF_CHECK(sessions[0].GetHistory(1).GetNextConfirmFrame() == 10);
+    SELF_CHECK(sessions[0].AddLocalInput(0, MakeInput(0, 0)));
+    SELF_CHECK(sessions[0].AddLocalInput(1, MakeInput(0, 1)));
+}
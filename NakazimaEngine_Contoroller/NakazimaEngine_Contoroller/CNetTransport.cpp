@@ -0,0 +1,135 @@
+#include "CNetTransport.h"
+
+//------------------------------------------------------------------------------
+// コンストラクタ（遅延・損失なし）
+//------------------------------------------------------------------------------
+CLoopbackLink::CLoopbackLink()
+    : m_tick(0)
+    , m_sentCount(0)
+    , m_lostCount(0)
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        m_ends[i].link = this;
+        m_ends[i].side = i;
+        for (int j = 0; j < MAX_IN_FLIGHT; ++j)
+            m_packets[i][j].size = 0;
+    }
+    Configure(0, 0, 0);
+}
+
+//------------------------------------------------------------------------------
+// 遅延と損失の設定
+//------------------------------------------------------------------------------
+void CLoopbackLink::Configure(int delayTicks, int jitterTicks, int lossPercent, DWORD seed)
+{
+    m_delay = delayTicks > 0 ? delayTicks : 0;
+    m_jitter = jitterTicks > 0 ? jitterTicks : 0;
+    m_lossPercent = lossPercent < 0 ? 0 : (lossPercent > 100 ? 100 : lossPercent);
+    m_random = seed != 0 ? seed : 1;
+}
+
+void CLoopbackLink::Tick()
+{
+    ++m_tick;
+}
+
+INetTransport& CLoopbackLink::GetEnd(int side)
+{
+    return m_ends[side];
+}
+
+int CLoopbackLink::GetSentCount() const
+{
+    return m_sentCount;
+}
+
+int CLoopbackLink::GetLostCount() const
+{
+    return m_lostCount;
+}
+
+//------------------------------------------------------------------------------
+// 乱数（xorshift32）
+//------------------------------------------------------------------------------
+DWORD CLoopbackLink::NextRandom()
+{
+    DWORD x = m_random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    m_random = x;
+    return x;
+}
+
+//------------------------------------------------------------------------------
+// 送る：失うかどうかと届く時刻を決めて、相手側の空きに入れる
+//------------------------------------------------------------------------------
+bool CLoopbackLink::Send(int side, const BYTE* data, int size)
+{
+    if (size <= 0 || size > NET_MAX_PACKET_SIZE)
+        return false;
+
+    ++m_sentCount;
+    if (static_cast<int>(NextRandom() % 100) < m_lossPercent)
+    {
+        ++m_lostCount;
+        return true;
+    }
+
+    DWORD deliverTick = m_tick + m_delay + (m_jitter > 0 ? NextRandom() % (m_jitter + 1) : 0);
+    Packet* packets = m_packets[1 - side];
+    for (int i = 0; i < MAX_IN_FLIGHT; ++i)
+    {
+        if (packets[i].size == 0)
+        {
+            packets[i].deliverTick = deliverTick;
+            packets[i].size = size;
+            CopyMemory(packets[i].data, data, size);
+            return true;
+        }
+    }
+
+    // 溢れた分は失われたことにする
+    ++m_lostCount;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// 受け取る：届く時刻を過ぎたもののうち、最も早く届いたものから取り出す
+//------------------------------------------------------------------------------
+int CLoopbackLink::Receive(int side, BYTE* buffer, int capacity)
+{
+    Packet* packets = m_packets[side];
+    int found = -1;
+    for (int i = 0; i < MAX_IN_FLIGHT; ++i)
+    {
+        if (packets[i].size == 0 || static_cast<LONG>(m_tick - packets[i].deliverTick) < 0)
+            continue;
+        if (found < 0 || static_cast<LONG>(packets[i].deliverTick - packets[found].deliverTick) < 0)
+            found = i;
+    }
+    if (found < 0)
+        return 0;
+
+    Packet& packet = packets[found];
+    int size = packet.size;
+    packet.size = 0;
+    if (size > capacity)
+    {
+        ++m_lostCount;
+        return 0;
+    }
+    CopyMemory(buffer, packet.data, size);
+    return size;
+}
+
+bool CLoopbackLink::End::Send(const BYTE* data, int size)
+{
+    return link->Send(side, data, size);
+}
+
+int CLoopbackLink::End::Receive(BYTE* buffer, int capacity)
+{
+    return link->Receive(side, buffer, capacity);
+}
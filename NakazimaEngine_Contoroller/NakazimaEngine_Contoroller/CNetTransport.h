@@ -0,0 +1,78 @@
+#pragma once
+#include <windows.h>
+
+const int NET_MAX_PACKET_SIZE = 512;    // パケット1つの最大バイト数
+
+//------------------------------------------------------------------------------
+// INetTransport
+// パケットの送受信先（届かない・順番が入れ替わることがあってよい）
+//------------------------------------------------------------------------------
+class INetTransport
+{
+public:
+    virtual ~INetTransport() = default;
+
+    // 送る（送れなければ false、届くとは限らない）
+    virtual bool Send(const BYTE* data, int size) = 0;
+
+    // 届いているパケットを1つ取り出す（バイト数を返す、なければ0）
+    virtual int Receive(BYTE* buffer, int capacity) = 0;
+};
+
+//------------------------------------------------------------------------------
+// CLoopbackLink
+// 同じプロセスの中で2つの端をつなぐ通信路（ネットワークなしで通信を確かめる）
+// 送ったパケットは delay ~ delay + jitter ティック後に届き、lossPercent % の確率で失われる
+// 乱数は seed から決まるので、同じ設定なら同じ結果になる
+// パケットは固定サイズの配列に溜めるので、メモリ確保はしない
+//------------------------------------------------------------------------------
+class CLoopbackLink
+{
+public:
+    static const int MAX_IN_FLIGHT = 64;    // 1方向に溜めておけるパケット数（超えたら失われる）
+
+    CLoopbackLink();
+
+    void Configure(int delayTicks, int jitterTicks, int lossPercent, DWORD seed = 1);
+
+    // 時間を1ティック進める（普通は1フレームに1回）
+    void Tick();
+
+    // 端 side（0 / 1）の送受信先（side から送ったパケットは 1 - side に届く）
+    INetTransport& GetEnd(int side);
+
+    int GetSentCount() const;       // 送られたパケット数
+    int GetLostCount() const;       // 失われたパケット数（溢れた分を含む）
+
+private:
+    struct Packet
+    {
+        DWORD deliverTick;          // この時刻以降に受け取れる
+        int size;                   // 0 = 空き
+        BYTE data[NET_MAX_PACKET_SIZE];
+    };
+
+    class End : public INetTransport
+    {
+    public:
+        bool Send(const BYTE* data, int size) override;
+        int Receive(BYTE* buffer, int capacity) override;
+
+        CLoopbackLink* link;
+        int side;
+    };
+
+    bool Send(int side, const BYTE* data, int size);
+    int Receive(int side, BYTE* buffer, int capacity);
+    DWORD NextRandom();
+
+    End m_ends[2];
+    Packet m_packets[2][MAX_IN_FLIGHT];     // [届け先の端]
+    DWORD m_tick;
+    int m_delay;
+    int m_jitter;
+    int m_lossPercent;
+    DWORD m_random;
+    int m_sentCount;
+    int m_lostCount;
+};
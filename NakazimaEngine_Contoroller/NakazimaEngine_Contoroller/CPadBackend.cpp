@@ -0,0 +1,96 @@
+#include "CPadBackend.h"
+#include "PadButtons.h"
+
+//------------------------------------------------------------------------------
+// XInput
+//------------------------------------------------------------------------------
+DWORD CXInputPadBackend::Read(int slot, XINPUT_STATE& state)
+{
+    return XInputGetState(slot, &state);
+}
+
+DWORD CXInputPadBackend::Write(int slot, const XINPUT_VIBRATION& vibration)
+{
+    XINPUT_VIBRATION copy = vibration;
+    return XInputSetState(slot, &copy);
+}
+
+//------------------------------------------------------------------------------
+// 検証用
+//------------------------------------------------------------------------------
+CMockPadBackend::CMockPadBackend()
+{
+    ZeroMemory(m_connected, sizeof(m_connected));
+    ZeroMemory(m_gamepad, sizeof(m_gamepad));
+    ZeroMemory(m_reported, sizeof(m_reported));
+    ZeroMemory(m_packetNumber, sizeof(m_packetNumber));
+    ZeroMemory(m_readCount, sizeof(m_readCount));
+    ZeroMemory(m_writeCount, sizeof(m_writeCount));
+    ZeroMemory(m_last, sizeof(m_last));
+}
+
+DWORD CMockPadBackend::Read(int slot, XINPUT_STATE& state)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_readCount[slot];
+    if (!m_connected[slot])
+        return ERROR_DEVICE_NOT_CONNECTED;
+    if (!IsSamePadState(m_gamepad[slot], m_reported[slot]))
+    {
+        ++m_packetNumber[slot];
+        m_reported[slot] = m_gamepad[slot];
+    }
+    state.dwPacketNumber = m_packetNumber[slot];
+    state.Gamepad = m_gamepad[slot];
+    return ERROR_SUCCESS;
+}
+
+DWORD CMockPadBackend::Write(int slot, const XINPUT_VIBRATION& vibration)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_writeCount[slot];
+    m_last[slot] = vibration;
+    return m_connected[slot] ? ERROR_SUCCESS : ERROR_DEVICE_NOT_CONNECTED;
+}
+
+void CMockPadBackend::SetConnected(int slot, bool connected)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_connected[slot] = connected;
+}
+
+void CMockPadBackend::SetGamepad(int slot, const XINPUT_GAMEPAD& gamepad)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_gamepad[slot] = gamepad;
+}
+
+XINPUT_GAMEPAD CMockPadBackend::GetGamepad(int slot) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_gamepad[slot];
+}
+
+DWORD CMockPadBackend::GetPacketNumber(int slot) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_packetNumber[slot];
+}
+
+int CMockPadBackend::GetReadCount(int slot) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_readCount[slot];
+}
+
+int CMockPadBackend::GetWriteCount(int slot) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_writeCount[slot];
+}
+
+XINPUT_VIBRATION CMockPadBackend::GetLastWrite(int slot) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_last[slot];
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <windows.h>
+#include <Xinput.h>
+#include <mutex>
+#include "CHaptics.h"
+
+//------------------------------------------------------------------------------
+// IPadBackend
+// ゲームパッドの取得元（既定は XInputGetState / XInputSetState、検証用に差し替えられる）
+// 状態は XINPUT_STATE の形（ボタンワード・スティック・トリガー）で返す
+// 振動は IHapticsSink として書き込む
+// バックグラウンドサンプリング中、Read はサンプリングスレッドから呼ばれる
+//------------------------------------------------------------------------------
+class IPadBackend : public IHapticsSink
+{
+public:
+    // 状態を読む（ERROR_SUCCESS 以外なら未接続）
+    virtual DWORD Read(int slot, XINPUT_STATE& state) = 0;
+};
+
+// XInputGetState / XInputSetState を使う
+class CXInputPadBackend : public IPadBackend
+{
+public:
+    DWORD Read(int slot, XINPUT_STATE& state) override;
+    DWORD Write(int slot, const XINPUT_VIBRATION& vibration) override;
+};
+
+// 決めた状態を返し、読み書きを数えるだけ（デバイスなしでの検証用）
+// SetConnected / SetGamepad で、接続・切断やボタン操作を再現する
+// gamepad が前回返したものと違えば、XInput と同じように packetNumber を進める
+// Read はサンプリングスレッドから呼ばれるので、状態はすべてロックして読み書きする
+class CMockPadBackend : public IPadBackend
+{
+public:
+    CMockPadBackend();
+    DWORD Read(int slot, XINPUT_STATE& state) override;
+    DWORD Write(int slot, const XINPUT_VIBRATION& vibration) override;
+
+    void SetConnected(int slot, bool connected);
+    void SetGamepad(int slot, const XINPUT_GAMEPAD& gamepad);
+    XINPUT_GAMEPAD GetGamepad(int slot) const;
+
+    DWORD GetPacketNumber(int slot) const;
+    int GetReadCount(int slot) const;
+    int GetWriteCount(int slot) const;
+    XINPUT_VIBRATION GetLastWrite(int slot) const;
+
+private:
+    mutable std::mutex m_mutex;
+    bool m_connected[XUSER_MAX_COUNT];
+    XINPUT_GAMEPAD m_gamepad[XUSER_MAX_COUNT];
+    XINPUT_GAMEPAD m_reported[XUSER_MAX_COUNT];
+    DWORD m_packetNumber[XUSER_MAX_COUNT];
+    int m_readCount[XUSER_MAX_COUNT];
+    int m_writeCount[XUSER_MAX_COUNT];
+    XINPUT_VIBRATION m_last[XUSER_MAX_COUNT];
+};
@@ -0,0 +1,138 @@
+#include "CSelfTest.h"
+#include "CInputManager.h"
+#include <Dbt.h>
+
+namespace
+{
+    // 検証用のパッドに差し替え、終わったら XInput に戻す
+    struct ScopedMockPads
+    {
+        CMockPadBackend pads;
+
+        ScopedMockPads()
+        {
+            CInputManager::GetInstance().SetPadBackend(&pads);
+        }
+
+        ~ScopedMockPads()
+        {
+            auto& input = CInputManager::GetInstance();
+            input.StopBackgroundSampling();
+            input.SetPadBackend(nullptr);
+        }
+    };
+
+    XINPUT_GAMEPAD MakeGamepad(WORD buttons, BYTE leftTrigger = 0)
+    {
+        XINPUT_GAMEPAD gamepad;
+        ZeroMemory(&gamepad, sizeof(gamepad));
+        gamepad.wButtons = buttons;
+        gamepad.bLeftTrigger = leftTrigger;
+        return gamepad;
+    }
+
+    // サンプリングスレッドが読んだ結果が Update に届くまで待つ（届かなければ false）
+    template <class Condition>
+    bool WaitForUpdate(Condition condition)
+    {
+        auto& input = CInputManager::GetInstance();
+        for (int i = 0; i < 500; ++i)
+        {
+            Sleep(2);
+            input.Update();
+            if (condition(input))
+                return true;
+        }
+        return false;
+    }
+}
+
+//------------------------------------------------------------------------------
+// 接続・切断（メインスレッドで読む場合）
+//------------------------------------------------------------------------------
+SELF_TEST(PadHotPlug)
+{
+    ScopedMockPads mock;
+    auto& input = CInputManager::GetInstance();
+
+    // 差し替えた直後は全スロットを読む
+    input.Update();
+    for (int i = 0; i < XUSER_MAX_COUNT; ++i)
+        SELF_CHECK(mock.pads.GetReadCount(i) == 1);
+
+    // 未接続のスロットは毎フレームは読まない
+    for (int frame = 0; frame < 20; ++frame)
+        input.Update();
+    SELF_CHECK(mock.pads.GetReadCount(1) == 1);
+
+    // デバイスの追加が通知されたら、次の Update ですぐに読む
+    mock.pads.SetConnected(1, true);
+    mock.pads.SetGamepad(1, MakeGamepad(XINPUT_GAMEPAD_A, 200));
+    input.HandleMessage(WM_DEVICECHANGE, DBT_DEVNODES_CHANGED, 0);
+    input.Update();
+    SELF_CHECK(input.IsPadConnectTrigger(1));
+    SELF_CHECK(input.IsPadTrigger(XINPUT_GAMEPAD_A, 1) && input.GetLeftTrigger(1) == 200);
+
+    input.Update();
+    SELF_CHECK(input.IsPadConnected(1) && !input.IsPadConnectTrigger(1));
+    SELF_CHECK(input.IsPadPress(XINPUT_GAMEPAD_A, 1) && !input.IsPadTrigger(XINPUT_GAMEPAD_A, 1));
+
+    // 切断
+    mock.pads.SetConnected(1, false);
+    input.Update();
+    SELF_CHECK(input.IsPadDisconnectTrigger(1) && !input.IsPadPress(XINPUT_GAMEPAD_A, 1));
+    input.Update();
+    SELF_CHECK(!input.IsPadConnected(1) && !input.IsPadDisconnectTrigger(1));
+
+    // ProbePadsNow でも同じように見つかる
+    mock.pads.SetGamepad(1, MakeGamepad(0));
+    mock.pads.SetConnected(1, true);
+    input.ProbePadsNow();
+    input.Update();
+    SELF_CHECK(input.IsPadConnectTrigger(1) && !input.IsPadPress(XINPUT_GAMEPAD_A, 1));
+}
+
+//------------------------------------------------------------------------------
+// 接続・切断（サンプリングスレッドで読む場合）
+// 取得元の状態は、サンプリングスレッドが読んでいる間にこのスレッドから書き換える
+//------------------------------------------------------------------------------
+SELF_TEST(PadHotPlugSampler)
+{
+    ScopedMockPads mock;
+    auto& input = CInputManager::GetInstance();
+    mock.pads.SetConnected(0, true);
+    input.Update();
+
+    SELF_CHECK(input.StartBackgroundSampling(1000, false));
+    SELF_CHECK(!input.SetPadBackend(nullptr));
+
+    // サンプリング中の接続
+    mock.pads.SetConnected(2, true);
+    mock.pads.SetGamepad(2, MakeGamepad(XINPUT_GAMEPAD_B));
+    input.ProbePadsNow();
+    SELF_CHECK(WaitForUpdate([](const CInputManager& in) { return in.IsPadConnected(2); }));
+    SELF_CHECK(WaitForUpdate([](const CInputManager& in) { return in.IsPadPress(XINPUT_GAMEPAD_B, 2); }));
+
+    // 読まれている最中に押す・離すを繰り返しても、最後の状態に落ち着く
+    for (int i = 0; i < 200; ++i)
+    {
+        mock.pads.SetGamepad(0, MakeGamepad((i & 1) ? XINPUT_GAMEPAD_A : 0));
+        if (i % 20 == 0)
+            input.Update();
+    }
+    mock.pads.SetGamepad(0, MakeGamepad(XINPUT_GAMEPAD_A));
+    SELF_CHECK(WaitForUpdate([](const CInputManager& in) { return in.IsPadPress(XINPUT_GAMEPAD_A, 0); }));
+    mock.pads.SetGamepad(0, MakeGamepad(0));
+    SELF_CHECK(WaitForUpdate([](const CInputManager& in) { return !in.IsPadPress(XINPUT_GAMEPAD_A, 0); }));
+
+    // サンプリング中の切断
+    mock.pads.SetConnected(2, false);
+    SELF_CHECK(WaitForUpdate([](const CInputManager& in) { return !in.IsPadConnected(2); }));
+
+    // 止めたらもう読まない
+    input.StopBackgroundSampling();
+    int reads = mock.pads.GetReadCount(0);
+    Sleep(10);
+    SELF_CHECK(mock.pads.GetReadCount(0) == reads);
+    SELF_CHECK(input.SetPadBackend(&mock.pads));
+}
@@ -0,0 +1,115 @@
+#include "CSelfTest.h"
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    // 登録の順は静的変数の初期化順に従う（ファイルをまたぐ順は決まらない）
+    CSelfTest*& Head()
+    {
+        static CSelfTest* head = nullptr;
+        return head;
+    }
+
+    std::string g_output;   // 書き出す結果
+    int g_failed = 0;       // 失敗した SELF_CHECK の数
+}
+
+//------------------------------------------------------------------------------
+// 登録する
+//------------------------------------------------------------------------------
+CSelfTest::CSelfTest(const char* name, Func func, bool bench)
+    : m_name(name)
+    , m_func(func)
+    , m_bench(bench)
+    , m_next(Head())
+{
+    Head() = this;
+}
+
+//------------------------------------------------------------------------------
+// すべて実行して結果を書き出す
+//------------------------------------------------------------------------------
+int CSelfTest::RunAll(bool bench, const wchar_t* path)
+{
+    g_output.clear();
+    g_failed = 0;
+
+    int count = 0;
+    for (CSelfTest* test = Head(); test; test = test->m_next)
+    {
+        if (test->m_bench != bench)
+            continue;
+        int failed = g_failed;
+        Report("[%s]", test->m_name);
+        test->m_func();
+        if (!bench)
+            Report("  %s", g_failed == failed ? "ok" : "FAILED");
+        ++count;
+    }
+    if (bench)
+        Report("%d benchmarks", count);
+    else
+        Report("%d tests, %d checks failed", count, g_failed);
+
+    Flush(path);
+    return g_failed;
+}
+
+//------------------------------------------------------------------------------
+// 結果を書き出す
+//------------------------------------------------------------------------------
+bool CSelfTest::Flush(const wchar_t* path)
+{
+    HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD dwWritten;
+    bool ok = WriteFile(file, g_output.data(), static_cast<DWORD>(g_output.size()), &dwWritten, nullptr) != FALSE;
+    CloseHandle(file);
+    g_output.clear();
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+// 検証の失敗を記録する
+//------------------------------------------------------------------------------
+void CSelfTest::Fail(const char* file, int line, const char* expression)
+{
+    ++g_failed;
+    Report("  %s(%d): %s", file, line, expression);
+}
+
+//------------------------------------------------------------------------------
+// 結果に1行書く
+//------------------------------------------------------------------------------
+void CSelfTest::Report(const char* format, ...)
+{
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line) - 1, format, args);
+    va_end(args);
+    if (length < 0)
+        return;
+    if (length > static_cast<int>(sizeof(line)) - 2)
+        length = static_cast<int>(sizeof(line)) - 2;
+    line[length++] = '\n';
+    line[length] = '\0';
+
+    g_output.append(line, length);
+    OutputDebugStringA(line);
+}
+
+//------------------------------------------------------------------------------
+// 計測用の時刻
+//------------------------------------------------------------------------------
+double CSelfTest::GetTimeUs()
+{
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return static_cast<double>(now.QuadPart) * 1000000.0 / static_cast<double>(freq.QuadPart);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <windows.h>
+
+//------------------------------------------------------------------------------
+// CSelfTest
+// 検証と計測を登録しておき、コマンドラインの -selftest / -bench でまとめて実行する
+//   SELF_TEST(名前) { SELF_CHECK(式); ... }      検証（失敗した SELF_CHECK を数える）
+//   SELF_BENCH(名前) { CSelfTest::Report(...); } 計測（結果を1行ずつ書く）
+// ウィンドウ・デバイスは作らずに実行するので、入力の処理だけを調べられる
+// 結果はテキストファイルと OutputDebugString に出す
+//------------------------------------------------------------------------------
+class CSelfTest
+{
+public:
+    typedef void (*Func)();
+
+    // 登録する（SELF_TEST / SELF_BENCH の静的変数から呼ばれる）
+    CSelfTest(const char* name, Func func, bool bench);
+
+    // 登録された検証（bench = false）か計測（bench = true）をすべて実行し、結果を path へ書き出す
+    // 戻り値は失敗した SELF_CHECK の数
+    static int RunAll(bool bench, const wchar_t* path);
+
+    // 検証の失敗を記録する（SELF_CHECK から呼ばれる）
+    static void Fail(const char* file, int line, const char* expression);
+
+    // 結果に1行書く（printf 形式、改行は付けなくてよい）
+    static void Report(const char* format, ...);
+
+    // ここまでに書いた結果を path へ書き出して空にする（RunAll 以外で Report を使ったとき）
+    static bool Flush(const wchar_t* path);
+
+    // 計測用の時刻（マイクロ秒）
+    static double GetTimeUs();
+
+private:
+    const char* m_name;
+    Func m_func;
+    bool m_bench;
+    CSelfTest* m_next;
+};
+
+#define SELF_TEST(name) \
+    static void SelfTest_##name(); \
+    static CSelfTest s_selfTest_##name(#name, SelfTest_##name, false); \
+    static void SelfTest_##name()
+
+#define SELF_BENCH(name) \
+    static void SelfBench_##name(); \
+    static CSelfTest s_selfBench_##name(#name, SelfBench_##name, true); \
+    static void SelfBench_##name()
+
+#define SELF_CHECK(expression) \
+    ((expression) ? (void)0 : CSelfTest::Fail(__FILE__, __LINE__, #expression))
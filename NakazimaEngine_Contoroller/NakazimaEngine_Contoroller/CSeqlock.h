@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+//------------------------------------------------------------------------------
+// CSeqlock
+// 書き込みスレッド1つ・読み出しスレッドいくつでも使える、ロックなしの値の受け渡し
+// 書き込み側は番号を奇数にしてから値を書き、書き終えたら偶数に戻す
+// 読み出し側は前後で番号が同じ偶数なら、途中で書き換えられていない値を読めている
+// 値は atomic の語の並びとして持つので、読み書きが重なってもデータ競合にはならない
+// Store() は書き込み側のスレッドからのみ呼ぶこと
+//------------------------------------------------------------------------------
+template<class T>
+class CSeqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+public:
+    CSeqlock()
+        : m_sequence(0)
+    {
+        for (size_t i = 0; i < WORD_COUNT; ++i)
+            m_words[i].store(0, std::memory_order_relaxed);
+    }
+
+    // 値を公開する
+    void Store(const T& value)
+    {
+        size_t words[WORD_COUNT] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        unsigned int sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < WORD_COUNT; ++i)
+            m_words[i].store(words[i], std::memory_order_relaxed);
+
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // 1回だけ読んでみる（書き込み中だったら false）
+    bool TryLoad(T& value) const
+    {
+        unsigned int before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            return false;
+
+        size_t words[WORD_COUNT];
+        for (size_t i = 0; i < WORD_COUNT; ++i)
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) != before)
+            return false;
+
+        std::memcpy(&value, words, sizeof(T));
+        return true;
+    }
+
+    // 読めるまでくり返す
+    // 書き込みは短いので普通はすぐ読めるが、書き込み側が止められていたら譲る
+    void Load(T& value) const
+    {
+        for (int retry = 0; !TryLoad(value); ++retry)
+        {
+            if (retry >= SPIN_COUNT)
+                std::this_thread::yield();
+        }
+    }
+
+    // これまでに Store した回数
+    unsigned int GetVersion() const
+    {
+        return m_sequence.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+    static const size_t WORD_COUNT = (sizeof(T) + sizeof(size_t) - 1) / sizeof(size_t);
+    static const int SPIN_COUNT = 64;
+
+    alignas(64) std::atomic<unsigned int> m_sequence;  // 奇数 = 書き込み中
+    alignas(64) std::atomic<size_t> m_words[WORD_COUNT];
+};
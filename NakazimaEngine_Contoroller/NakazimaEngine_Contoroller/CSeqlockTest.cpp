@@ -0,0 +1,83 @@
+#include "CSelfTest.h"
+#include "CSeqlock.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // 全部の語に同じ値を書いた値（1語でも違えば、途中で書き換えられたものを読んでいる）
+    // InputSnapshot と同じくらいの大きさにする
+    struct StressValue
+    {
+        ULONGLONG words[40];
+    };
+
+    bool IsConsistent(const StressValue& value)
+    {
+        for (ULONGLONG word : value.words)
+        {
+            if (word != value.words[0])
+                return false;
+        }
+        return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+// 書き込み中の読み出しを複数のスレッドからくり返しても、書きかけの値を読まない
+// 各スレッドが読む値は古くならない（前に読んだ値より前の値を読まない）
+//------------------------------------------------------------------------------
+SELF_TEST(SeqlockStress)
+{
+    const int READERS = 8;
+    const ULONGLONG STORES = 200000;
+
+    CSeqlock<StressValue> seqlock;
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::atomic<int> backwards(0);
+    std::atomic<ULONGLONG> reads(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; ++r)
+    {
+        readers.emplace_back([&]()
+        {
+            ULONGLONG last = 0;
+            ULONGLONG count = 0;
+            StressValue value;
+            while (!done.load(std::memory_order_acquire))
+            {
+                seqlock.Load(value);
+                if (!IsConsistent(value))
+                    torn.fetch_add(1);
+                if (value.words[0] < last)
+                    backwards.fetch_add(1);
+                last = value.words[0];
+                ++count;
+            }
+            reads.fetch_add(count);
+        });
+    }
+
+    StressValue value;
+    for (ULONGLONG n = 1; n <= STORES; ++n)
+    {
+        for (ULONGLONG& word : value.words)
+            word = n;
+        seqlock.Store(value);
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers)
+        reader.join();
+
+    SELF_CHECK(torn.load() == 0);
+    SELF_CHECK(backwards.load() == 0);
+    SELF_CHECK(reads.load() > 0);
+    SELF_CHECK(seqlock.GetVersion() == STORES);
+
+    StressValue last;
+    SELF_CHECK(seqlock.TryLoad(last) && IsConsistent(last) && last.words[0] == STORES);
+    CSelfTest::Report("  %d readers, %llu stores, %llu reads", READERS, STORES, reads.load());
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+
+//------------------------------------------------------------------------------
+// CSpscRing
+// 書き込みスレッド1つ・読み出しスレッド1つ専用のロックフリーなリングバッファ
+// Push() は書き込み側、Pop() は読み出し側のスレッドからのみ呼ぶこと
+// SIZE は2のべき乗
+//------------------------------------------------------------------------------
+template<class T, unsigned int SIZE>
+class CSpscRing
+{
+    static_assert(SIZE != 0 && (SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+
+public:
+    CSpscRing()
+        : m_head(0)
+        , m_tail(0)
+    {
+    }
+
+    // 要素を追加する（満杯なら false を返し、何もしない）
+    bool Push(const T& value)
+    {
+        unsigned int tail = m_tail.load(std::memory_order_relaxed);
+        unsigned int head = m_head.load(std::memory_order_acquire);
+        if (tail - head >= SIZE)
+            return false;
+
+        m_buffer[tail & (SIZE - 1)] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 先頭の要素を取り出す（空なら false を返す）
+    bool Pop(T& value)
+    {
+        unsigned int head = m_head.load(std::memory_order_relaxed);
+        unsigned int tail = m_tail.load(std::memory_order_acquire);
+        if (head == tail)
+            return false;
+
+        value = m_buffer[head & (SIZE - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 空にする（書き込み側が動いていないときだけ呼ぶこと）
+    void Clear()
+    {
+        m_head.store(m_tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    // 読み出し位置と書き込み位置は別のキャッシュラインに置く
+    alignas(64) std::atomic<unsigned int> m_head;  // 次に読み出す位置（読み出し側が更新）
+    alignas(64) std::atomic<unsigned int> m_tail;  // 次に書き込む位置（書き込み側が更新）
+    alignas(64) T m_buffer[SIZE];
+};
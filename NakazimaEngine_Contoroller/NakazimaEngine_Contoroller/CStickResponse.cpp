@@ -0,0 +1,221 @@
+#include "CStickResponse.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef STICKRESPONSE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    const float THUMB_SCALE = 1.0f / 32767.0f;
+
+    float Clamp01(float value)
+    {
+        return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 既定の設定
+//------------------------------------------------------------------------------
+StickSettings GetDefaultStickSettings(float deadzone)
+{
+    StickSettings settings;
+    ZeroMemory(&settings, sizeof(settings));
+    settings.deadzoneModel = STICK_DEADZONE_SCALED_RADIAL;
+    settings.curve = STICK_CURVE_LINEAR;
+    settings.deadzone = deadzone;
+    settings.saturation = 1.0f;
+    settings.exponent = 2.0f;
+    return settings;
+}
+
+//------------------------------------------------------------------------------
+// コンストラクタ（デッドゾーンなし・直線）
+//------------------------------------------------------------------------------
+CStickResponse::CStickResponse()
+{
+    Configure(GetDefaultStickSettings(0.0f));
+}
+
+//------------------------------------------------------------------------------
+// 設定を表に焼き込む
+// 表の i 番目 = 倒した量 i / TABLE_SIZE に対する出力
+//------------------------------------------------------------------------------
+void CStickResponse::Configure(const StickSettings& settings)
+{
+    m_settings = settings;
+
+    float deadzone = Clamp01(settings.deadzone);
+    float saturation = settings.saturation > deadzone ? (std::min)(settings.saturation, 1.0f) : 1.0f;
+    if (saturation <= deadzone)
+        deadzone = 0.0f;
+
+    for (int i = 0; i <= TABLE_SIZE; ++i)
+    {
+        float magnitude = static_cast<float>(i) / TABLE_SIZE;
+
+        // デッドゾーンと飽和
+        float value;
+        if (settings.deadzoneModel == STICK_DEADZONE_RADIAL)
+            value = (magnitude < deadzone) ? 0.0f : Clamp01(magnitude / saturation);
+        else
+            value = Clamp01((magnitude - deadzone) / (saturation - deadzone));
+
+        // カーブ
+        switch (settings.curve)
+        {
+        case STICK_CURVE_EXPONENTIAL:
+            value = std::pow(value, settings.exponent > 0.0f ? settings.exponent : 1.0f);
+            break;
+
+        case STICK_CURVE_CUSTOM:
+        {
+            float x0 = 0.0f;
+            float y0 = 0.0f;
+            float x1 = 1.0f;
+            float y1 = 1.0f;
+            int count = (std::min)(settings.pointCount, static_cast<int>(StickSettings::MAX_CURVE_POINTS));
+            for (int p = 0; p < count; ++p)
+            {
+                if (settings.pointIn[p] <= value)
+                {
+                    x0 = settings.pointIn[p];
+                    y0 = settings.pointOut[p];
+                }
+                else
+                {
+                    x1 = settings.pointIn[p];
+                    y1 = settings.pointOut[p];
+                    break;
+                }
+            }
+            value = (x1 > x0) ? y0 + (y1 - y0) * (value - x0) / (x1 - x0) : y0;
+            value = Clamp01(value);
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        m_table[i] = value;
+    }
+    m_table[TABLE_SIZE + 1] = m_table[TABLE_SIZE];
+}
+
+const StickSettings& CStickResponse::GetSettings() const
+{
+    return m_settings;
+}
+
+//------------------------------------------------------------------------------
+// 表の参照（線形補間）
+//------------------------------------------------------------------------------
+float CStickResponse::Lookup(float magnitude) const
+{
+    float position = Clamp01(magnitude) * TABLE_SIZE;
+    int index = static_cast<int>(position);
+    float t = position - index;
+    return m_table[index] + (m_table[index + 1] - m_table[index]) * t;
+}
+
+//------------------------------------------------------------------------------
+// スティックの処理（ビルド設定で速い実装を選ぶ）
+//------------------------------------------------------------------------------
+void CStickResponse::Process(const SHORT* x, const SHORT* y, float* outX, float* outY, int count) const
+{
+#ifdef STICKRESPONSE_USE_SSE2
+    int vectorCount = count & ~3;
+    ProcessSSE2(x, y, outX, outY, vectorCount);
+    ProcessScalar(x + vectorCount, y + vectorCount, outX + vectorCount, outY + vectorCount, count - vectorCount);
+#else
+    ProcessScalar(x, y, outX, outY, count);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// スカラー版
+// 円形：倒した量で表を引き、方向はそのままで長さだけを出力に合わせる
+// 軸ごと：X と Y それぞれで表を引く
+//------------------------------------------------------------------------------
+void CStickResponse::ProcessScalar(const SHORT* x, const SHORT* y, float* outX, float* outY, int count) const
+{
+    for (int i = 0; i < count; ++i)
+    {
+        float fx = x[i] * THUMB_SCALE;
+        float fy = y[i] * THUMB_SCALE;
+
+        if (m_settings.deadzoneModel == STICK_DEADZONE_AXIAL)
+        {
+            outX[i] = (fx < 0.0f) ? -Lookup(-fx) : Lookup(fx);
+            outY[i] = (fy < 0.0f) ? -Lookup(-fy) : Lookup(fy);
+        }
+        else
+        {
+            float magnitude = std::sqrt(fx * fx + fy * fy);
+            float gain = (magnitude > 0.0f) ? Lookup(magnitude) / magnitude : 0.0f;
+            outX[i] = fx * gain;
+            outY[i] = fy * gain;
+        }
+    }
+}
+
+#ifdef STICKRESPONSE_USE_SSE2
+//------------------------------------------------------------------------------
+// SSE2版（4本ずつ、count は4の倍数）
+// 表の参照だけは1本ずつ読み出し、それ以外は4本まとめて計算する
+//------------------------------------------------------------------------------
+void CStickResponse::ProcessSSE2(const SHORT* x, const SHORT* y, float* outX, float* outY, int count) const
+{
+    const __m128 scale = _mm_set1_ps(THUMB_SCALE);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 tableSize = _mm_set1_ps(static_cast<float>(TABLE_SIZE));
+    const __m128 tiny = _mm_set1_ps(1e-12f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    // 4本分の値（0.0f ~ 1.0f）で表を引く
+    auto lookup4 = [this, &one, &tableSize](__m128 value) -> __m128
+    {
+        __m128 position = _mm_mul_ps(_mm_min_ps(value, one), tableSize);
+        __m128i index = _mm_cvttps_epi32(position);
+        __m128 t = _mm_sub_ps(position, _mm_cvtepi32_ps(index));
+
+        alignas(16) int idx[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(idx), index);
+        __m128 a = _mm_setr_ps(m_table[idx[0]], m_table[idx[1]], m_table[idx[2]], m_table[idx[3]]);
+        __m128 b = _mm_setr_ps(m_table[idx[0] + 1], m_table[idx[1] + 1], m_table[idx[2] + 1], m_table[idx[3] + 1]);
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+    };
+
+    for (int i = 0; i < count; i += 4)
+    {
+        // SHORT × 4 を float × 4 に（符号拡張してから変換）
+        __m128i ix = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + i));
+        __m128i iy = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + i));
+        __m128 fx = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(ix, ix), 16)), scale);
+        __m128 fy = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(iy, iy), 16)), scale);
+
+        __m128 rx, ry;
+        if (m_settings.deadzoneModel == STICK_DEADZONE_AXIAL)
+        {
+            // 絶対値で引いて、元の符号を付け直す
+            __m128 signX = _mm_and_ps(fx, signMask);
+            __m128 signY = _mm_and_ps(fy, signMask);
+            rx = _mm_or_ps(lookup4(_mm_andnot_ps(signMask, fx)), signX);
+            ry = _mm_or_ps(lookup4(_mm_andnot_ps(signMask, fy)), signY);
+        }
+        else
+        {
+            __m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy, fy)));
+            __m128 gain = _mm_div_ps(lookup4(magnitude), _mm_max_ps(magnitude, tiny));
+            rx = _mm_mul_ps(fx, gain);
+            ry = _mm_mul_ps(fy, gain);
+        }
+
+        _mm_storeu_ps(outX + i, rx);
+        _mm_storeu_ps(outY + i, ry);
+    }
+}
+#endif
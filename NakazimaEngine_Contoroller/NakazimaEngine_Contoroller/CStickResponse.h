@@ -0,0 +1,83 @@
+#pragma once
+#include <windows.h>
+
+// 使用する SIMD 命令セットの選択（コンパイルオプションに従う）
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STICKRESPONSE_USE_SSE2
+#endif
+
+//------------------------------------------------------------------------------
+// デッドゾーンの形
+//------------------------------------------------------------------------------
+enum StickDeadzoneModel : BYTE
+{
+    STICK_DEADZONE_AXIAL,           // 軸ごと（X と Y を別々に処理、十字方向に吸い付く）
+    STICK_DEADZONE_RADIAL,          // 円形（デッドゾーンの外は倒した量そのまま）
+    STICK_DEADZONE_SCALED_RADIAL,   // 円形（デッドゾーンの外側を 0.0f ~ 1.0f に引き伸ばす）
+};
+
+//------------------------------------------------------------------------------
+// 倒した量に対する出力のカーブ
+//------------------------------------------------------------------------------
+enum StickCurve : BYTE
+{
+    STICK_CURVE_LINEAR,             // そのまま
+    STICK_CURVE_EXPONENTIAL,        // 倒した量の exponent 乗（小さい入力を細かく扱える）
+    STICK_CURVE_CUSTOM,             // points を結んだ折れ線
+};
+
+//------------------------------------------------------------------------------
+// StickSettings
+// 倒した量はすべて 0.0f（中心）~ 1.0f（端）で指定する
+//------------------------------------------------------------------------------
+struct StickSettings
+{
+    static const int MAX_CURVE_POINTS = 8;
+
+    BYTE deadzoneModel;     // StickDeadzoneModel
+    BYTE curve;             // StickCurve
+    float deadzone;         // これより内側は0
+    float saturation;       // これより外側は1（端まで倒し切らなくても最大にする）
+    float exponent;         // STICK_CURVE_EXPONENTIAL の指数
+
+    // STICK_CURVE_CUSTOM の点（入力の昇順、(0,0) と (1,1) は自動で両端に付く）
+    int pointCount;
+    float pointIn[MAX_CURVE_POINTS];
+    float pointOut[MAX_CURVE_POINTS];
+};
+
+// 既定の設定（SCALED_RADIAL、直線、XInput 推奨のデッドゾーン）
+StickSettings GetDefaultStickSettings(float deadzone);
+
+//------------------------------------------------------------------------------
+// CStickResponse
+// スティックのデッドゾーンとカーブの処理
+// 設定時にデッドゾーン・飽和・カーブをまとめて表に焼き込んでおき、
+// 毎フレームの処理は 表の参照 + 数回の掛け算 で済ませる
+// Process は複数のスティックを SSE2 で4本ずつまとめて処理する
+//------------------------------------------------------------------------------
+class CStickResponse
+{
+public:
+    static const int TABLE_SIZE = 256;  // 表の区間数
+
+    CStickResponse();
+
+    void Configure(const StickSettings& settings);
+    const StickSettings& GetSettings() const;
+
+    // count 本のスティックを処理する（入力は XINPUT_GAMEPAD の値、出力は -1.0f ~ 1.0f）
+    void Process(const SHORT* x, const SHORT* y, float* outX, float* outY, int count) const;
+
+private:
+    // 倒した量（0.0f ~ 1.0f）に対する出力（表を線形補間）
+    float Lookup(float magnitude) const;
+
+    void ProcessScalar(const SHORT* x, const SHORT* y, float* outX, float* outY, int count) const;
+#ifdef STICKRESPONSE_USE_SSE2
+    void ProcessSSE2(const SHORT* x, const SHORT* y, float* outX, float* outY, int count) const;
+#endif
+
+    StickSettings m_settings;
+    float m_table[TABLE_SIZE + 2];  // 補間で1つ先を読むので末尾に1つ余分に持つ
+};
@@ -0,0 +1,265 @@
+#include "CVirtualButtons.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef VIRTUALBUTTONS_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    constexpr float THUMB_SCALE = 1.0f / 32767.0f;
+    constexpr float TRIGGER_SCALE = 1.0f / 255.0f;
+
+    // 8方向：倒した向きがその方向の ±67.5° の中か（その方向の成分 > 直交する成分 × tan22.5°）
+    // 押している方向は ±75° まで広げて、斜めとの境目でばたつかないようにする
+    constexpr float SECTOR_ENTER = 0.41421356f;    // tan22.5°
+    constexpr float SECTOR_HOLD = 0.26794919f;     // tan15°
+
+    // 既定の表
+    constexpr float TRIGGER_PRESS = PAD_TRIGGER_THRESHOLD * TRIGGER_SCALE;  // MakePadButtons と同じ値
+    constexpr float TRIGGER_RELEASE = 40 * TRIGGER_SCALE;
+    constexpr float STICK_PRESS = 0.5f;
+    constexpr float STICK_RELEASE = 0.4f;
+
+    constexpr VirtualButton DEFAULT_BUTTONS[] =
+    {
+        { PAD_BIT_LEFT_TRIGGER, VIRTUAL_SOURCE_LEFT_TRIGGER, TRIGGER_PRESS, TRIGGER_RELEASE },
+        { PAD_BIT_RIGHT_TRIGGER, VIRTUAL_SOURCE_RIGHT_TRIGGER, TRIGGER_PRESS, TRIGGER_RELEASE },
+        { PAD_BIT_LSTICK_LEFT, VIRTUAL_SOURCE_LSTICK_LEFT, STICK_PRESS, STICK_RELEASE },
+        { PAD_BIT_LSTICK_RIGHT, VIRTUAL_SOURCE_LSTICK_RIGHT, STICK_PRESS, STICK_RELEASE },
+        { PAD_BIT_LSTICK_UP, VIRTUAL_SOURCE_LSTICK_UP, STICK_PRESS, STICK_RELEASE },
+        { PAD_BIT_LSTICK_DOWN, VIRTUAL_SOURCE_LSTICK_DOWN, STICK_PRESS, STICK_RELEASE },
+        { PAD_BIT_RSTICK_LEFT, VIRTUAL_SOURCE_RSTICK_LEFT, STICK_PRESS, STICK_RELEASE },
+        { PAD_BIT_RSTICK_RIGHT, VIRTUAL_SOURCE_RSTICK_RIGHT, STICK_PRESS, STICK_RELEASE },
+        { PAD_BIT_RSTICK_UP, VIRTUAL_SOURCE_RSTICK_UP, STICK_PRESS, STICK_RELEASE },
+        { PAD_BIT_RSTICK_DOWN, VIRTUAL_SOURCE_RSTICK_DOWN, STICK_PRESS, STICK_RELEASE },
+        { PAD_BIT_LSTICK_DPAD_LEFT, VIRTUAL_SOURCE_LSTICK_8WAY_LEFT, STICK_PRESS, STICK_RELEASE },
+        { PAD_BIT_LSTICK_DPAD_RIGHT, VIRTUAL_SOURCE_LSTICK_8WAY_RIGHT, STICK_PRESS, STICK_RELEASE },
+        { PAD_BIT_LSTICK_DPAD_UP, VIRTUAL_SOURCE_LSTICK_8WAY_UP, STICK_PRESS, STICK_RELEASE },
+        { PAD_BIT_LSTICK_DPAD_DOWN, VIRTUAL_SOURCE_LSTICK_8WAY_DOWN, STICK_PRESS, STICK_RELEASE },
+    };
+
+    float ClampAxis(float value)
+    {
+        return value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    }
+
+    //--------------------------------------
+    // 1台分のアナログ入力の値（スカラー版）
+    // enter は離しているとき、hold は押しているときに使う値（8方向だけ範囲が違う）
+    //--------------------------------------
+    void ComputeSources(const XINPUT_GAMEPAD& pad, float* enter, float* hold)
+    {
+        enter[VIRTUAL_SOURCE_LEFT_TRIGGER] = pad.bLeftTrigger * TRIGGER_SCALE;
+        enter[VIRTUAL_SOURCE_RIGHT_TRIGGER] = pad.bRightTrigger * TRIGGER_SCALE;
+
+        const float stickX[2] = { ClampAxis(pad.sThumbLX * THUMB_SCALE), ClampAxis(pad.sThumbRX * THUMB_SCALE) };
+        const float stickY[2] = { ClampAxis(pad.sThumbLY * THUMB_SCALE), ClampAxis(pad.sThumbRY * THUMB_SCALE) };
+        for (int stick = 0; stick < 2; ++stick)
+        {
+            float x = stickX[stick];
+            float y = stickY[stick];
+            float magnitude = (std::min)(std::sqrt(x * x + y * y), 1.0f);
+
+            // 左・右・上・下の順
+            const float along[4] = { -x, x, y, -y };
+            const float across[4] = { std::fabs(y), std::fabs(y), std::fabs(x), std::fabs(x) };
+            for (int dir = 0; dir < 4; ++dir)
+            {
+                int axis = VIRTUAL_SOURCE_LSTICK_LEFT + stick * 4 + dir;
+                enter[axis] = along[dir];
+                hold[axis] = along[dir];
+
+                int sector = VIRTUAL_SOURCE_LSTICK_8WAY_LEFT + stick * 4 + dir;
+                enter[sector] = (along[dir] > across[dir] * SECTOR_ENTER) ? magnitude : 0.0f;
+                hold[sector] = (along[dir] > across[dir] * SECTOR_HOLD) ? magnitude : 0.0f;
+            }
+        }
+
+        hold[VIRTUAL_SOURCE_LEFT_TRIGGER] = enter[VIRTUAL_SOURCE_LEFT_TRIGGER];
+        hold[VIRTUAL_SOURCE_RIGHT_TRIGGER] = enter[VIRTUAL_SOURCE_RIGHT_TRIGGER];
+    }
+}
+
+//------------------------------------------------------------------------------
+// コンストラクタ（既定の表）
+//------------------------------------------------------------------------------
+CVirtualButtons::CVirtualButtons()
+{
+    Configure(DEFAULT_BUTTONS);
+}
+
+//------------------------------------------------------------------------------
+// 表の設定
+//------------------------------------------------------------------------------
+void CVirtualButtons::Configure(const VirtualButton* buttons, int count)
+{
+    m_count = 0;
+    m_mask = 0;
+    count = (std::min)(count, static_cast<int>(MAX_BUTTONS));
+    for (int i = 0; i < count; ++i)
+    {
+        if (buttons[i].source >= VIRTUAL_SOURCE_COUNT || buttons[i].bit == 0)
+            continue;
+
+        VirtualButton& button = m_buttons[m_count++];
+        button = buttons[i];
+        button.release = (std::min)(button.release, button.press);
+        m_mask |= button.bit;
+    }
+}
+
+bool CVirtualButtons::SetThresholds(DWORD bit, float press, float release)
+{
+    bool found = false;
+    for (int i = 0; i < m_count; ++i)
+    {
+        if (m_buttons[i].bit != bit)
+            continue;
+        m_buttons[i].press = press;
+        m_buttons[i].release = (std::min)(release, press);
+        found = true;
+    }
+    return found;
+}
+
+int CVirtualButtons::GetCount() const
+{
+    return m_count;
+}
+
+const VirtualButton& CVirtualButtons::GetButton(int index) const
+{
+    return m_buttons[index];
+}
+
+DWORD CVirtualButtons::GetMask() const
+{
+    return m_mask;
+}
+
+//------------------------------------------------------------------------------
+// ボタンワードを作る（ビルド設定で速い実装を選ぶ）
+//------------------------------------------------------------------------------
+void CVirtualButtons::Process(const XINPUT_GAMEPAD* pads, DWORD* buttons, int count) const
+{
+#ifdef VIRTUALBUTTONS_USE_SSE2
+    int vectorCount = count & ~3;
+    ProcessSSE2(pads, buttons, vectorCount);
+    ProcessScalar(pads + vectorCount, buttons + vectorCount, count - vectorCount);
+#else
+    ProcessScalar(pads, buttons, count);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// スカラー版
+//------------------------------------------------------------------------------
+void CVirtualButtons::ProcessScalar(const XINPUT_GAMEPAD* pads, DWORD* buttons, int count) const
+{
+    for (int i = 0; i < count; ++i)
+    {
+        float enter[VIRTUAL_SOURCE_COUNT];
+        float hold[VIRTUAL_SOURCE_COUNT];
+        ComputeSources(pads[i], enter, hold);
+
+        DWORD previous = buttons[i];
+        DWORD result = pads[i].wButtons;
+        for (int b = 0; b < m_count; ++b)
+        {
+            const VirtualButton& button = m_buttons[b];
+            bool held = (previous & button.bit) == button.bit;
+            if (held ? hold[button.source] > button.release : enter[button.source] > button.press)
+                result |= button.bit;
+        }
+        buttons[i] = result;
+    }
+}
+
+#ifdef VIRTUALBUTTONS_USE_SSE2
+//------------------------------------------------------------------------------
+// SSE2版（4台ずつ、count は4の倍数）
+// アナログ入力の値を4台分まとめて求め、表の1行ごとに4台分を一度に判定する
+//------------------------------------------------------------------------------
+void CVirtualButtons::ProcessSSE2(const XINPUT_GAMEPAD* pads, DWORD* buttons, int count) const
+{
+    const __m128 thumbScale = _mm_set1_ps(THUMB_SCALE);
+    const __m128 triggerScale = _mm_set1_ps(TRIGGER_SCALE);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 sectorEnter = _mm_set1_ps(SECTOR_ENTER);
+    const __m128 sectorHold = _mm_set1_ps(SECTOR_HOLD);
+
+    for (int i = 0; i < count; i += 4)
+    {
+        const XINPUT_GAMEPAD* p = pads + i;
+        __m128 enter[VIRTUAL_SOURCE_COUNT];
+        __m128 hold[VIRTUAL_SOURCE_COUNT];
+
+        enter[VIRTUAL_SOURCE_LEFT_TRIGGER] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_setr_epi32(
+            p[0].bLeftTrigger, p[1].bLeftTrigger, p[2].bLeftTrigger, p[3].bLeftTrigger)), triggerScale);
+        enter[VIRTUAL_SOURCE_RIGHT_TRIGGER] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_setr_epi32(
+            p[0].bRightTrigger, p[1].bRightTrigger, p[2].bRightTrigger, p[3].bRightTrigger)), triggerScale);
+        hold[VIRTUAL_SOURCE_LEFT_TRIGGER] = enter[VIRTUAL_SOURCE_LEFT_TRIGGER];
+        hold[VIRTUAL_SOURCE_RIGHT_TRIGGER] = enter[VIRTUAL_SOURCE_RIGHT_TRIGGER];
+
+        auto axis4 = [&](SHORT a, SHORT b, SHORT c, SHORT d) -> __m128
+        {
+            __m128 value = _mm_mul_ps(_mm_cvtepi32_ps(_mm_setr_epi32(a, b, c, d)), thumbScale);
+            return _mm_max_ps(_mm_min_ps(value, one), minusOne);
+        };
+        const __m128 stickX[2] =
+        {
+            axis4(p[0].sThumbLX, p[1].sThumbLX, p[2].sThumbLX, p[3].sThumbLX),
+            axis4(p[0].sThumbRX, p[1].sThumbRX, p[2].sThumbRX, p[3].sThumbRX),
+        };
+        const __m128 stickY[2] =
+        {
+            axis4(p[0].sThumbLY, p[1].sThumbLY, p[2].sThumbLY, p[3].sThumbLY),
+            axis4(p[0].sThumbRY, p[1].sThumbRY, p[2].sThumbRY, p[3].sThumbRY),
+        };
+
+        for (int stick = 0; stick < 2; ++stick)
+        {
+            __m128 x = stickX[stick];
+            __m128 y = stickY[stick];
+            __m128 magnitude = _mm_min_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y))), one);
+            __m128 absX = _mm_andnot_ps(signMask, x);
+            __m128 absY = _mm_andnot_ps(signMask, y);
+
+            // 左・右・上・下の順
+            const __m128 along[4] = { _mm_sub_ps(zero, x), x, y, _mm_sub_ps(zero, y) };
+            const __m128 across[4] = { absY, absY, absX, absX };
+            for (int dir = 0; dir < 4; ++dir)
+            {
+                int axis = VIRTUAL_SOURCE_LSTICK_LEFT + stick * 4 + dir;
+                enter[axis] = along[dir];
+                hold[axis] = along[dir];
+
+                int sector = VIRTUAL_SOURCE_LSTICK_8WAY_LEFT + stick * 4 + dir;
+                enter[sector] = _mm_and_ps(_mm_cmpgt_ps(along[dir], _mm_mul_ps(across[dir], sectorEnter)), magnitude);
+                hold[sector] = _mm_and_ps(_mm_cmpgt_ps(along[dir], _mm_mul_ps(across[dir], sectorHold)), magnitude);
+            }
+        }
+
+        // 表の1行ずつ、押しているパッドは hold と release、離しているパッドは enter と press で比べる
+        __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buttons + i));
+        __m128i result = _mm_setr_epi32(p[0].wButtons, p[1].wButtons, p[2].wButtons, p[3].wButtons);
+        for (int b = 0; b < m_count; ++b)
+        {
+            const VirtualButton& button = m_buttons[b];
+            __m128i bit = _mm_set1_epi32(static_cast<int>(button.bit));
+            __m128 held = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(previous, bit), bit));
+
+            __m128 value = _mm_or_ps(_mm_and_ps(held, hold[button.source]), _mm_andnot_ps(held, enter[button.source]));
+            __m128 threshold = _mm_or_ps(_mm_and_ps(held, _mm_set1_ps(button.release)), _mm_andnot_ps(held, _mm_set1_ps(button.press)));
+            __m128i on = _mm_castps_si128(_mm_cmpgt_ps(value, threshold));
+            result = _mm_or_si128(result, _mm_and_si128(on, bit));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(buttons + i), result);
+    }
+}
+#endif
@@ -0,0 +1,95 @@
+#pragma once
+#include <windows.h>
+#include <Xinput.h>
+#include "PadButtons.h"
+
+// 使用する SIMD 命令セットの選択（コンパイルオプションに従う）
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VIRTUALBUTTONS_USE_SSE2
+#endif
+
+//------------------------------------------------------------------------------
+// 仮想ボタンの元にするアナログ入力（値はすべて 0.0f ~ 1.0f、逆方向は負になる）
+//------------------------------------------------------------------------------
+enum VirtualButtonSource : BYTE
+{
+    VIRTUAL_SOURCE_LEFT_TRIGGER,        // 左トリガー
+    VIRTUAL_SOURCE_RIGHT_TRIGGER,       // 右トリガー
+
+    // スティックをその方向へ倒した量（軸ごと）
+    VIRTUAL_SOURCE_LSTICK_LEFT,
+    VIRTUAL_SOURCE_LSTICK_RIGHT,
+    VIRTUAL_SOURCE_LSTICK_UP,
+    VIRTUAL_SOURCE_LSTICK_DOWN,
+    VIRTUAL_SOURCE_RSTICK_LEFT,
+    VIRTUAL_SOURCE_RSTICK_RIGHT,
+    VIRTUAL_SOURCE_RSTICK_UP,
+    VIRTUAL_SOURCE_RSTICK_DOWN,
+
+    // スティックを倒した量（8方向の十字キー用）
+    // 倒した向きがその方向の ±67.5° の中にあるときだけ値を持つので、斜めは2つの方向が押される
+    VIRTUAL_SOURCE_LSTICK_8WAY_LEFT,
+    VIRTUAL_SOURCE_LSTICK_8WAY_RIGHT,
+    VIRTUAL_SOURCE_LSTICK_8WAY_UP,
+    VIRTUAL_SOURCE_LSTICK_8WAY_DOWN,
+    VIRTUAL_SOURCE_RSTICK_8WAY_LEFT,
+    VIRTUAL_SOURCE_RSTICK_8WAY_RIGHT,
+    VIRTUAL_SOURCE_RSTICK_8WAY_UP,
+    VIRTUAL_SOURCE_RSTICK_8WAY_DOWN,
+
+    VIRTUAL_SOURCE_COUNT
+};
+
+//------------------------------------------------------------------------------
+// VirtualButton
+// アナログ入力1つをボタンワードのビット1つにする設定
+// 押す・離すのしきい値を別にして、しきい値付近で押下と解放を繰り返さないようにする
+//------------------------------------------------------------------------------
+struct VirtualButton
+{
+    DWORD bit;          // 立てるボタンワードのビット（PAD_BIT_*）
+    BYTE source;        // VirtualButtonSource
+    float press;        // 離しているときは、これより大きくなったら押す
+    float release;      // 押しているときは、これ以下になったら離す（press より大きければ press にする）
+};
+
+//------------------------------------------------------------------------------
+// CVirtualButtons
+// 仮想ボタンの表を持ち、ゲームパッドの状態からボタンワードを作る
+// 前回のボタンワードで押している・離しているを見て、しきい値を選ぶ
+// Process は複数のゲームパッドを SSE2 で4台ずつまとめて処理する
+//------------------------------------------------------------------------------
+class CVirtualButtons
+{
+public:
+    static const int MAX_BUTTONS = 32;
+
+    // 既定の表（トリガー・両スティックの4方向・左スティックの8方向）
+    CVirtualButtons();
+
+    // 表を設定する（MAX_BUTTONS を超えた分と、source が範囲外のものは使わない）
+    void Configure(const VirtualButton* buttons, int count);
+    template<int N>
+    void Configure(const VirtualButton (&buttons)[N]) { Configure(buttons, N); }
+
+    // bit の仮想ボタンのしきい値だけを変える（表に無ければ false）
+    bool SetThresholds(DWORD bit, float press, float release);
+
+    int GetCount() const;
+    const VirtualButton& GetButton(int index) const;
+    DWORD GetMask() const;  // 表のすべてのビット
+
+    // count 台分のボタンワードを作る
+    // buttons は前回のボタンワードを入れて渡し、wButtons と仮想ボタンのビットで置き換えられる
+    void Process(const XINPUT_GAMEPAD* pads, DWORD* buttons, int count) const;
+
+private:
+    void ProcessScalar(const XINPUT_GAMEPAD* pads, DWORD* buttons, int count) const;
+#ifdef VIRTUALBUTTONS_USE_SSE2
+    void ProcessSSE2(const XINPUT_GAMEPAD* pads, DWORD* buttons, int count) const;
+#endif
+
+    VirtualButton m_buttons[MAX_BUTTONS];
+    int m_count;
+    DWORD m_mask;
+};
@@ -2,26 +2,68 @@
 #include "DirectX.h"
 #include "CInputManager.h"
 
+//--------------------------------------------------------------------------------------
+// ゲーム中のアクションと入力の割り当て
+//--------------------------------------------------------------------------------------
+// Update() では個々のキーやボタンを調べず、ここで割り当てたアクションの状態を読みます。
+// 割り当ては CInputManager::Update() の中で1回だけ評価されます。
+enum GameAction
+{
+    ACTION_MOVE_LEFT,       // 十字キー・キーボードでの移動
+    ACTION_MOVE_RIGHT,
+    ACTION_MOVE_UP,
+    ACTION_MOVE_DOWN,
+    ACTION_STICK_X,         // アナログスティックでの移動（-1.0f ~ 1.0f）
+    ACTION_STICK_Y,
+    ACTION_VIBRATE_LEFT,    // 振動（A/Bボタン）
+    ACTION_VIBRATE_RIGHT,
+};
+
+constexpr ActionBinding g_gameplayBindings[] =
+{
+    BindKey(ACTION_MOVE_LEFT, 'A'),
+    BindKey(ACTION_MOVE_RIGHT, 'D'),
+    BindKey(ACTION_MOVE_UP, 'W'),
+    BindKey(ACTION_MOVE_DOWN, 'S'),
+    BindPadButton(ACTION_MOVE_LEFT, XINPUT_GAMEPAD_DPAD_LEFT),
+    BindPadButton(ACTION_MOVE_RIGHT, XINPUT_GAMEPAD_DPAD_RIGHT),
+    BindPadButton(ACTION_MOVE_UP, XINPUT_GAMEPAD_DPAD_UP),
+    BindPadButton(ACTION_MOVE_DOWN, XINPUT_GAMEPAD_DPAD_DOWN),
+    BindPadAxis(ACTION_STICK_X, ACTION_AXIS_THUMB_LX),
+    BindPadAxis(ACTION_STICK_Y, ACTION_AXIS_THUMB_LY),
+    BindPadButton(ACTION_VIBRATE_LEFT, XINPUT_GAMEPAD_A),
+    BindPadButton(ACTION_VIBRATE_RIGHT, XINPUT_GAMEPAD_B),
+};
+
+// デバッグ表示するキーとパッドのボタン（表示の順）
+constexpr BYTE g_debugKeys[] = { 'A', 'D', 'W', 'S' };
+constexpr DWORD g_debugPadButtons[] =
+{
+    XINPUT_GAMEPAD_DPAD_LEFT, XINPUT_GAMEPAD_DPAD_RIGHT, XINPUT_GAMEPAD_DPAD_UP, XINPUT_GAMEPAD_DPAD_DOWN,
+    XINPUT_GAMEPAD_A, XINPUT_GAMEPAD_B, XINPUT_GAMEPAD_X, XINPUT_GAMEPAD_Y,
+    XINPUT_GAMEPAD_LEFT_SHOULDER, XINPUT_GAMEPAD_RIGHT_SHOULDER,
+};
 
 //--------------------------------------------------------------------------------------
 // DirectX11::DirectX11()関数：コンストラクタ
 //--------------------------------------------------------------------------------------
 // ここは DirectX11 クラスのコンストラクタです。
-// 現在は初期化処理をコンストラクタ内で行っておらず、InitDevice() で初期化します。
-// コンストラクタ自体は空で問題ない設計（リソース確保は InitDevice() 側）です。
+// デバイスの初期化は InitDevice() で行い、ここではゲーム中の入力の割り当てとデバッグ表示の項目を登録します。
 DirectX11::DirectX11()
 {
-
+    CInputManager::GetInstance().GetActionMap().PushContext(g_gameplayBindings);
+    SetupDebugOverlay();
 }
 
 //--------------------------------------------------------------------------------------
 // DirectX11::~DirectX11関数：デストラクタ
 //--------------------------------------------------------------------------------------
-// デストラクタも空です。ComPtr を使っているため、オブジェクト破棄時に自動で
-// COM リソースが解放されます。明示的な Release は不要です（設計上の簡潔化）。
+// 描画のスレッドが動いていれば、リソースを解放する前に止めて待ちます（SetPipelineDepth(0)）。
+// COM リソースは ComPtr を使っているため、オブジェクト破棄時に自動で解放されます。
+// 明示的な Release は不要です（設計上の簡潔化）。
 DirectX11::~DirectX11()
 {
-
+    SetPipelineDepth(0);
 }
 
 //--------------------------------------------------------------------------------------
@@ -33,8 +75,12 @@ DirectX11::~DirectX11()
 // この中で「デバイスの作成」「Direct2D デバイス/コンテキスト作成」
 // 「スワップチェーン作成」「バックバッファの Direct2D への紐付け」
 // 「レンダーターゲットビューの作成」「フォント・ブラシの作成」などを行います。
+// SetNullRenderer(true) のときは描画しないので、何も作らずに S_OK を返します。
 HRESULT DirectX11::InitDevice()
 {
+    if (m_nullRenderer)
+        return S_OK;
+
     //------------------------------------------------------------
     // DirectX11とDirect2D 1.1の初期化
     //------------------------------------------------------------
@@ -255,6 +301,11 @@ HRESULT DirectX11::InitDevice()
     if (FAILED(hr))
         return hr;
 
+    // デバッグ表示の行ごとのレイアウトを作るために DirectWrite のファクトリを渡しておく
+    hr = m_debugText.Init(DWriteFactory.Get(), m_DWriteTextFormat.Get(), 800, 20);
+    if (FAILED(hr))
+        return hr;
+
     // CreateSolidColorBrush() で使用するブラシ（文字色）を作る
     // D2D の ColorF で色指定（ここでは黒）
     hr = m_D2DDeviceContext->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Black), &m_D2DSolidBrush);//&m_D2DSolidBrush 初期化
@@ -266,122 +317,347 @@ HRESULT DirectX11::InitDevice()
 }
 
 //--------------------------------------------------------------------------------------
-// DirectX11::Render()：DirectX関係の描画
+// DirectX11::Update()：シミュレーションを1ティック進める
 //--------------------------------------------------------------------------------------
-// Render() は毎フレーム呼ばれる関数です。ここに描画処理、入力処理、UI 表示などを記述します。
-// このサンプルでは背景のクリア、円の描画、キーボード/ゲームパッド入力処理、テキスト描画、
-// ゲームパッド振動といった処理を行っています。
-void DirectX11::Render()
+// Update() は固定ティックごとに呼ばれる関数です（1フレームに0回のことも、複数回のこともあります）。
+// tickEnd までに起きた入力を反映し、円の移動と振動の設定を行います。
+// 1ティックの時間は Window::GetFrameTime() で取得でき、フレームレートによらず一定です。
+void DirectX11::Update(LONGLONG tickEnd)
 {
     auto& input = CInputManager::GetInstance(); // シングルトン取得
 
-    // 毎フレームの入力状態更新
-    input.Update();
-
-    // レンダーターゲットを塗りつぶす
-    m_D3DDeviceContext->ClearRenderTargetView(m_D3DRenderTargetView.Get(), DirectX::Colors::Aquamarine);
+    // このティックまでの入力状態更新
+    Window::BeginFramePhase(FRAME_SERIES_INPUT);
+    input.Update(tickEnd);
+    Window::BeginFramePhase(FRAME_SERIES_SIMULATION);
 
     //------------------------------------------------------------
-    // 初期設定（円の位置・半径・速度）
+    // アクション（Update で評価済み）
     //------------------------------------------------------------
-    static FLOAT fPosX1 = 200, fPosY1 = 300;
-    static FLOAT fRadius1 = 50;
-    static double dSpeed = 1.0;
-
-    //------------------------------------------------------------
-    // キー入力・ゲームパッド入力
-    //------------------------------------------------------------
-    bool keyA = input.IsKeyPress('A');
-    bool keyD = input.IsKeyPress('D');
-    bool keyW = input.IsKeyPress('W');
-    bool keyS = input.IsKeyPress('S');
-
-    // パッドボタン例（XINPUT_GAMEPAD_LEFT_SHOULDER 等）
-    bool padLeft = input.IsPadPress(XINPUT_GAMEPAD_DPAD_LEFT);
-    bool padRight = input.IsPadPress(XINPUT_GAMEPAD_DPAD_RIGHT);
-    bool padUp = input.IsPadPress(XINPUT_GAMEPAD_DPAD_UP);
-    bool padDown = input.IsPadPress(XINPUT_GAMEPAD_DPAD_DOWN);
-
-    bool padA = input.IsPadPress(XINPUT_GAMEPAD_A);
-    bool padB = input.IsPadPress(XINPUT_GAMEPAD_B);
-    bool padX = input.IsPadPress(XINPUT_GAMEPAD_X);
-    bool padY = input.IsPadPress(XINPUT_GAMEPAD_Y);
-    bool padL = input.IsPadPress(XINPUT_GAMEPAD_LEFT_SHOULDER);
-    bool padR = input.IsPadPress(XINPUT_GAMEPAD_RIGHT_SHOULDER);
-    BYTE padZR = input.GetRightTrigger();
-    BYTE padZL = input.GetLeftTrigger();
-
-    float fThumbLX = input.GetThumbLX();
-    float fThumbLY = input.GetThumbLY();
+    const CActionMap& actions = input.GetActionMap();
+    bool moveLeft = actions.IsPress(ACTION_MOVE_LEFT);
+    bool moveRight = actions.IsPress(ACTION_MOVE_RIGHT);
+    bool moveUp = actions.IsPress(ACTION_MOVE_UP);
+    bool moveDown = actions.IsPress(ACTION_MOVE_DOWN);
+    float fStickX = actions.GetValue(ACTION_STICK_X);
+    float fStickY = actions.GetValue(ACTION_STICK_Y);
 
     //------------------------------------------------------------
     // 円の移動処理
     //------------------------------------------------------------
-    if (fThumbLX != 0.0f || fThumbLY != 0.0f) // アナログスティック優先
+    // 描画で補間するため、動かす前の位置を残しておく
+    m_prevPosX = m_posX;
+    m_prevPosY = m_posY;
+
+    // 移動には記録・再生される入力（InputFrame の内容）だけを使います。
+    // マウスは記録されないので、ここで使うと -replay で同じ位置に戻らなくなります。
+    if (fStickX != 0.0f || fStickY != 0.0f) // アナログスティック優先
     {
-        fPosX1 += static_cast<FLOAT>(fThumbLX * Window::GetFrameTime() * dSpeed);
-        fPosY1 -= static_cast<FLOAT>(fThumbLY * Window::GetFrameTime() * dSpeed);
+        m_posX += static_cast<FLOAT>(fStickX * Window::GetFrameTime() * m_speed);
+        m_posY -= static_cast<FLOAT>(fStickY * Window::GetFrameTime() * m_speed);
     }
     else // キーボード or 十字キー
     {
         double dValue = 1;
-        if ((keyA || keyD || padLeft || padRight) &&
-            (keyW || keyS || padUp || padDown))
+        if ((moveLeft || moveRight) && (moveUp || moveDown))
         {
             dValue = 1 / sqrt(2); // 斜め補正
         }
 
-        if (keyA || padLeft)
-            fPosX1 -= static_cast<FLOAT>(Window::GetFrameTime() * dSpeed * dValue);
-        if (keyD || padRight)
-            fPosX1 += static_cast<FLOAT>(Window::GetFrameTime() * dSpeed * dValue);
-        if (keyW || padUp)
-            fPosY1 -= static_cast<FLOAT>(Window::GetFrameTime() * dSpeed * dValue);
-        if (keyS || padDown)
-            fPosY1 += static_cast<FLOAT>(Window::GetFrameTime() * dSpeed * dValue);
+        if (moveLeft)
+            m_posX -= static_cast<FLOAT>(Window::GetFrameTime() * m_speed * dValue);
+        if (moveRight)
+            m_posX += static_cast<FLOAT>(Window::GetFrameTime() * m_speed * dValue);
+        if (moveUp)
+            m_posY -= static_cast<FLOAT>(Window::GetFrameTime() * m_speed * dValue);
+        if (moveDown)
+            m_posY += static_cast<FLOAT>(Window::GetFrameTime() * m_speed * dValue);
     }
 
     // 画面端補正
-    fPosX1 = (fPosX1 < fRadius1) ? fRadius1 : (fPosX1 > Window::GetClientWidth() - fRadius1 ? Window::GetClientWidth() - fRadius1 : fPosX1);
-    fPosY1 = (fPosY1 < fRadius1) ? fRadius1 : (fPosY1 > Window::GetClientHeight() - fRadius1 ? Window::GetClientHeight() - fRadius1 : fPosY1);
+    m_posX = (m_posX < m_radius) ? m_radius : (m_posX > Window::GetClientWidth() - m_radius ? Window::GetClientWidth() - m_radius : m_posX);
+    m_posY = (m_posY < m_radius) ? m_radius : (m_posY > Window::GetClientHeight() - m_radius ? Window::GetClientHeight() - m_radius : m_posY);
 
 
     //------------------------------------------------------------
-    // 振動設定（A/Bボタンで左右振動）
+    // 振動設定（A/Bボタンを押している間、左右振動）
     //------------------------------------------------------------
-    WORD leftMotor = padA ? 65535 : 0;
-    WORD rightMotor = padB ? 65535 : 0;
-    input.SetVibration(leftMotor, rightMotor);
+    // 押した瞬間・離した瞬間だけ設定する（設定した強さは次に設定するまで続く）
+    if (actions.IsTrigger(ACTION_VIBRATE_LEFT) || actions.IsRelease(ACTION_VIBRATE_LEFT) ||
+        actions.IsTrigger(ACTION_VIBRATE_RIGHT) || actions.IsRelease(ACTION_VIBRATE_RIGHT))
+    {
+        WORD leftMotor = actions.IsPress(ACTION_VIBRATE_LEFT) ? 65535 : 0;
+        WORD rightMotor = actions.IsPress(ACTION_VIBRATE_RIGHT) ? 65535 : 0;
+        input.SetVibration(leftMotor, rightMotor);
+    }
 
-    //------------------------------------------------------------
-    // デバッグ文字列
-    //------------------------------------------------------------
-    WCHAR wcText1[256] = {};
-    swprintf(wcText1, 256, L"FPS=%lf", Window::GetFps());
+    Window::EndFramePhase();
+}
 
-    WCHAR wcText2[256] = {};
-    swprintf(wcText2, 256, L"A=%d D=%d W=%d S=%d", keyA, keyD, keyW, keyS);
+//--------------------------------------------------------------------------------------
+// DirectX11::Render()：DirectX関係の描画
+//--------------------------------------------------------------------------------------
+// Render() は毎フレーム呼ばれる関数です。描画に必要な値を RenderPacket にまとめ、Draw() で描きます。
+// SetPipelineDepth() で描画のスレッドを動かしている場合は、パケットを渡すだけで戻ります
+// （描画が depth フレームより遅れていれば、1つ描き終わるまでここで待ちます）。
+// 円は1つ前のティックと最後のティックの位置を alpha（0.0f ~ 1.0f）で補間した位置に描きます。
+void DirectX11::Render(float alpha)
+{
+    auto& input = CInputManager::GetInstance(); // シングルトン取得
 
-    WCHAR wcText3[256] = {};
-    swprintf(wcText3, 256, L"PAD_LEFT=%d PAD_RIGHT=%d PAD_UP=%d PAD_DOWN=%d", padLeft, padRight, padUp, padDown);
+    // 描画のスレッドが Present したフレームの入力を、画面に出たものとして記録する
+    PresentRecord presented;
+    while (m_presented.Pop(presented))
+        input.MarkPresent(presented.frame, presented.time);
 
-    WCHAR wcText4[256] = {};
-    swprintf(wcText4, 256, L"PAD_A=%d PAD_B=%d PAD_X=%d PAD_Y=%d PAD_L=%d PAD_R=%d\n\n PAD_ZL=%d PAD_ZR=%d", padA, padB, padX, padY, padL, padR, padZL, padZR);
+    // 別スレッドで描く場合は、パケットを作って渡すまで（待った時間を含む）を計測する
+    Window::BeginFramePhase(FRAME_SERIES_RENDER);
 
-    WCHAR wcText5[256] = {};
-    swprintf(wcText5, 256, L"sThumbLX=%f sThumbLY=%f", fThumbLX, fThumbLY);
+    if (m_renderThread.joinable())
+    {
+        RenderPacket* packet = m_pipeline.BeginWrite();
+        if (packet)
+        {
+            BuildPacket(*packet, alpha);
+            m_pipeline.EndWrite();
+        }
+    }
+    else
+    {
+        BuildPacket(m_packet, alpha);
+        Draw(m_packet);
+        input.MarkPresent(m_packet.inputFrame); // このフレームの入力が画面に出るまでの時間を記録
+    }
+
+    Window::EndFramePhase();
+
+    // 描画しない場合は、FPS とフレーム間隔をタイトルに出す（約1秒に1回）
+    if (m_nullRenderer && ++m_titleCount >= 60)
+    {
+        m_titleCount = 0;
+        FrameStatsSummary interval = Window::GetFrameStats().GetSummary(FRAME_SERIES_INTERVAL, FRAME_WINDOW_SHORT);
+        WCHAR title[128];
+        swprintf_s(title, L"FPS=%.1f p50=%.2fms p99=%.2fms max=%.2fms",
+            Window::GetFps(), interval.p50Ms, interval.p99Ms, interval.maxMs);
+        SetWindowTextW(Window::GethWnd(), title);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// DirectX11::BuildPacket()：描画に必要な値を集める（ゲームのスレッド）
+//--------------------------------------------------------------------------------------
+void DirectX11::BuildPacket(RenderPacket& packet, float alpha) const
+{
+    auto& input = CInputManager::GetInstance(); // シングルトン取得
+
+    packet.inputFrame = input.GetFrameCount();
+    packet.posX = m_prevPosX + (m_posX - m_prevPosX) * alpha;
+    packet.posY = m_prevPosY + (m_posY - m_prevPosY) * alpha;
+    packet.radius = m_radius;
+    packet.fps = Window::GetFps();
+
+    //------------------------------------------------------------
+    // キー入力・ゲームパッド入力（デバッグ表示用、最後のティックの状態）
+    //------------------------------------------------------------
+    // 表示するキー・ボタンはまとめて調べる（bit i = 一覧の i 番目）
+    packet.keys = input.QueryKeys(g_debugKeys).press;
+    packet.padButtons = input.QueryPadButtons(g_debugPadButtons).press;
+    packet.padTriggers[0] = input.GetLeftTrigger();
+    packet.padTriggers[1] = input.GetRightTrigger();
+
+    packet.thumbs[0] = input.GetThumbLX();
+    packet.thumbs[1] = input.GetThumbLY();
+    packet.thumbs[2] = input.GetThumbRX();
+    packet.thumbs[3] = input.GetThumbRY();
+
+    packet.interval = Window::GetFrameStats().GetSummary(FRAME_SERIES_INTERVAL, FRAME_WINDOW_SHORT);
+    packet.latency = input.GetLatency().GetSummary(INPUT_LATENCY_ALL);
+}
+
+//--------------------------------------------------------------------------------------
+// DirectX11::Draw()：パケットの値で描く（描画のスレッド、または Render() から）
+//--------------------------------------------------------------------------------------
+// デバッグ表示は値が変わった行だけ整形し直します。
+void DirectX11::Draw(const RenderPacket& packet)
+{
+    const DebugFields& f = m_debugFields;
+    m_debugOverlay.SetFps(f.fps, packet.fps);
+
+    for (int i = 0; i < static_cast<int>(ARRAYSIZE(g_debugKeys)); ++i)
+        m_debugOverlay.SetBool(f.keys[i], ((packet.keys >> i) & 1) != 0);
+    for (int i = 0; i < static_cast<int>(ARRAYSIZE(g_debugPadButtons)); ++i)
+        m_debugOverlay.SetBool(f.padButtons[i], ((packet.padButtons >> i) & 1) != 0);
+    for (int i = 0; i < static_cast<int>(ARRAYSIZE(packet.padTriggers)); ++i)
+        m_debugOverlay.SetCounter(f.padTriggers[i], packet.padTriggers[i]);
+    for (int i = 0; i < static_cast<int>(ARRAYSIZE(packet.thumbs)); ++i)
+        m_debugOverlay.SetFloat(f.thumbs[i], packet.thumbs[i]);
+
+    // 直近60フレームの間隔（平均では見えない引っかかりを p99・最大で見る）
+    const FrameStatsSummary& interval = packet.interval;
+    m_debugOverlay.SetFloat(f.frame[0], interval.p50Ms);
+    m_debugOverlay.SetFloat(f.frame[1], interval.p90Ms);
+    m_debugOverlay.SetFloat(f.frame[2], interval.p99Ms);
+    m_debugOverlay.SetFloat(f.frame[3], interval.p999Ms);
+    m_debugOverlay.SetFloat(f.frame[4], interval.maxMs);
+
+    // 入力の変化から Present までの時間（起動してから全部）
+    const FrameStatsSummary& latency = packet.latency;
+    m_debugOverlay.SetCounter(f.latencyCount, latency.count);
+    m_debugOverlay.SetFloat(f.latency[0], latency.p50Ms);
+    m_debugOverlay.SetFloat(f.latency[1], latency.p99Ms);
+    m_debugOverlay.SetFloat(f.latency[2], latency.maxMs);
+
+    if (m_nullRenderer)
+    {
+        m_debugOverlay.Flush(m_nullText);
+        return;
+    }
+    m_debugOverlay.Flush(m_debugText);
 
     //------------------------------------------------------------
     // 2D描画
     //------------------------------------------------------------
+    // レンダーターゲットを塗りつぶす
+    m_D3DDeviceContext->ClearRenderTargetView(m_D3DRenderTargetView.Get(), DirectX::Colors::Aquamarine);
+
     m_D2DDeviceContext->BeginDraw();
-    m_D2DDeviceContext->DrawEllipse(D2D1::Ellipse(D2D1::Point2F(fPosX1, fPosY1), fRadius1, fRadius1), m_D2DSolidBrush.Get(), 1);
-    m_D2DDeviceContext->DrawText(wcText1, ARRAYSIZE(wcText1) - 1, m_DWriteTextFormat.Get(), D2D1::RectF(0, 0, 800, 20), m_D2DSolidBrush.Get());
-    m_D2DDeviceContext->DrawText(wcText2, ARRAYSIZE(wcText2) - 1, m_DWriteTextFormat.Get(), D2D1::RectF(0, 20, 800, 40), m_D2DSolidBrush.Get());
-    m_D2DDeviceContext->DrawText(wcText3, ARRAYSIZE(wcText3) - 1, m_DWriteTextFormat.Get(), D2D1::RectF(0, 40, 800, 60), m_D2DSolidBrush.Get());
-    m_D2DDeviceContext->DrawText(wcText4, ARRAYSIZE(wcText4) - 1, m_DWriteTextFormat.Get(), D2D1::RectF(0, 60, 800, 80), m_D2DSolidBrush.Get());
-    m_D2DDeviceContext->DrawText(wcText5, ARRAYSIZE(wcText5) - 1, m_DWriteTextFormat.Get(), D2D1::RectF(0, 80, 800, 100), m_D2DSolidBrush.Get());
+    m_D2DDeviceContext->DrawEllipse(D2D1::Ellipse(D2D1::Point2F(packet.posX, packet.posY), packet.radius, packet.radius), m_D2DSolidBrush.Get(), 1);
+    m_debugText.Draw(m_D2DDeviceContext.Get(), m_D2DSolidBrush.Get());
     m_D2DDeviceContext->EndDraw();
 
     m_DXGISwapChain1->Present(0, 0);
 }
+
+//--------------------------------------------------------------------------------------
+// DirectX11::RenderThreadMain()：描画のスレッド
+//--------------------------------------------------------------------------------------
+// パケットを受け取っては描き、Present した時刻をゲームのスレッドへ返します。
+// 止めるときは、受け取り済みのパケットを描き切ってから終わります。
+void DirectX11::RenderThreadMain()
+{
+    const RenderPacket* packet;
+    while ((packet = m_pipeline.BeginRead()) != nullptr)
+    {
+        Draw(*packet);
+        PresentRecord presented = { packet->inputFrame, GetInputTimestamp() };
+        m_pipeline.EndRead();
+        m_presented.Push(presented); // 溢れたら記録しない（計測用なので描画は止めない）
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// DirectX11::SetPipelineDepth()：描画のスレッドの開始・停止
+//--------------------------------------------------------------------------------------
+void DirectX11::SetPipelineDepth(int depth)
+{
+    if (m_renderThread.joinable())
+    {
+        m_pipeline.Stop();
+        m_renderThread.join();
+    }
+    if (depth <= 0)
+        return;
+
+    m_pipeline.Reset(depth);
+    m_renderThread = std::thread(&DirectX11::RenderThreadMain, this);
+}
+
+int DirectX11::GetPipelineDepth() const
+{
+    return m_renderThread.joinable() ? m_pipeline.GetDepth() : 0;
+}
+
+void DirectX11::SetNullRenderer(bool enable)
+{
+    m_nullRenderer = enable;
+}
+
+void DirectX11::GetPosition(FLOAT& x, FLOAT& y) const
+{
+    x = m_posX;
+    y = m_posY;
+}
+
+//--------------------------------------------------------------------------------------
+// DirectX11::SetupDebugOverlay()：デバッグ表示の項目の登録
+//--------------------------------------------------------------------------------------
+// 1行ずつ 見出し と 値の種類 を並べて登録します。値は Render() で毎フレーム設定しますが、
+// 表示が変わった行だけが整形し直され、レイアウトも作り直されます。
+void DirectX11::SetupDebugOverlay()
+{
+    CDebugOverlay& o = m_debugOverlay;
+    DebugFields& f = m_debugFields;
+
+    int line = o.AddLine();
+    f.fps = o.AddFps(line, L"FPS=");
+
+    line = o.AddLine();
+    f.keys[0] = o.AddBool(line, L"A=");
+    f.keys[1] = o.AddBool(line, L" D=");
+    f.keys[2] = o.AddBool(line, L" W=");
+    f.keys[3] = o.AddBool(line, L" S=");
+
+    line = o.AddLine();
+    f.padButtons[0] = o.AddBool(line, L"PAD_LEFT=");
+    f.padButtons[1] = o.AddBool(line, L" PAD_RIGHT=");
+    f.padButtons[2] = o.AddBool(line, L" PAD_UP=");
+    f.padButtons[3] = o.AddBool(line, L" PAD_DOWN=");
+
+    line = o.AddLine();
+    f.padButtons[4] = o.AddBool(line, L"PAD_A=");
+    f.padButtons[5] = o.AddBool(line, L" PAD_B=");
+    f.padButtons[6] = o.AddBool(line, L" PAD_X=");
+    f.padButtons[7] = o.AddBool(line, L" PAD_Y=");
+    f.padButtons[8] = o.AddBool(line, L" PAD_L=");
+    f.padButtons[9] = o.AddBool(line, L" PAD_R=");
+    f.padTriggers[0] = o.AddCounter(line, L" PAD_ZL=");
+    f.padTriggers[1] = o.AddCounter(line, L" PAD_ZR=");
+
+    line = o.AddLine();
+    f.thumbs[0] = o.AddFloat(line, L"sThumbLX=", 3);
+    f.thumbs[1] = o.AddFloat(line, L" sThumbLY=", 3);
+    f.thumbs[2] = o.AddFloat(line, L" sThumbRX=", 3);
+    f.thumbs[3] = o.AddFloat(line, L" sThumbRY=", 3);
+
+    line = o.AddLine();
+    f.frame[0] = o.AddFloat(line, L"FRAME p50=", 2, L"ms");
+    f.frame[1] = o.AddFloat(line, L" p90=", 2, L"ms");
+    f.frame[2] = o.AddFloat(line, L" p99=", 2, L"ms");
+    f.frame[3] = o.AddFloat(line, L" p99.9=", 2, L"ms");
+    f.frame[4] = o.AddFloat(line, L" max=", 2, L"ms");
+
+    line = o.AddLine();
+    f.latencyCount = o.AddCounter(line, L"LATENCY n=");
+    f.latency[0] = o.AddFloat(line, L" p50=", 2, L"ms");
+    f.latency[1] = o.AddFloat(line, L" p99=", 2, L"ms");
+    f.latency[2] = o.AddFloat(line, L" max=", 2, L"ms");
+}
+
+//--------------------------------------------------------------------------------------
+// CDWriteDebugTextSink：デバッグ表示の行ごとのレイアウト
+//--------------------------------------------------------------------------------------
+HRESULT CDWriteDebugTextSink::Init(IDWriteFactory* factory, IDWriteTextFormat* format, FLOAT width, FLOAT lineHeight)
+{
+    m_factory = factory;
+    m_format = format;
+    m_width = width;
+    m_lineHeight = lineHeight;
+    return (factory && format) ? S_OK : E_INVALIDARG;
+}
+
+// 文字列が変わった行のレイアウトだけを作り直す（文字数は実際の長さを渡す）
+void CDWriteDebugTextSink::SetLine(int line, const WCHAR* text, int length)
+{
+    m_layouts[line].Reset();
+    if (m_factory)
+        m_factory->CreateTextLayout(text, static_cast<UINT32>(length), m_format.Get(), m_width, m_lineHeight, &m_layouts[line]);
+}
+
+void CDWriteDebugTextSink::Draw(ID2D1DeviceContext* context, ID2D1Brush* brush) const
+{
+    for (int i = 0; i < CDebugOverlay::MAX_LINES; ++i)
+    {
+        if (m_layouts[i])
+            context->DrawTextLayout(D2D1::Point2F(0, i * m_lineHeight), m_layouts[i].Get(), brush);
+    }
+}
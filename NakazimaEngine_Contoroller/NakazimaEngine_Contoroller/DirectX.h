@@ -12,6 +12,47 @@
 #include <wrl/client.h>
 #include <random>
 #include <xinput.h>//---★追加---
+#include <thread>
+#include "CDebugOverlay.h"
+#include "CFrameStats.h"
+#include "CFramePipeline.h"
+#include "CSpscRing.h"
+
+//--------------------------------------------------------------------------------------
+// CDWriteDebugTextSinkクラス：デバッグ表示の行ごとのレイアウトを保持して描画する
+//--------------------------------------------------------------------------------------
+// レイアウトは行の文字列が変わったときだけ作り直し、それ以外のフレームは使い回す
+class CDWriteDebugTextSink : public IDebugTextSink
+{
+public:
+    HRESULT Init(IDWriteFactory* factory, IDWriteTextFormat* format, FLOAT width, FLOAT lineHeight);
+    void SetLine(int line, const WCHAR* text, int length) override;
+    void Draw(ID2D1DeviceContext* context, ID2D1Brush* brush) const;
+private:
+    Microsoft::WRL::ComPtr<IDWriteFactory> m_factory;
+    Microsoft::WRL::ComPtr<IDWriteTextFormat> m_format;
+    Microsoft::WRL::ComPtr<IDWriteTextLayout> m_layouts[CDebugOverlay::MAX_LINES];
+    FLOAT m_width = 0;
+    FLOAT m_lineHeight = 0;
+};
+
+//--------------------------------------------------------------------------------------
+// RenderPacket構造体：1フレームの描画に必要な値（ゲームのスレッドで作り、描画のスレッドで描く）
+//--------------------------------------------------------------------------------------
+// 描画側は入力やシミュレーションの状態を直接読まず、このパケットの値だけで描く
+struct RenderPacket
+{
+    DWORD inputFrame;               // 反映した入力のフレーム番号（MarkPresent に渡す）
+    FLOAT posX, posY;               // 円の位置（ティックの間を補間済み）
+    FLOAT radius;
+    double fps;
+    DWORD keys;                     // 表示するキーが押されているか（bit i = 一覧の i 番目）
+    DWORD padButtons;               // 表示するパッドのボタンが押されているか
+    BYTE padTriggers[2];            // ZL ZR
+    float thumbs[4];                // LX LY RX RY
+    FrameStatsSummary interval;     // 直近のフレーム間隔
+    FrameStatsSummary latency;      // 入力から Present まで
+};
 
 //--------------------------------------------------------------------------------------
 // DirectX11クラス：DirectX関係
@@ -22,7 +63,19 @@ public:
     DirectX11();
     ~DirectX11();
     HRESULT InitDevice();
-    void Render();
+    void Update(LONGLONG tickEnd);
+    void Render(float alpha);
+
+    // 描画（表示の整形・Direct2D の描画・Present）を別のスレッドで行う
+    // depth = 描いているフレームより何フレーム先までゲーム側を進めるか（1 ~ 3、0 で同じスレッドに戻す）
+    void SetPipelineDepth(int depth);
+    int GetPipelineDepth() const;
+
+    // Direct3D / Direct2D を使わずに描いたことにする（InitDevice の前に設定、ゲーム側の処理量の計測用）
+    void SetNullRenderer(bool enable);
+
+    // 最後のティックの円の位置（再生の結果を比べる用）
+    void GetPosition(FLOAT& x, FLOAT& y) const;
 private:
     //------------------------------------------------------------
     // DirectX11とDirect2D 1.1の初期化
@@ -38,4 +91,55 @@ private:
     //------------------------------------------------------------
     Microsoft::WRL::ComPtr<IDWriteTextFormat> m_DWriteTextFormat;
     Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> m_D2DSolidBrush;
+
+    //------------------------------------------------------------
+    // シミュレーションの状態（円の位置・半径・速度）
+    //------------------------------------------------------------
+    FLOAT m_posX = 200, m_posY = 300;           // 最後のティックの位置
+    FLOAT m_prevPosX = 200, m_prevPosY = 300;   // 1つ前のティックの位置（描画の補間用）
+    FLOAT m_radius = 50;
+    double m_speed = 1.0;
+
+    //------------------------------------------------------------
+    // 描画のパイプライン
+    //------------------------------------------------------------
+    void BuildPacket(RenderPacket& packet, float alpha) const;
+    void Draw(const RenderPacket& packet);
+    void RenderThreadMain();
+
+    // 描画のスレッドが Present したフレーム（ゲームのスレッドで MarkPresent する）
+    struct PresentRecord
+    {
+        DWORD frame;
+        LONGLONG time;
+    };
+
+    CFramePipeline<RenderPacket> m_pipeline;
+    std::thread m_renderThread;
+    CSpscRing<PresentRecord, 16> m_presented;
+    RenderPacket m_packet = {};             // 同じスレッドで描くときのパケット
+    bool m_nullRenderer = false;
+    int m_titleCount = 0;                   // 描画しないとき、タイトルを更新するまでのフレーム数
+
+    //------------------------------------------------------------
+    // デバッグ表示
+    //------------------------------------------------------------
+    void SetupDebugOverlay();
+
+    struct DebugFields
+    {
+        int fps;
+        int keys[4];            // A D W S
+        int padButtons[10];     // 十字キー 左 右 上 下、A B X Y L R
+        int padTriggers[2];     // ZL ZR
+        int thumbs[4];          // LX LY RX RY
+        int frame[5];           // フレーム間隔 p50 p90 p99 p99.9 最大
+        int latencyCount;
+        int latency[3];         // 入力から Present まで p50 p99 最大
+    };
+
+    CDebugOverlay m_debugOverlay;
+    CDWriteDebugTextSink m_debugText;
+    CNullDebugTextSink m_nullText;          // 描画しないときの表示の受け取り先
+    DebugFields m_debugFields;
 };
@@ -0,0 +1,72 @@
+#pragma once
+#include <windows.h>
+#include <Xinput.h>
+#include "CKeyBitset.h"
+#include "CInputRecording.h"
+#include "PadButtons.h"
+
+// 使用する SIMD 命令セットの選択（コンパイルオプションに従う）
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INPUTLANES_USE_SSE2
+#endif
+
+//------------------------------------------------------------------------------
+// 入力のレーン
+// キーとゲームパッドのボタンを1本の番号に並べたもの（入力ごとの配列の添字に使う）
+//   レーン 0 ~ 255           : キー（仮想キーコード）
+//   レーン 256 + pad * 32 + b : パッド pad のボタンワード（仮想ボタンを含む）の bit b
+//------------------------------------------------------------------------------
+const int INPUT_KEY_LANE_COUNT = CKeyBitset::KEY_COUNT;
+const int INPUT_PAD_LANE_COUNT = 32;
+const int INPUT_LANE_COUNT = INPUT_KEY_LANE_COUNT + INPUT_PAD_LANE_COUNT * XUSER_MAX_COUNT;
+const int INPUT_LANE_WORD_COUNT = INPUT_LANE_COUNT / 64;
+
+// レーン番号（button は複数立っていたら最下位のビット）
+inline int GetKeyLane(int key)
+{
+    return key;
+}
+
+inline int GetPadLane(DWORD button, int pad)
+{
+    return INPUT_KEY_LANE_COUNT + pad * INPUT_PAD_LANE_COUNT + CountTrailingZeros64(button);
+}
+
+//------------------------------------------------------------------------------
+// InputLaneBits
+// 全レーン分のビット列（キー 4語 + パッド2台ずつ 2語）
+//------------------------------------------------------------------------------
+struct InputLaneBits
+{
+    uint64_t word[INPUT_LANE_WORD_COUNT];
+
+    void Clear()
+    {
+        for (int i = 0; i < INPUT_LANE_WORD_COUNT; ++i)
+            word[i] = 0;
+    }
+
+    bool Test(int lane) const
+    {
+        return ((word[lane >> 6] >> (lane & 63)) & 1) != 0;
+    }
+
+    // キーのビットセットとパッドのボタンワード（XUSER_MAX_COUNT 個）からまとめる
+    void Pack(const CKeyBitset& keys, const DWORD* pads)
+    {
+        for (int i = 0; i < CKeyBitset::WORD_COUNT; ++i)
+            word[i] = keys.word[i];
+        for (int i = 0; i < XUSER_MAX_COUNT / 2; ++i)
+            word[CKeyBitset::WORD_COUNT + i] = pads[i * 2] | (static_cast<uint64_t>(pads[i * 2 + 1]) << 32);
+    }
+};
+
+//------------------------------------------------------------------------------
+// フレームの結果から、押されている・押された瞬間・離された瞬間のレーンを取り出す
+//------------------------------------------------------------------------------
+inline void PackInputLanes(const InputFrame& frame, InputLaneBits& press, InputLaneBits& trigger, InputLaneBits& release)
+{
+    press.Pack(frame.keys, frame.padButtons);
+    trigger.Pack(frame.keyTrigger, frame.padTrigger);
+    release.Pack(frame.keyRelease, frame.padRelease);
+}
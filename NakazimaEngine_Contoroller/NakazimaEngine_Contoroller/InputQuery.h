@@ -0,0 +1,59 @@
+#pragma once
+#include <windows.h>
+#include "CKeyBitset.h"
+
+//------------------------------------------------------------------------------
+// InputQueryMasks
+// 複数のキー・ボタンをまとめて調べた結果
+// bit i = 渡した一覧の i 番目（一覧は最大 INPUT_QUERY_MAX_COUNT 個）
+//------------------------------------------------------------------------------
+const int INPUT_QUERY_MAX_COUNT = 32;
+
+struct InputQueryMasks
+{
+    DWORD press;    // 押されている
+    DWORD trigger;  // 押された瞬間
+    DWORD release;  // 離された瞬間
+};
+
+//------------------------------------------------------------------------------
+// キーの一覧をまとめて調べる
+// 一覧は constexpr の配列にしておける（例：constexpr BYTE MOVE_KEYS[] = { 'A', 'D', 'W', 'S' };）
+//------------------------------------------------------------------------------
+inline InputQueryMasks QueryKeyMasks(const CKeyBitset& press, const CKeyBitset& trigger, const CKeyBitset& release,
+    const BYTE* keys, int count)
+{
+    InputQueryMasks masks = { 0, 0, 0 };
+    if (count > INPUT_QUERY_MAX_COUNT)
+        count = INPUT_QUERY_MAX_COUNT;
+
+    // 分岐せずに各ビットを取り出して並べる
+    for (int i = 0; i < count; ++i)
+    {
+        int word = keys[i] >> 6;
+        int bit = keys[i] & 63;
+        masks.press |= static_cast<DWORD>((press.word[word] >> bit) & 1) << i;
+        masks.trigger |= static_cast<DWORD>((trigger.word[word] >> bit) & 1) << i;
+        masks.release |= static_cast<DWORD>((release.word[word] >> bit) & 1) << i;
+    }
+    return masks;
+}
+
+//------------------------------------------------------------------------------
+// ゲームパッドのボタンの一覧をまとめて調べる
+// buttons[i] はボタンのビット（複数立てるとどれか1つでも押されていれば立つ）
+//------------------------------------------------------------------------------
+inline InputQueryMasks QueryPadMasks(DWORD press, DWORD trigger, DWORD release, const DWORD* buttons, int count)
+{
+    InputQueryMasks masks = { 0, 0, 0 };
+    if (count > INPUT_QUERY_MAX_COUNT)
+        count = INPUT_QUERY_MAX_COUNT;
+
+    for (int i = 0; i < count; ++i)
+    {
+        masks.press |= static_cast<DWORD>((press & buttons[i]) != 0) << i;
+        masks.trigger |= static_cast<DWORD>((trigger & buttons[i]) != 0) << i;
+        masks.release |= static_cast<DWORD>((release & buttons[i]) != 0) << i;
+    }
+    return masks;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <windows.h>
+#include <Xinput.h>
+#include "CInputRecording.h"
+#include "PadButtons.h"
+
+//------------------------------------------------------------------------------
+// InputSnapshot
+// Update 1回分の入力を、ほかのスレッドから読めるように写したもの
+// 読み出した後は読んだスレッドだけのものなので、ロックなしで何度でも調べられる
+//------------------------------------------------------------------------------
+struct InputSnapshot
+{
+    DWORD frame;            // Update のフレーム番号（CInputManager::GetFrameCount の値）
+    LONGLONG timestamp;     // 公開した時刻（GetInputTimestamp の値）
+    InputFrame input;
+
+    //--------------------------------------
+    // キーボード
+    //--------------------------------------
+    bool IsKeyPress(int key) const { return input.keys.Test(key); }
+    bool IsKeyTrigger(int key) const { return input.keyTrigger.Test(key); }
+    bool IsKeyRelease(int key) const { return input.keyRelease.Test(key); }
+
+    //--------------------------------------
+    // ゲームパッド（button はボタンワードのビット、仮想ボタンも使える）
+    //--------------------------------------
+    bool IsPadConnected(int pad) const { return (input.connectedMask & (1 << pad)) != 0; }
+    bool IsPadPress(DWORD button, int pad = 0) const { return (input.padButtons[pad] & button) != 0; }
+    bool IsPadTrigger(DWORD button, int pad = 0) const { return (input.padTrigger[pad] & button) != 0; }
+    bool IsPadRelease(DWORD button, int pad = 0) const { return (input.padRelease[pad] & button) != 0; }
+
+    float GetThumbLX(int pad = 0) const { return input.thumbs[pad][0]; }
+    float GetThumbLY(int pad = 0) const { return input.thumbs[pad][1]; }
+    float GetThumbRX(int pad = 0) const { return input.thumbs[pad][2]; }
+    float GetThumbRY(int pad = 0) const { return input.thumbs[pad][3]; }
+
+    BYTE GetLeftTrigger(int pad = 0) const { return input.pads[pad].bLeftTrigger; }
+    BYTE GetRightTrigger(int pad = 0) const { return input.pads[pad].bRightTrigger; }
+};
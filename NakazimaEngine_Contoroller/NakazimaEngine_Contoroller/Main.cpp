@@ -1,5 +1,8 @@
 #include "Main.h"
 #include "DirectX.h"
+#include "CInputManager.h"
+#include "CSelfTest.h"
+#include <climits>
 
 //--------------------------------------------------------------------------------------
 // 静的メンバ
@@ -9,11 +12,13 @@ int Window::g_iClientWidth = 800;//クライアント領域の横幅
 int Window::g_iClientHeight = 600;//クライアント領域の高さ
 double Window::g_dFps = 0;//FPS
 double Window::g_dFrameTime = 0;//1フレームあたりの時間
+CFrameStats Window::g_frameStats;//フレームの時間の統計
 
 //--------------------------------------------------------------------------------------
 // 前方宣言
 //--------------------------------------------------------------------------------------
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
+static int RunReplay(const wchar_t* args);
 
 //--------------------------------------------------------------------------------------
 // wWinMain()関数：エントリーポイント
@@ -23,6 +28,27 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     if (FAILED(CoInitialize(nullptr)))//COMの初期化
         return 0;
 
+    // 自己テスト・計測（ウィンドウを作らずに実行して終わる）
+    //   -selftest : 検証を実行し、結果を selftest.txt に書く（失敗した数を終了コードで返す）
+    //   -bench    : 計測を実行し、結果を bench.txt に書く
+    bool selfTest = wcsstr(lpCmdLine, L"-selftest") != nullptr;
+    if (selfTest || wcsstr(lpCmdLine, L"-bench") != nullptr)
+    {
+        int failed = selfTest ? CSelfTest::RunAll(false, L"selftest.txt") : CSelfTest::RunAll(true, L"bench.txt");
+        CoUninitialize();
+        return failed;
+    }
+
+    //   -replay <file> : 記録した入力を描画も待機もせずに最後まで再生し、ティック数/秒を replay.txt に書く
+    //                    （-nullrender と同じく描画しない、ウィンドウも作らない）
+    const wchar_t* replay = wcsstr(lpCmdLine, L"-replay");
+    if (replay)
+    {
+        int result = RunReplay(replay + wcslen(L"-replay"));
+        CoUninitialize();
+        return result;
+    }
+
     Window win;
 
     if (FAILED(win.InitWindow(hInstance, nCmdShow)))
@@ -30,32 +56,61 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 
     DirectX11 dx;
 
+    // コマンドライン
+    //   -nullrender  : 描画しない（ゲーム側の処理量の計測用、FPS はタイトルに出す）
+    //   -pipeline N  : 描画を別のスレッドで行い、N フレーム先までゲーム側を進める（1 ~ 3）
+    dx.SetNullRenderer(wcsstr(lpCmdLine, L"-nullrender") != nullptr);
+
     if (FAILED(dx.InitDevice()))
         return 0;
 
+    const wchar_t* pipeline = wcsstr(lpCmdLine, L"-pipeline");
+    if (pipeline)
+    {
+        int depth = _wtoi(pipeline + wcslen(L"-pipeline"));
+        dx.SetPipelineDepth(depth > 0 ? depth : 1);
+    }
+
     win.InitFps();
 
     // メインメッセージループ
     MSG msg = { 0 };
     while (WM_QUIT != msg.message)
     {
-        if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+        // 溜まっているメッセージをすべて処理してから1フレーム進める
+        // （1つずつ処理すると、入力が多いときにフレームの開始が遅れる）
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
         {
+            if (msg.message == WM_QUIT)
+                break;
             TranslateMessage(&msg);
             DispatchMessage(&msg);
         }
-        else
-        {
-            win.CalculationFps();
+        if (msg.message == WM_QUIT)
+            break;
 
-            win.CalculationFrameTime();
+        win.CalculationFps();
 
-            dx.Render();
+        win.CalculationFrameTime();
 
-            win.CalculationSleep();
+        // シミュレーションは固定ティックで進める（フレームレートが変わっても動きは変わらない）
+        // ティックごとに、そのティックの終わりまでに起きた入力だけを反映する
+        CFixedTimestep& timestep = win.GetTimestep();
+        LONGLONG tickEnd;
+        while (timestep.NextTick(tickEnd))
+        {
+            Window::SetFrameTime(timestep.GetTickMs());
+            dx.Update(tickEnd);
         }
+
+        // 描画は最後の2ティックの間を補間する
+        dx.Render(timestep.GetAlpha());
+
+        win.CalculationSleep();
     }
 
+    dx.SetPipelineDepth(0);//描画のスレッドを止める（COM の終了より前に）
+
     CoUninitialize();//COMの終了処理
 
     return (int)msg.wParam;
@@ -69,6 +124,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT uiMessage, WPARAM wParam, LPARAM lParam
     PAINTSTRUCT ps;
     HDC hdc;
 
+    // キーボード等の入力メッセージを入力管理へ渡す
+    CInputManager::GetInstance().HandleMessage(uiMessage, wParam, lParam);
+
     switch (uiMessage)
     {
     case WM_PAINT:
@@ -87,6 +145,61 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT uiMessage, WPARAM wParam, LPARAM lParam
     return 0;
 }
 
+//--------------------------------------------------------------------------------------
+// RunReplay()関数：記録した入力を描画・待機なしで再生する
+//--------------------------------------------------------------------------------------
+// 移動の処理（DirectX11::Update）を実時間の何倍もの速さで回し、回帰の確認と計測に使う
+// 1ティックの時間は記録したフレーム時間になる。最後の円の位置も書くので、結果を比べられる
+// args はコマンドラインの -replay の後ろ（ファイル名、空白を含む場合は "" で囲む）
+static int RunReplay(const wchar_t* args)
+{
+    wchar_t path[MAX_PATH] = {};
+    while (*args == L' ')
+        ++args;
+    wchar_t end = L' ';
+    if (*args == L'"')
+    {
+        end = L'"';
+        ++args;
+    }
+    for (int i = 0; i < MAX_PATH - 1 && args[i] && args[i] != end; ++i)
+        path[i] = args[i];
+
+    DirectX11 dx;
+    dx.SetNullRenderer(true);
+    if (FAILED(dx.InitDevice()))
+        return 1;
+
+    auto& input = CInputManager::GetInstance();
+    if (!input.StartReplay(path))
+    {
+        CSelfTest::Report("replay: cannot open %ls", path);
+        CSelfTest::Flush(L"replay.txt");
+        return 1;
+    }
+
+    DWORD ticks = input.GetReplayFrameCount();
+    double recordedMs = 0.0;
+    double start = CSelfTest::GetTimeUs();
+    while (input.GetReplayPosition() < ticks)
+    {
+        dx.Update(LLONG_MAX);
+        recordedMs += Window::GetFrameTime();
+    }
+    double elapsedUs = CSelfTest::GetTimeUs() - start;
+    input.StopReplay();
+
+    FLOAT x, y;
+    dx.GetPosition(x, y);
+    double seconds = elapsedUs / 1000000.0;
+    CSelfTest::Report("replay: %ls", path);
+    CSelfTest::Report("ticks %lu, recorded %.3f s, elapsed %.3f s", static_cast<unsigned long>(ticks), recordedMs / 1000.0, seconds);
+    CSelfTest::Report("%.0f ticks/s, %.1fx real time", seconds > 0.0 ? ticks / seconds : 0.0, seconds > 0.0 ? recordedMs / 1000.0 / seconds : 0.0);
+    CSelfTest::Report("position %.3f %.3f", x, y);
+    CSelfTest::Flush(L"replay.txt");
+    return 0;
+}
+
 //--------------------------------------------------------------------------------------
 // Window::InitWindow()関数：ウィンドウの表示
 //--------------------------------------------------------------------------------------
@@ -117,6 +230,9 @@ HRESULT Window::InitWindow(HINSTANCE hInstance, int nCmdShow)
     if (!g_hWnd)
         return E_FAIL;
 
+    // マウスは Raw Input で受け取る（登録できなければウィンドウメッセージから求める）
+    CInputManager::GetInstance().RegisterRawMouse(g_hWnd);
+
     ShowWindow(g_hWnd, nCmdShow);
 
     return S_OK;
@@ -129,6 +245,9 @@ void Window::InitFps()
 {
     QueryPerformanceFrequency(&m_freq);
     QueryPerformanceCounter(&m_starttime);//現在の時間を取得（1フレーム目）
+    m_frametime_a = m_starttime;
+    m_pacer.Start();//フレームレート調整の開始
+    m_timestep.Start(m_starttime.QuadPart);//固定ティックの開始
 }
 
 //--------------------------------------------------------------------------------------
@@ -149,42 +268,46 @@ void Window::CalculationFps()
 }
 
 //--------------------------------------------------------------------------------------
-// Window::CalculationSleep()関数：Sleepさせる時間の計算
+// Window::CalculationSleep()関数：次のフレームまで待つ
 //--------------------------------------------------------------------------------------
+// 締め切りの少し前まではタイマーで眠り、残りはスピンして目標のフレームレートに合わせる
+// （目標のフレームレート・間に合わなかったときの扱いは GetFramePacer() から設定）
 void Window::CalculationSleep()
 {
-    QueryPerformanceCounter(&m_nowtime);//現在の時間を取得
-    //Sleepさせる時間ms = 1フレーム目から現在のフレームまでの描画にかかるべき時間ms - 1フレーム目から現在のフレームまで実際にかかった時間ms
-    //                  = (1000ms / 60)*フレーム数 - (現在の時間ms - 1フレーム目の時間ms)
-    DWORD dwSleepTime = static_cast<DWORD>((1000.0 / 60.0) * m_iCount - (m_nowtime.QuadPart - m_starttime.QuadPart) * 1000 / m_freq.QuadPart);
-    if (dwSleepTime > 0 && dwSleepTime < 18)//大きく変動がなければSleepTimeは1～17の間に納まる
-    {
-        timeBeginPeriod(1);
-        Sleep(dwSleepTime);
-        timeEndPeriod(1);
-    }
-    else//大きく変動があった場合
-    {
-        timeBeginPeriod(1);
-        Sleep(1);
-        timeEndPeriod(1);
-    }
+    g_frameStats.BeginPhase(FRAME_SERIES_SLEEP);
+    m_pacer.Wait();
+    g_frameStats.EndPhase();
+}
+
+//--------------------------------------------------------------------------------------
+// Window::GetFramePacer()関数：フレームレート調整の取得
+//--------------------------------------------------------------------------------------
+CFramePacer& Window::GetFramePacer()
+{
+    return m_pacer;
+}
+
+//--------------------------------------------------------------------------------------
+// Window::GetTimestep()関数：シミュレーションの固定ティックの取得
+//--------------------------------------------------------------------------------------
+// ティックの間隔・1フレームで進めるティック数の上限は GetTimestep() から設定
+CFixedTimestep& Window::GetTimestep()
+{
+    return m_timestep;
 }
 
 //--------------------------------------------------------------------------------------
 // Window::CalculationFrameTime()関数：1フレームあたりの時間の計測
 //--------------------------------------------------------------------------------------
+// 間隔と前のフレームの処理ごとの時間は g_frameStats にも記録する
+// 固定ティックにもここまでの時間を溜め、このフレームで進めるティック数を決める
 void Window::CalculationFrameTime()
 {
-    static int iFlg;
-    if (iFlg == 0)
-    {
-        QueryPerformanceCounter(&m_frametime_a);
-        iFlg = 1;
-    }
     QueryPerformanceCounter(&m_frametime_b);
     g_dFrameTime = (m_frametime_b.QuadPart - m_frametime_a.QuadPart) * 1000.0 / m_freq.QuadPart;
     m_frametime_a = m_frametime_b;
+    g_frameStats.BeginFrame(m_frametime_b.QuadPart);
+    m_timestep.Advance(m_frametime_b.QuadPart);
 }
 
 //--------------------------------------------------------------------------------------
@@ -225,4 +348,37 @@ double Window::GetFps()
 double Window::GetFrameTime()
 {
     return g_dFrameTime;
+}
+
+//--------------------------------------------------------------------------------------
+// Window::SetFrameTime()関数：1フレームあたりの時間の上書き（固定ティック・入力の再生時）
+//--------------------------------------------------------------------------------------
+void Window::SetFrameTime(double dFrameTime)
+{
+    g_dFrameTime = dFrameTime;
+}
+
+//--------------------------------------------------------------------------------------
+// Window::BeginFramePhase()関数：フレーム内の処理の計測開始（計測中の処理はそこで終わる）
+//--------------------------------------------------------------------------------------
+void Window::BeginFramePhase(FrameSeries phase)
+{
+    g_frameStats.BeginPhase(phase);
+}
+
+//--------------------------------------------------------------------------------------
+// Window::EndFramePhase()関数：フレーム内の処理の計測終了
+//--------------------------------------------------------------------------------------
+void Window::EndFramePhase()
+{
+    g_frameStats.EndPhase();
+}
+
+//--------------------------------------------------------------------------------------
+// Window::GetFrameStats()関数：フレームの時間の統計の取得
+//--------------------------------------------------------------------------------------
+// p50/p90/p99/p99.9/最大 を直近60フレーム・600フレーム・全体で取得できる
+const CFrameStats& Window::GetFrameStats()
+{
+    return g_frameStats;
 }
\ No newline at end of file
@@ -2,6 +2,9 @@
 
 #include <windows.h>
 #pragma comment(lib,"winmm.lib")
+#include "CFramePacer.h"
+#include "CFixedTimestep.h"
+#include "CFrameStats.h"
 
 //--------------------------------------------------------------------------------------
 // Windowクラス：Window関係
@@ -14,12 +17,18 @@ public:
     void CalculationFps();
     void CalculationSleep();
     void CalculationFrameTime();
+    CFramePacer& GetFramePacer();
+    CFixedTimestep& GetTimestep();
 
     static HWND GethWnd();
     static int GetClientWidth();
     static int GetClientHeight();
     static double GetFps();
     static double GetFrameTime();
+    static void SetFrameTime(double dFrameTime);
+    static void BeginFramePhase(FrameSeries phase);
+    static void EndFramePhase();
+    static const CFrameStats& GetFrameStats();
 private:
     LARGE_INTEGER m_freq = { 0 };
     LARGE_INTEGER m_starttime = { 0 };
@@ -27,10 +36,13 @@ private:
     LARGE_INTEGER m_frametime_a = { 0 };
     LARGE_INTEGER m_frametime_b = { 0 };
     int m_iCount = 0;
+    CFramePacer m_pacer;//フレームレートに合わせて待つ
+    CFixedTimestep m_timestep;//シミュレーションの固定ティック
 
     static HWND g_hWnd;
     static int g_iClientWidth;
     static int g_iClientHeight;
     static double g_dFps;
     static double g_dFrameTime;
+    static CFrameStats g_frameStats;
 };
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+#include <windows.h>
+#include <Xinput.h>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+// ゲームパッドのボタンワード
+// 下位16bit は XINPUT_GAMEPAD::wButtons と同じ
+// 上位はアナログ入力をデジタル化した仮想ボタン（CVirtualButtons の表で押す・離すを決める）
+//------------------------------------------------------------------------------
+const BYTE PAD_TRIGGER_THRESHOLD = 63;          // トリガーを押したとみなす値（これより大きい）
+const DWORD PAD_BIT_LEFT_TRIGGER = 0x10000;     // 左トリガー
+const DWORD PAD_BIT_RIGHT_TRIGGER = 0x20000;    // 右トリガー
+
+// スティックの4方向（軸ごと）
+const DWORD PAD_BIT_LSTICK_LEFT = 0x40000;
+const DWORD PAD_BIT_LSTICK_RIGHT = 0x80000;
+const DWORD PAD_BIT_LSTICK_UP = 0x100000;
+const DWORD PAD_BIT_LSTICK_DOWN = 0x200000;
+const DWORD PAD_BIT_RSTICK_LEFT = 0x400000;
+const DWORD PAD_BIT_RSTICK_RIGHT = 0x800000;
+const DWORD PAD_BIT_RSTICK_UP = 0x1000000;
+const DWORD PAD_BIT_RSTICK_DOWN = 0x2000000;
+
+// 左スティックの8方向（十字キーとして使う、斜めは2つ立つ）
+const DWORD PAD_BIT_LSTICK_DPAD_LEFT = 0x4000000;
+const DWORD PAD_BIT_LSTICK_DPAD_RIGHT = 0x8000000;
+const DWORD PAD_BIT_LSTICK_DPAD_UP = 0x10000000;
+const DWORD PAD_BIT_LSTICK_DPAD_DOWN = 0x20000000;
+
+const DWORD PAD_VIRTUAL_BUTTON_MASK = 0x3FFF0000; // 仮想ボタンのビットすべて
+
+// XINPUT_GAMEPAD からボタンワードを作る
+// 前回の状態を持たないので、トリガーだけを固定のしきい値で判定する
+// （入力の管理では CVirtualButtons で作ったものを使う。記録の差分の基準など、状態なしで求めたいとき用）
+constexpr DWORD MakePadButtons(const XINPUT_GAMEPAD& gamepad)
+{
+    DWORD buttons = gamepad.wButtons;
+    if (gamepad.bLeftTrigger > PAD_TRIGGER_THRESHOLD)
+        buttons |= PAD_BIT_LEFT_TRIGGER;
+    if (gamepad.bRightTrigger > PAD_TRIGGER_THRESHOLD)
+        buttons |= PAD_BIT_RIGHT_TRIGGER;
+    return buttons;
+}
+
+// 2つのゲームパッド状態が同じか（12byte をそのまま比べる）
+inline bool IsSamePadState(const XINPUT_GAMEPAD& a, const XINPUT_GAMEPAD& b)
+{
+    return memcmp(&a, &b, sizeof(XINPUT_GAMEPAD)) == 0;
+}
+
+//------------------------------------------------------------------------------
+// ゲームパッドの方向（テンキー表記）
+//   7 8 9
+//   4 5 6    5 = ニュートラル
+//   1 2 3
+// 十字キーを優先し、押していなければ左スティックを使う
+//------------------------------------------------------------------------------
+const SHORT PAD_DIRECTION_THRESHOLD = 16384;    // スティックをその方向に倒したとみなす値
+
+inline int GetPadDirection(const XINPUT_GAMEPAD& gamepad)
+{
+    int x = 0;
+    int y = 0;
+    if (gamepad.wButtons & (XINPUT_GAMEPAD_DPAD_LEFT | XINPUT_GAMEPAD_DPAD_RIGHT | XINPUT_GAMEPAD_DPAD_UP | XINPUT_GAMEPAD_DPAD_DOWN))
+    {
+        x = ((gamepad.wButtons & XINPUT_GAMEPAD_DPAD_RIGHT) ? 1 : 0) - ((gamepad.wButtons & XINPUT_GAMEPAD_DPAD_LEFT) ? 1 : 0);
+        y = ((gamepad.wButtons & XINPUT_GAMEPAD_DPAD_UP) ? 1 : 0) - ((gamepad.wButtons & XINPUT_GAMEPAD_DPAD_DOWN) ? 1 : 0);
+    }
+    else
+    {
+        x = (gamepad.sThumbLX > PAD_DIRECTION_THRESHOLD) ? 1 : (gamepad.sThumbLX < -PAD_DIRECTION_THRESHOLD) ? -1 : 0;
+        y = (gamepad.sThumbLY > PAD_DIRECTION_THRESHOLD) ? 1 : (gamepad.sThumbLY < -PAD_DIRECTION_THRESHOLD) ? -1 : 0;
+    }
+    return 5 + x + y * 3;
+}